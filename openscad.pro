@@ -250,16 +250,24 @@ HEADERS += src/AST.h \
            src/ModuleInstantiation.h \
            src/Package.h \
            src/Assignment.h \
+           src/VariableSlot.h \
            src/expression.h \
+           src/bytecode.h \
+           src/constantfolding.h \
            src/function.h \
+           src/FunctionCache.h \
            src/module.h \           
            src/UserModule.h \
 
 SOURCES += src/AST.cc \
            src/ModuleInstantiation.cc \
            src/Assignment.cc \
+           src/VariableSlot.cc \
            src/expr.cc \
+           src/bytecode.cc \
+           src/constantfolding.cc \
            src/function.cc \
+           src/FunctionCache.cc \
            src/module.cc \
            src/UserModule.cc \
            src/annotation.cc
@@ -275,6 +283,7 @@ HEADERS += src/version_check.h \
            src/renderer.h \
            src/settings.h \
            src/rendersettings.h \
+           src/ThreadPool.h \
            src/colormap.h \
            src/ThrownTogetherRenderer.h \
            src/CGAL_OGL_Polyhedron.h \
@@ -336,6 +345,7 @@ HEADERS += src/version_check.h \
            src/GeometryUtils.h \
            src/polyset-utils.h \
            src/polyset.h \
+           src/vertex-kernels.h \
            src/printutils.h \
            src/fileutils.h \
            src/value.h \
@@ -345,8 +355,11 @@ HEADERS += src/version_check.h \
            src/state.h \
            src/nodecache.h \
            src/nodedumper.h \
+           src/nodehash.h \
+           src/NodeSimplifier.h \
            src/ModuleCache.h \
            src/GeometryCache.h \
+           src/ShardedCache.h \
            src/GeometryEvaluator.h \
            src/Tree.h \
            src/DrawingCallback.h \
@@ -444,6 +457,7 @@ SOURCES += \
            src/polyset-utils.cc \
            src/GeometryUtils.cc \
            src/polyset.cc \
+           src/vertex-kernels.cc \
            src/csgops.cc \
            src/transform.cc \
            src/color.cc \
@@ -469,6 +483,8 @@ SOURCES += \
            src/RenderStatistic.cc \
            \
            src/nodedumper.cc \
+           src/nodehash.cc \
+           src/NodeSimplifier.cc \
            src/NodeVisitor.cc \
            src/GeometryEvaluator.cc \
            src/ModuleCache.cc \
@@ -480,6 +496,7 @@ SOURCES += \
            \
            src/settings.cc \
            src/rendersettings.cc \
+           src/ThreadPool.cc \
            src/initConfig.cc \
            src/Preferences.cc \
            src/SettingsWriter.cc \
@@ -645,20 +662,29 @@ HEADERS += src/cgal.h \
            src/cgalutils.h \
            src/Reindexer.h \
            src/CGALCache.h \
+           src/DecompositionCache.h \
+           src/DiskCache.h \
+           src/TransformedGeometry.h \
            src/CGALRenderer.h \
            src/CGAL_Nef_polyhedron.h \
            src/cgalworker.h \
+           src/csgworker.h \
            src/Polygon2d-CGAL.h
 
 SOURCES += src/cgalutils.cc \
            src/cgalutils-applyops.cc \
+           src/cgalutils-corefine.cc \
            src/cgalutils-project.cc \
            src/cgalutils-tess.cc \
            src/cgalutils-polyhedron.cc \
            src/CGALCache.cc \
+           src/DecompositionCache.cc \
+           src/DiskCache.cc \
+           src/TransformedGeometry.cc \
            src/CGALRenderer.cc \
            src/CGAL_Nef_polyhedron.cc \
            src/cgalworker.cc \
+           src/csgworker.cc \
            src/Polygon2d-CGAL.cc \
            src/import_nef.cc
 }
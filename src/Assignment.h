@@ -6,16 +6,17 @@
 #include "AST.h"
 #include "memory.h"
 #include "annotation.h"
+#include "VariableSlot.h"
 
 class Assignment :  public ASTNode
 {
 public:
 	Assignment(std::string name, const Location &loc)
-				: ASTNode(loc), name(name) { }
+				: ASTNode(loc), name(name), slot(name) { }
 	Assignment(std::string name,
 						 shared_ptr<class Expression> expr = shared_ptr<class Expression>(),
 						 const Location &loc = Location::NONE)
-		: ASTNode(loc), name(name), expr(expr) { }
+		: ASTNode(loc), name(name), slot(name), expr(expr) { }
 	
 	void print(std::ostream &stream, const std::string &indent) const override;
 
@@ -25,6 +26,7 @@ public:
 
 	// FIXME: Make protected
 	std::string name;
+	const VariableSlot slot;
 	shared_ptr<class Expression> expr;
 protected:
 	AnnotationMap annotations;
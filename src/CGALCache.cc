@@ -2,27 +2,41 @@
 #include "printutils.h"
 #include "CGAL_Nef_polyhedron.h"
 
-CGALCache *CGALCache::inst = nullptr;
-
 CGALCache::CGALCache(size_t limit) : cache(limit)
 {
 }
 
-shared_ptr<const CGAL_Nef_polyhedron> CGALCache::get(const std::string &id) const
+/*!
+	Returns the cached polyhedron, or nullptr if not cached.
+*/
+shared_ptr<const CGAL_Nef_polyhedron> CGALCache::get(const NodeHash &id) const
+{
+	shared_ptr<const CGAL_Nef_polyhedron> N;
+	lookup(id, N);
+	return N;
+}
+
+/*!
+	Looks up and fetches the polyhedron in one step, so it can't be evicted by
+	another thread in between. Returns false if not cached.
+*/
+bool CGALCache::lookup(const NodeHash &id, shared_ptr<const CGAL_Nef_polyhedron> &N) const
 {
-	const auto &N = this->cache[id]->N;
+	cache_entry entry;
+	if (!this->cache.get(id, entry)) return false;
+	N = entry.N;
 #ifdef DEBUG
-	PRINTB("CGAL Cache hit: %s (%d bytes)", id.substr(0, 40) % (N ? N->memsize() : 0));
+	PRINTB("CGAL Cache hit: %s (%d bytes)", id.toString() % (N ? N->memsize() : 0));
 #endif
-	return N;
+	return true;
 }
 
-bool CGALCache::insert(const std::string &id, const shared_ptr<const CGAL_Nef_polyhedron> &N)
+bool CGALCache::insert(const NodeHash &id, const shared_ptr<const CGAL_Nef_polyhedron> &N, double buildtime)
 {
-	auto inserted = this->cache.insert(id, new cache_entry(N), N ? N->memsize() : 0);
+	auto inserted = this->cache.insert(id, new cache_entry(N, print_messages_current()), N ? N->memsize() : 0, buildtime);
 #ifdef DEBUG
-	if (inserted) PRINTB("CGAL Cache insert: %s (%d bytes)", id.substr(0, 40) % (N ? N->memsize() : 0));
-	else PRINTB("CGAL Cache insert failed: %s (%d bytes)", id.substr(0, 40) % (N ? N->memsize() : 0));
+	if (inserted) PRINTB("CGAL Cache insert: %s (%d bytes)", id.toString() % (N ? N->memsize() : 0));
+	else PRINTB("CGAL Cache insert failed: %s (%d bytes)", id.toString() % (N ? N->memsize() : 0));
 #endif
 	return inserted;
 }
@@ -48,8 +62,7 @@ void CGALCache::print()
 	PRINTB("CGAL cache size in bytes: %d", this->cache.totalCost());
 }
 
-CGALCache::cache_entry::cache_entry(const shared_ptr<const CGAL_Nef_polyhedron> &N)
-	: N(N)
+CGALCache::cache_entry::cache_entry(const shared_ptr<const CGAL_Nef_polyhedron> &N, const std::string &msg)
+	: N(N), msg(msg)
 {
-	if (print_messages_stack.size() > 0) this->msg = print_messages_stack.back();
 }
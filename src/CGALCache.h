@@ -1,34 +1,38 @@
 #pragma once
 
-#include "cache.h"
+#include "ShardedCache.h"
 #include "memory.h"
+#include "nodehash.h"
 
 /*!
+	Thread-safe; see ShardedCache.
 */
 class CGALCache
 {
 public:	
 	CGALCache(size_t limit = 100*1024*1024);
 
-	static CGALCache *instance() { if (!inst) inst = new CGALCache; return inst; }
+	static CGALCache *instance() { static CGALCache inst; return &inst; }
 
-	bool contains(const std::string &id) const { return this->cache.contains(id); }
-	shared_ptr<const class CGAL_Nef_polyhedron> get(const std::string &id) const;
-	bool insert(const std::string &id, const shared_ptr<const CGAL_Nef_polyhedron> &N);
+	bool contains(const NodeHash &id) const { return this->cache.contains(id); }
+	shared_ptr<const class CGAL_Nef_polyhedron> get(const NodeHash &id) const;
+	bool lookup(const NodeHash &id, shared_ptr<const CGAL_Nef_polyhedron> &N) const;
+	bool insert(const NodeHash &id, const shared_ptr<const CGAL_Nef_polyhedron> &N, double buildtime = 0);
+	void setEvictionPolicy(CacheEvictionPolicy policy) { this->cache.setEvictionPolicy(policy); }
 	size_t maxSizeMB() const;
 	void setMaxSizeMB(size_t limit);
+	CacheStatistics statistics() const { return this->cache.statistics(); }
 	void clear();
 	void print();
 
 private:
-	static CGALCache *inst;
-
 	struct cache_entry {
 		shared_ptr<const CGAL_Nef_polyhedron> N;
 		std::string msg;
-		cache_entry(const shared_ptr<const CGAL_Nef_polyhedron> &N);
+		cache_entry() { }
+		cache_entry(const shared_ptr<const CGAL_Nef_polyhedron> &N, const std::string &msg);
 		~cache_entry() { }
 	};
 
-	Cache<std::string, cache_entry> cache;
+	ShardedCache<NodeHash, cache_entry> cache;
 };
@@ -121,7 +121,7 @@ void CGALRenderer::draw(bool showfaces, bool showedges) const
 			glDisable(GL_LIGHTING);
 			setColor(ColorMode::CGAL_FACE_2D_COLOR);
 			
-			for (const auto &polygon : polyset->polygons) {
+			for (const auto &polygon : polyset->polygons()) {
 				glBegin(GL_POLYGON);
 				for (const auto &p : polygon) {
 					glVertex3d(p[0], p[1], 0);
@@ -54,6 +54,28 @@ size_t CGAL_Nef_polyhedron::memsize() const
 	return memsize;
 }
 
+/*!
+	Returns a bounding box guaranteed to enclose all vertices. The exact
+	coordinates may not be representable as doubles, so each bound is
+	rounded outwards.
+*/
+BoundingBox CGAL_Nef_polyhedron::getBoundingBox() const
+{
+	BoundingBox result;
+	if (this->isEmpty()) return result;
+
+	CGAL_Nef_polyhedron3::Vertex_const_iterator vi;
+	CGAL_forall_vertices(vi, *this->p3) {
+		const auto &p = vi->point();
+		const auto x = CGAL::to_interval(p.x());
+		const auto y = CGAL::to_interval(p.y());
+		const auto z = CGAL::to_interval(p.z());
+		result.extend(Vector3d(x.first, y.first, z.first));
+		result.extend(Vector3d(x.second, y.second, z.second));
+	}
+	return result;
+}
+
 bool CGAL_Nef_polyhedron::isEmpty() const
 {
 	return !this->p3 || this->p3->is_empty();
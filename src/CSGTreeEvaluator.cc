@@ -12,10 +12,18 @@
 #include "GeometryEvaluator.h"
 #include "polyset.h"
 #include "polyset-utils.h"
+#include "Polygon2d.h"
+#include "Tree.h"
+#include "feature.h"
+#include "progress.h"
+#include "ThreadPool.h"
 
 #include <string>
 #include <map>
 #include <list>
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <assert.h>
 #include <cstddef>
 
@@ -26,9 +34,37 @@
 	with OpenCSG.
 */
 
+namespace {
+	// The nodes whose geometry becomes a CSGLeaf
+	bool isLeaf(const AbstractNode &node)
+	{
+		return dynamic_cast<const AbstractPolyNode *>(&node) ||
+			dynamic_cast<const RenderNode *>(&node) ||
+			dynamic_cast<const CgaladvNode *>(&node);
+	}
+
+	shared_ptr<const Geometry> createLeafGeometry(GeometryEvaluator &evaluator, const AbstractNode &node)
+	{
+		auto geom = evaluator.evaluateGeometry(node, false);
+		// We cannot render Polygon2d directly, so we preprocess (tessellate) it here
+		if (geom && !geom->isEmpty()) {
+			if (auto p2d = dynamic_pointer_cast<const Polygon2d>(geom)) {
+				geom.reset(p2d->tessellate());
+			}
+			// 3D Polysets are tessellated before inserting into Geometry cache, inside GeometryEvaluator::evaluateGeometry
+		}
+		return geom;
+	}
+}
+
 shared_ptr<CSGNode> CSGTreeEvaluator::buildCSGTree(const AbstractNode &node)
 {
+	if (this->geomevaluator && Feature::ExperimentalParallelEvaluation.is_enabled() &&
+			ThreadPool::configuredThreads() > 1) {
+		createLeafGeometriesInParallel(node);
+	}
 	this->traverse(node);
+	this->leafGeometries.clear();
 
 	shared_ptr<CSGNode> t(this->stored_term[node.index()]);
 	if (t) {
@@ -169,21 +205,119 @@ Response CSGTreeEvaluator::visit(State &state, const class ListNode &node)
 
 }
 
-shared_ptr<CSGNode> CSGTreeEvaluator::evaluateCSGNodeFromGeometry(
-	State &state, const shared_ptr<const Geometry> &geom,
-	const ModuleInstantiation *modinst, const AbstractNode &node)
+/*!
+	Creates the geometry of the leaves of the CSG tree below \a root
+	concurrently, so the following traversal only needs to put them
+	together. Leaves with the same geometry are created once; leaves below
+	other leaves are left to the traversal, which finds them cached.
+
+	Tasks don't report progress or print messages themselves; this is done
+	from the calling thread as tasks finish, which also allows cancelling.
+*/
+void CSGTreeEvaluator::createLeafGeometriesInParallel(const AbstractNode &root)
 {
-	// We cannot render Polygon2d directly, so we preprocess (tessellate) it here
-	auto g = geom;
-	if (!g->isEmpty()) {
-		auto p2d = dynamic_pointer_cast<const Polygon2d>(geom);
-		if (p2d) {
-			g.reset(p2d->tessellate());
+	struct Task {
+		const AbstractNode *node;
+		std::vector<int> indices;
+		shared_ptr<const Geometry> geom;
+		std::vector<std::string> messages;
+		std::exception_ptr exception;
+	};
+
+	const Tree &tree = this->geomevaluator->getTree();
+	std::vector<Task> tasks;
+	std::unordered_map<NodeHash, size_t> taskByHash;
+	std::function<void(const AbstractNode &)> collect = [&](const AbstractNode &n) {
+		if (isLeaf(n)) {
+			const auto inserted = taskByHash.emplace(tree.getHash(n), tasks.size());
+			if (inserted.second) tasks.push_back({&n, {}, nullptr, {}, nullptr});
+			tasks[inserted.first->second].indices.push_back(n.index());
+			return;
+		}
+		// Pruned by the traversal
+		if (auto transform = dynamic_cast<const TransformNode *>(&n)) {
+			if (matrix_contains_infinity(transform->matrix) || matrix_contains_nan(transform->matrix)) return;
+		}
+		for (const auto &child : n.getChildren()) collect(*child);
+	};
+	collect(root);
+	if (tasks.size() < 2) return;
+
+	std::mutex donemutex;
+	std::condition_variable donecondition;
+	std::deque<size_t> done;
+	std::atomic<bool> cancelled(false);
+	// Declared last, so it's destroyed first and waits for running tasks before the state they use goes away
+	ThreadPool pool(ThreadPool::configuredThreads());
+
+	for (size_t i = 0; i < tasks.size(); ++i) {
+		pool.enqueue([&, i]() {
+			auto &task = tasks[i];
+			if (!cancelled) {
+				set_print_capture(&task.messages);
+				progress_report_disable(true);
+				try {
+					// Leaves are evaluated without Nef polyhedra, so the worker still returns flattened geometry
+					GeometryEvaluator evaluator(tree);
+					evaluator.setWorker(true);
+					task.geom = createLeafGeometry(evaluator, *task.node);
+				}
+				catch (...) {
+					task.exception = std::current_exception();
+				}
+				progress_report_disable(false);
+				set_print_capture(nullptr);
+			}
+			{
+				std::lock_guard<std::mutex> lock(donemutex);
+				done.push_back(i);
+			}
+			donecondition.notify_one();
+		});
+	}
+
+	PRINTDB("Creating %d CSG leaves on %d threads", tasks.size() % pool.size());
+	for (size_t remaining = tasks.size(); remaining > 0; --remaining) {
+		size_t i;
+		{
+			std::unique_lock<std::mutex> lock(donemutex);
+			donecondition.wait(lock, [&done]() { return !done.empty(); });
+			i = done.front();
+			done.pop_front();
+		}
+		auto &task = tasks[i];
+		try {
+			for (const auto &msg : task.messages) PRINT(msg);
+			if (task.exception) std::rethrow_exception(task.exception);
+			task.node->progress_report();
 		}
-		// 3D Polysets are tessellated before inserting into Geometry cache, inside GeometryEvaluator::evaluateGeometry
+		catch (...) {
+			// Skip tasks not yet started; the pool waits for the running ones
+			cancelled = true;
+			throw;
+		}
+		for (const auto index : task.indices) this->leafGeometries[index] = task.geom;
 	}
+}
 
-	shared_ptr<CSGNode> t(new CSGLeaf(g, state.matrix(), state.color(), STR(node.name() << node.index()), node.index()));
+/*!
+	Returns the geometry of a leaf of the CSG tree, either created in
+	advance or evaluated now.
+*/
+shared_ptr<const Geometry> CSGTreeEvaluator::leafGeometry(const AbstractNode &node)
+{
+	const auto found = this->leafGeometries.find(node.index());
+	if (found == this->leafGeometries.end()) return createLeafGeometry(*this->geomevaluator, node);
+	const auto geom = found->second;
+	this->leafGeometries.erase(found);
+	return geom;
+}
+
+shared_ptr<CSGNode> CSGTreeEvaluator::evaluateCSGNodeFromGeometry(
+	State &state, const shared_ptr<const Geometry> &geom,
+	const ModuleInstantiation *modinst, const AbstractNode &node)
+{
+	shared_ptr<CSGNode> t(new CSGLeaf(geom, state.matrix(), state.color(), STR(node.name() << node.index()), node.index()));
 	if (modinst->isHighlight() || state.isHighlight()) t->setHighlight(true);
 	if (modinst->isBackground() || state.isBackground()) t->setBackground(true);
 	return t;
@@ -194,7 +328,7 @@ Response CSGTreeEvaluator::visit(State &state, const AbstractPolyNode &node)
 	if (state.isPostfix()) {
 		shared_ptr<CSGNode> t1;
 		if (this->geomevaluator) {
-			auto geom = this->geomevaluator->evaluateGeometry(node, false);
+			auto geom = leafGeometry(node);
 			if (geom) {
 				t1 = evaluateCSGNodeFromGeometry(state, geom, node.modinst, node);
 			}
@@ -250,7 +384,7 @@ Response CSGTreeEvaluator::visit(State &state, const RenderNode &node)
 		shared_ptr<CSGNode> t1;
 		shared_ptr<const Geometry> geom;
 		if (this->geomevaluator) {
-			geom = this->geomevaluator->evaluateGeometry(node, false);
+			geom = leafGeometry(node);
 			if (geom) {
 				t1 = evaluateCSGNodeFromGeometry(state, geom, node.modinst, node);
 			}
@@ -269,7 +403,7 @@ Response CSGTreeEvaluator::visit(State &state, const CgaladvNode &node)
     // FIXME: Calling evaluator directly since we're not a PolyNode. Generalize this.
 		shared_ptr<const Geometry> geom;
 		if (this->geomevaluator) {
-			geom = this->geomevaluator->evaluateGeometry(node, false);
+			geom = leafGeometry(node);
 			if (geom) {
 				t1 = evaluateCSGNodeFromGeometry(state, geom, node.modinst, node);
 			}
@@ -3,6 +3,7 @@
 #include <map>
 #include <list>
 #include <vector>
+#include <unordered_map>
 #include <cstddef>
 #include "NodeVisitor.h"
 #include "memory.h"
@@ -45,6 +46,8 @@ private:
 																									const shared_ptr<const class Geometry> &geom,
 																									const class ModuleInstantiation *modinst, 
 																									const AbstractNode &node);
+	shared_ptr<const Geometry> leafGeometry(const AbstractNode &node);
+	void createLeafGeometriesInParallel(const AbstractNode &root);
 	void applyBackgroundAndHighlight(State &state, const AbstractNode &node);
 
 	typedef std::list<const AbstractNode *> ChildList;
@@ -57,4 +60,6 @@ protected:
 	std::vector<shared_ptr<CSGNode>> highlightNodes;
 	std::vector<shared_ptr<CSGNode>> backgroundNodes;
 	std::map<int, shared_ptr<CSGNode>> stored_term; // The term evaluated from each node index
+	// Leaf geometries created in advance by createLeafGeometriesInParallel(), by node index
+	std::unordered_map<int, shared_ptr<const Geometry>> leafGeometries;
 };
@@ -1,8 +1,10 @@
+#include <algorithm>
 #include <stack>
 
 #include "CSGTreeNormalizer.h"
 #include "csgnode.h"
 #include "printutils.h"
+#include "progress.h"
 
 // Helper function to debug normalization bugs
 #if 0
@@ -86,6 +88,7 @@ entrypoint:
 	do {
 		while (node && match_and_replace(node)) {	}
 		this->nodecount++;
+		progress_check();
 		if (nodecount > this->limit) {
 			PRINTB("WARNING: Normalized tree is growing past %d elements. Aborting normalization.\n", this->limit);
 			this->aborted = true;
@@ -101,6 +104,9 @@ cont_left: ;
 cont_right: ;
 	}
 
+	// Normalizing the children may have shrunk them
+	this->nodecount -= std::min(size_t(prune_disjoint_terms(node)), this->nodecount);
+
 	// FIXME: Do we need to take into account any transformation of item here?
 	node = collapse_null_terms(node);
 
@@ -157,8 +163,34 @@ shared_ptr<CSGNode> CSGTreeNormalizer::collapse_null_terms(const shared_ptr<CSGN
 	return node;
 }
 
+/*!
+	Drops subtrahends and intersection operands whose bounding box doesn't
+	overlap that of the positive operand, using the current bounding boxes
+	of the children, which normalization may have made smaller than when
+	the operation was created. Like CSGOperation::createCSGNode() does,
+	but applied while normalizing, so terms which can't contribute aren't
+	expanded by the rewrite rules. Returns the number of non-leaf nodes
+	removed from the tree, i.e. 0 if the term was kept.
+*/
+unsigned int CSGTreeNormalizer::prune_disjoint_terms(shared_ptr<CSGNode> &node)
+{
+	shared_ptr<CSGOperation> op = dynamic_pointer_cast<CSGOperation>(node);
+	if (!op) return 0;
+	op->initBoundingBox();
+	if (op->getType() == OpenSCADOperator::UNION || !op->left() || !op->right()) return 0;
+	if (!op->left()->getBoundingBox().intersection(op->right()->getBoundingBox()).isEmpty()) return 0;
+
+	if (op->getType() == OpenSCADOperator::DIFFERENCE) {
+		node = op->left();
+		return 1 + count(op->right());
+	}
+	node.reset();
+	return count(op);
+}
+
 bool CSGTreeNormalizer::match_and_replace(shared_ptr<CSGNode> &node)
 {
+	if (prune_disjoint_terms(node) > 0) return true;
 	shared_ptr<CSGOperation> op = dynamic_pointer_cast<CSGOperation>(node);
 	if (!op) return false;
 	if (op->getType() == OpenSCADOperator::UNION) return false;
@@ -13,6 +13,7 @@ public:
 private:
 	shared_ptr<CSGNode> normalizePass(shared_ptr<CSGNode> term) ;
 	bool match_and_replace(shared_ptr<class CSGNode> &term);
+	unsigned int prune_disjoint_terms(shared_ptr<CSGNode> &term);
 	shared_ptr<CSGNode> collapse_null_terms(const shared_ptr<CSGNode> &term);
 	shared_ptr<CSGNode> cleanup_term(shared_ptr<CSGNode> &t);
 	unsigned int count(const shared_ptr<CSGNode> &term) const;
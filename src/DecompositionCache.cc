@@ -0,0 +1,73 @@
+#include "DecompositionCache.h"
+#include "printutils.h"
+
+static size_t memsize(const DecompositionCache::ConvexParts &parts)
+{
+	size_t mem = sizeof(parts) + parts.size() * sizeof(DecompositionCache::ConvexParts::value_type);
+	for (const auto &part : parts) mem += part.size() * sizeof(Vector3d);
+	return mem;
+}
+
+DecompositionCache::DecompositionCache(size_t limit) : cache(limit)
+{
+}
+
+bool DecompositionCache::contains(const NodeHash &id) const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->cache.contains(id);
+}
+
+shared_ptr<const DecompositionCache::ConvexParts> DecompositionCache::get(const NodeHash &id) const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	const auto entry = this->cache[id];
+	if (!entry) return nullptr;
+	const auto &parts = entry->parts;
+#ifdef DEBUG
+	PRINTB("Decomposition Cache hit: %s (%d parts)", id.toString() % parts->size());
+#endif
+	return parts;
+}
+
+bool DecompositionCache::insert(const NodeHash &id, const shared_ptr<const ConvexParts> &parts)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	auto inserted = this->cache.insert(id, new cache_entry(parts), memsize(*parts));
+#ifdef DEBUG
+	if (inserted) PRINTB("Decomposition Cache insert: %s (%d parts)", id.toString() % parts->size());
+	else PRINTB("Decomposition Cache insert failed: %s (%d parts)", id.toString() % parts->size());
+#endif
+	return inserted;
+}
+
+size_t DecompositionCache::maxSizeMB() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->cache.maxCost()/(1024*1024);
+}
+
+void DecompositionCache::setMaxSizeMB(size_t limit)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->cache.setMaxCost(limit*1024*1024);
+}
+
+void DecompositionCache::clear()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	cache.clear();
+}
+
+CacheStatistics DecompositionCache::statistics() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->cache.statistics();
+}
+
+void DecompositionCache::print()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	PRINTB("Convex decompositions in cache: %d", this->cache.size());
+	PRINTB("Convex decomposition cache size in bytes: %d", this->cache.totalCost());
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "cache.h"
+#include "memory.h"
+#include "nodehash.h"
+#include "linalg.h"
+#include <mutex>
+#include <vector>
+
+/*!
+	Caches the convex parts minkowski() decomposes its operands into, keyed
+	by the operand's NodeHash, so an operand shared by several minkowski()
+	operations is only decomposed once. Each part is stored as the point
+	cloud of its vertices.
+
+	Thread-safe, since minkowski() may run in parallel evaluation tasks.
+*/
+class DecompositionCache
+{
+public:
+	typedef std::vector<std::vector<Vector3d>> ConvexParts;
+
+	DecompositionCache(size_t limit = 100*1024*1024);
+
+	// Function local static, since the first use may be from concurrent threads
+	static DecompositionCache *instance() { static DecompositionCache inst; return &inst; }
+
+	bool contains(const NodeHash &id) const;
+	// Returns nullptr if not cached
+	shared_ptr<const ConvexParts> get(const NodeHash &id) const;
+	bool insert(const NodeHash &id, const shared_ptr<const ConvexParts> &parts);
+	size_t maxSizeMB() const;
+	void setMaxSizeMB(size_t limit);
+	CacheStatistics statistics() const;
+	void clear();
+	void print();
+
+private:
+	struct cache_entry {
+		shared_ptr<const ConvexParts> parts;
+		cache_entry(const shared_ptr<const ConvexParts> &parts) : parts(parts) { }
+		~cache_entry() { }
+	};
+
+	Cache<NodeHash, cache_entry> cache;
+	mutable std::mutex mutex;
+};
@@ -0,0 +1,343 @@
+#include "DiskCache.h"
+#include "printutils.h"
+#include "polyset.h"
+#include "Polygon2d.h"
+#include "CGAL_Nef_polyhedron.h"
+#include "feature.h"
+#include "version.h"
+#include "cgal.h"
+#pragma push_macro("NDEBUG")
+#undef NDEBUG
+#include <CGAL/IO/Nef_polyhedron_iostream_3.h>
+#pragma pop_macro("NDEBUG")
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+namespace fs = boost::filesystem;
+
+DiskCache *DiskCache::inst = nullptr;
+
+namespace {
+	const char *const MAGIC = "OpenSCAD-geometry-cache 1";
+	const char *const SUFFIX = ".geom";
+	const char *const TMP_SUFFIX = ".tmp";
+	// Temporary files older than this are left over from crashed processes
+	const std::time_t TMP_MAX_AGE = 60*60;
+	// Features that change the geometry evaluated for the same subtree
+	const Feature *const KEY_FEATURES[] = {
+		&Feature::ExperimentalLazyUnion, &Feature::ExperimentalDisjointUnion, &Feature::ExperimentalCorefinement
+	};
+
+	/*
+		Everything besides the subtree which determines a cached geometry. It is
+		checked at every access, as features may be toggled from the GUI.
+	*/
+	std::string keySalt()
+	{
+		std::string salt = std::string(MAGIC) + "\n" + openscad_versionnumber;
+		for (const auto feature : KEY_FEATURES) {
+			if (feature->is_enabled()) salt += "\n" + feature->get_name();
+		}
+		return salt;
+	}
+
+	int fromTribool(boost::tribool b)
+	{
+		if (b) return 1;
+		if (!b) return 0;
+		return 2;
+	}
+
+	boost::tribool toTribool(int i)
+	{
+		if (i == 0) return false;
+		if (i == 1) return true;
+		return boost::indeterminate;
+	}
+
+	bool writeGeometry(std::ostream &out, const Geometry &geom)
+	{
+		out << std::setprecision(std::numeric_limits<double>::max_digits10);
+		if (const auto ps = dynamic_cast<const PolySet *>(&geom)) {
+			// 2D PolySets keep their originating Polygon2d, which we don't store
+			if (ps->getDimension() != 3) return false;
+			out << "PolySet " << ps->getConvexity() << " " << fromTribool(ps->convexValue()) << "\n";
+			out << ps->polygons().size() << "\n";
+			for (const auto &p : ps->polygons()) {
+				out << p.size();
+				for (const auto &v : p) out << " " << v[0] << " " << v[1] << " " << v[2];
+				out << "\n";
+			}
+		}
+		else if (const auto poly = dynamic_cast<const Polygon2d *>(&geom)) {
+			out << "Polygon2d " << poly->getConvexity() << " " << poly->isSanitized() << "\n";
+			out << poly->outlines().size() << "\n";
+			for (const auto &o : poly->outlines()) {
+				out << o.positive << " " << o.vertices.size();
+				for (const auto &v : o.vertices) out << " " << v[0] << " " << v[1];
+				out << "\n";
+			}
+		}
+		else if (const auto N = dynamic_cast<const CGAL_Nef_polyhedron *>(&geom)) {
+			out << "Nef " << N->getConvexity() << " " << (N->p3 ? 1 : 0) << "\n";
+			if (N->p3) out << *N->p3;
+		}
+		else {
+			return false;
+		}
+		out << "\nend\n";
+		return out.good();
+	}
+
+	Geometry *readGeometry(std::istream &in)
+	{
+		std::string type, end;
+		int convexity;
+		in >> type >> convexity;
+		if (!in) return nullptr;
+
+		if (type == "PolySet") {
+			int convex;
+			size_t numpolygons;
+			in >> convex >> numpolygons;
+			if (!in) return nullptr;
+			std::unique_ptr<PolySet> ps(new PolySet(3, toTribool(convex)));
+			// The counts come from the file, so nothing is reserved from them
+			ps->setConvexity(convexity);
+			for (size_t i = 0; i < numpolygons && in; ++i) {
+				size_t numvertices;
+				in >> numvertices;
+				ps->append_poly();
+				for (size_t j = 0; j < numvertices && in; ++j) {
+					double x, y, z;
+					in >> x >> y >> z;
+					ps->append_vertex(x, y, z);
+				}
+			}
+			in >> end;
+			if (!in || end != "end") return nullptr;
+			// Vertices are stored once per polygon
+			ps->mergeVertices();
+			return ps.release();
+		}
+		else if (type == "Polygon2d") {
+			bool sanitized;
+			size_t numoutlines;
+			in >> sanitized >> numoutlines;
+			if (!in) return nullptr;
+			std::unique_ptr<Polygon2d> poly(new Polygon2d);
+			poly->setConvexity(convexity);
+			poly->setSanitized(sanitized);
+			for (size_t i = 0; i < numoutlines && in; ++i) {
+				Outline2d outline;
+				size_t numvertices;
+				in >> outline.positive >> numvertices;
+				for (size_t j = 0; j < numvertices && in; ++j) {
+					double x, y;
+					in >> x >> y;
+					outline.vertices.push_back(Vector2d(x, y));
+				}
+				poly->addOutline(outline);
+			}
+			in >> end;
+			if (!in || end != "end") return nullptr;
+			return poly.release();
+		}
+		else if (type == "Nef") {
+			int hasp3;
+			in >> hasp3;
+			if (!in) return nullptr;
+			std::unique_ptr<CGAL_Nef_polyhedron> N(new CGAL_Nef_polyhedron);
+			N->setConvexity(convexity);
+			if (hasp3) {
+				CGAL::Failure_behaviour old_behaviour = CGAL::set_error_behaviour(CGAL::THROW_EXCEPTION);
+				try {
+					N->p3.reset(new CGAL_Nef_polyhedron3);
+					in >> *N->p3;
+				}
+				catch (const CGAL::Failure_exception &e) {
+					in.setstate(std::ios::failbit);
+				}
+				CGAL::set_error_behaviour(old_behaviour);
+			}
+			in >> end;
+			if (!in || end != "end") return nullptr;
+			return N.release();
+		}
+		return nullptr;
+	}
+
+	std::string uniqueSuffix()
+	{
+		thread_local std::mt19937_64 rng{std::random_device{}()};
+		std::ostringstream s;
+		s << std::hex << rng();
+		return s.str();
+	}
+}
+
+/*!
+	Enables the cache, using the given directory which will be created if
+	necessary. An empty path disables the cache.
+*/
+bool DiskCache::setDirectory(const std::string &path)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->directory.clear();
+	this->sizeknown = false;
+	if (path.empty()) return true;
+
+	boost::system::error_code ec;
+	fs::create_directories(path, ec);
+	if (!fs::is_directory(path, ec)) {
+		PRINTB("WARNING: Can't use '%s' as cache directory, disk cache disabled", path);
+		return false;
+	}
+	this->directory = path;
+	return true;
+}
+
+/*!
+	Files are named by the node hash salted with the cache format, OpenSCAD
+	version and enabled features, so a shared directory never returns
+	geometry computed differently.
+*/
+std::string DiskCache::filename(const NodeHash &id) const
+{
+	const auto key = keySalt() + "\n" + id.toString();
+	const auto hash = NodeHash::compute(key.data(), key.size());
+	return (fs::path(this->directory) / (hash.toString() + SUFFIX)).string();
+}
+
+/*!
+	Returns the cached geometry, or nullptr if not cached or the cache file
+	can't be read. Unreadable files are removed.
+*/
+shared_ptr<const Geometry> DiskCache::get(const NodeHash &id)
+{
+	if (!isEnabled()) return nullptr;
+	const auto file = filename(id);
+	std::ifstream in(file, std::ios::in | std::ios::binary);
+	if (!in.good()) {
+		this->misses++;
+		return nullptr;
+	}
+
+	shared_ptr<const Geometry> geom;
+	std::string magic;
+	std::getline(in, magic);
+	// Corrupt files may e.g. make allocations fail, which is handled like any unreadable file
+	try {
+		if (magic == MAGIC) geom.reset(readGeometry(in));
+	}
+	catch (...) {
+		geom.reset();
+	}
+	in.close();
+
+	boost::system::error_code ec;
+	if (!geom) {
+		PRINTB("WARNING: Removing unreadable disk cache file '%s'", file);
+		fs::remove(file, ec);
+		this->misses++;
+		return nullptr;
+	}
+	// Mark as recently used
+	fs::last_write_time(file, std::time(nullptr), ec);
+	this->hits++;
+	PRINTDB("Disk cache hit: %s", id.toString());
+	return geom;
+}
+
+/*!
+	Writes the geometry to the cache directory. Returns false if the geometry
+	type isn't supported or the file couldn't be written.
+*/
+bool DiskCache::insert(const NodeHash &id, const shared_ptr<const Geometry> &geom)
+{
+	if (!isEnabled() || !geom) return false;
+
+	const auto file = filename(id);
+	const auto tmpfile = file + TMP_SUFFIX + uniqueSuffix();
+	boost::system::error_code ec;
+	{
+		std::ofstream out(tmpfile, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!out.good() || !(out << MAGIC << "\n") || !writeGeometry(out, *geom)) {
+			out.close();
+			fs::remove(tmpfile, ec);
+			return false;
+		}
+	}
+	// rename() is atomic, so other processes see either no file or a complete one.
+	// If another process won the race, its file has the same contents.
+	const auto size = fs::file_size(tmpfile, ec);
+	fs::rename(tmpfile, file, ec);
+	if (ec) {
+		fs::remove(tmpfile, ec);
+		return false;
+	}
+	PRINTDB("Disk cache insert: %s (%d bytes)", id.toString() % size);
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	if (this->sizeknown) this->totalsize += size;
+	if (!this->sizeknown || this->totalsize > this->maxsize) trim();
+	return true;
+}
+
+/*!
+	Rescans the directory, which may have been changed by other processes, and
+	removes the least recently used files until it fits into the size limit.
+*/
+void DiskCache::trim()
+{
+	struct Entry {
+		fs::path path;
+		std::time_t time;
+		uintmax_t size;
+	};
+	std::vector<Entry> entries;
+	size_t total = 0;
+	const std::time_t now = std::time(nullptr);
+
+	boost::system::error_code ec;
+	for (fs::directory_iterator it(this->directory, ec), end; !ec && it != end; it.increment(ec)) {
+		const auto &path = it->path();
+		const auto name = path.filename().string();
+		const auto time = fs::last_write_time(path, ec);
+		if (ec) continue;
+		if (name.find(TMP_SUFFIX) != std::string::npos) {
+			if (now - time > TMP_MAX_AGE) fs::remove(path, ec);
+			continue;
+		}
+		if (path.extension() != SUFFIX) continue;
+		const auto size = fs::file_size(path, ec);
+		if (ec) continue;
+		entries.push_back({path, time, size});
+		total += size;
+	}
+
+	if (total > this->maxsize) {
+		std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.time < b.time; });
+		for (const auto &entry : entries) {
+			if (total <= this->maxsize) break;
+			// Another process may already have removed it, that's fine
+			fs::remove(entry.path, ec);
+			total -= entry.size;
+		}
+	}
+	this->totalsize = total;
+	this->sizeknown = true;
+}
+
+void DiskCache::print()
+{
+	if (!isEnabled()) return;
+	PRINTB("Disk cache hits: %d, misses: %d", this->hits.load() % this->misses.load());
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include "memory.h"
+#include "nodehash.h"
+
+class Geometry;
+
+/*!
+	A second tier behind GeometryCache and CGALCache which keeps geometries
+	on disk, so they survive the process and can be shared by several
+	OpenSCAD processes using the same directory.
+
+	Each geometry is stored in its own file named by the NodeHash of its
+	subtree, salted with the cache format, OpenSCAD version and the features
+	affecting evaluation. Files are written to a temporary name first and then renamed,
+	so readers never see partial files. The least recently used files are
+	deleted once the directory grows beyond the size limit; a file's
+	modification time serves as its last use time.
+
+	Disabled until a directory is set. get() and insert() may be called from
+	several threads; the directory and size limit must be configured before.
+*/
+class DiskCache
+{
+public:
+	DiskCache() : maxsize(1024*1024*1024), totalsize(0), sizeknown(false), hits(0), misses(0) {}
+
+	static DiskCache *instance() { if (!inst) inst = new DiskCache; return inst; }
+
+	bool isEnabled() const { return !this->directory.empty(); }
+	bool setDirectory(const std::string &path);
+	size_t maxSizeMB() const { return this->maxsize/(1024*1024); }
+	void setMaxSizeMB(size_t limit) { this->maxsize = limit*1024*1024; }
+
+	shared_ptr<const Geometry> get(const NodeHash &id);
+	bool insert(const NodeHash &id, const shared_ptr<const Geometry> &geom);
+	void print();
+	size_t numHits() const { return this->hits; }
+	size_t numMisses() const { return this->misses; }
+
+private:
+	static DiskCache *inst;
+
+	std::string filename(const NodeHash &id) const;
+	// Must be called with mutex held
+	void trim();
+
+	std::string directory;
+	size_t maxsize;
+	// Size of the cache directory as last seen by this process
+	size_t totalsize;
+	bool sizeknown;
+	// Protects totalsize and sizeknown, and serializes trimming
+	std::mutex mutex;
+	std::atomic<size_t> hits, misses;
+};
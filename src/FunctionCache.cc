@@ -0,0 +1,247 @@
+#include "FunctionCache.h"
+#include "function.h"
+#include "context.h"
+#include "printutils.h"
+#include <algorithm>
+#include <cstring>
+#include <boost/functional/hash.hpp>
+
+namespace {
+	uint64_t bits(double d)
+	{
+		uint64_t b;
+		std::memcpy(&b, &d, sizeof(b));
+		return b;
+	}
+
+	void hash_combine_type(size_t &seed, Value::ValueType type)
+	{
+		boost::hash_combine(seed, static_cast<int>(type));
+	}
+
+	// Hashes numbers like a boxed vector of them, so dense and boxed vectors hash alike
+	void hash_combine_numbers(size_t &seed, const double *numbers, size_t count)
+	{
+		hash_combine_type(seed, Value::ValueType::VECTOR);
+		boost::hash_combine(seed, count);
+		for (size_t i = 0; i < count; i++) {
+			hash_combine_type(seed, Value::ValueType::NUMBER);
+			boost::hash_combine(seed, bits(numbers[i]));
+		}
+	}
+
+	void hash_combine_value(size_t &seed, const Value &value)
+	{
+		const auto type = value.type();
+		if (type == Value::ValueType::VECTOR) {
+			if (const DenseVectorType *dense = value.toDense()) {
+				if (!dense->columns()) {
+					hash_combine_numbers(seed, dense->data(), dense->size());
+					return;
+				}
+				hash_combine_type(seed, type);
+				boost::hash_combine(seed, dense->size());
+				for (size_t i = 0; i < dense->size(); i++) {
+					hash_combine_numbers(seed, dense->data() + i * dense->columns(), dense->columns());
+				}
+				return;
+			}
+			const auto &vec = value.toVector();
+			hash_combine_type(seed, type);
+			boost::hash_combine(seed, vec.size());
+			for (const auto &element : vec) hash_combine_value(seed, *element);
+			return;
+		}
+		hash_combine_type(seed, type);
+		switch (type) {
+		case Value::ValueType::BOOL:
+			boost::hash_combine(seed, value.toBool());
+			break;
+		case Value::ValueType::NUMBER:
+			boost::hash_combine(seed, bits(value.toDouble()));
+			break;
+		case Value::ValueType::STRING:
+			boost::hash_combine(seed, value.toString());
+			break;
+		case Value::ValueType::RANGE: {
+			auto range = value.toRange();
+			boost::hash_combine(seed, bits(range.begin_value()));
+			boost::hash_combine(seed, bits(range.step_value()));
+			boost::hash_combine(seed, bits(range.end_value()));
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	bool identical(const Value &v1, const Value &v2)
+	{
+		const auto type = v1.type();
+		if (type != v2.type()) return false;
+		switch (type) {
+		case Value::ValueType::UNDEFINED:
+			return true;
+		case Value::ValueType::BOOL:
+			return v1.toBool() == v2.toBool();
+		case Value::ValueType::NUMBER:
+			return bits(v1.toDouble()) == bits(v2.toDouble());
+		case Value::ValueType::STRING:
+			return v1.toString() == v2.toString();
+		case Value::ValueType::RANGE: {
+			auto r1 = v1.toRange(), r2 = v2.toRange();
+			return bits(r1.begin_value()) == bits(r2.begin_value()) &&
+				bits(r1.step_value()) == bits(r2.step_value()) &&
+				bits(r1.end_value()) == bits(r2.end_value());
+		}
+		case Value::ValueType::VECTOR: {
+			const DenseVectorType *dense1 = v1.toDense();
+			const DenseVectorType *dense2 = v2.toDense();
+			if (dense1 && dense2 && dense1->columns() == dense2->columns()) {
+				return dense1->size() == dense2->size() &&
+					std::memcmp(dense1->data(), dense2->data(), dense1->dataSize() * sizeof(double)) == 0;
+			}
+			const auto &vec1 = v1.toVector();
+			const auto &vec2 = v2.toVector();
+			return vec1.size() == vec2.size() &&
+				std::equal(vec1.begin(), vec1.end(), vec2.begin(), [](const ValuePtr &e1, const ValuePtr &e2) {
+					return e1 == e2 || identical(*e1, *e2);
+				});
+		}
+		default:
+			// Function values aren't used as keys
+			return false;
+		}
+	}
+
+	size_t memsize(const Value &value)
+	{
+		size_t mem = sizeof(Value);
+		if (value.type() == Value::ValueType::STRING) {
+			mem += value.toString().size();
+		}
+		else if (value.type() == Value::ValueType::VECTOR) {
+			if (const DenseVectorType *dense = value.toDense()) mem += dense->dataSize() * sizeof(double);
+			else for (const auto &element : value.toVector()) mem += sizeof(ValuePtr) + memsize(*element);
+		}
+		return mem;
+	}
+
+	size_t memsize(const FunctionCallKey &key)
+	{
+		size_t mem = sizeof(key);
+		for (const auto &arg : key.arguments) mem += sizeof(ValuePtr) + memsize(*arg);
+		return mem;
+	}
+}
+
+FunctionCallKey::FunctionCallKey(const UserFunction *function, std::vector<ValuePtr> &&arguments)
+	: function(function), arguments(std::move(arguments)), hash(0)
+{
+	boost::hash_combine(this->hash, function);
+	for (const auto &arg : this->arguments) hash_combine_value(this->hash, *arg);
+}
+
+bool FunctionCallKey::operator==(const FunctionCallKey &other) const
+{
+	return this->function == other.function && this->hash == other.hash &&
+		this->arguments.size() == other.arguments.size() &&
+		std::equal(this->arguments.begin(), this->arguments.end(), other.arguments.begin(), [](const ValuePtr &a1, const ValuePtr &a2) {
+			return a1 == a2 || identical(*a1, *a2);
+		});
+}
+
+thread_local FunctionCache::Frame *FunctionCache::frame = nullptr;
+
+FunctionCache::Frame::Frame(const Context *context)
+	: context(context), pure(true), messages(print_message_count()), outer(FunctionCache::frame)
+{
+	FunctionCache::frame = this;
+}
+
+FunctionCache::Frame::~Frame()
+{
+	FunctionCache::frame = this->outer;
+	if (this->outer && !isPure()) this->outer->pure = false;
+}
+
+bool FunctionCache::Frame::isPure() const
+{
+	return this->pure && print_message_count() == this->messages;
+}
+
+void FunctionCache::checkLookup(const Context *context)
+{
+	// Variables of the call are found in its context or the ones nested in it
+	for (const Context *c = context; c; c = c->parent.get()) {
+		if (c == frame->context) return;
+	}
+	frame->pure = false;
+}
+
+FunctionCache::FunctionCache(size_t limit) : cache(limit)
+{
+}
+
+ValuePtr FunctionCache::evaluate(const UserFunction &function, const std::shared_ptr<Context> &context)
+{
+	bool cacheable = true;
+	std::vector<ValuePtr> arguments;
+	arguments.reserve(function.definition_arguments.size());
+	for (const auto &arg : function.definition_arguments) {
+		const auto &values = arg->slot.isConfigVariable() ? context->config_variables : context->variables;
+		const ValuePtr *value = values.find(arg->slot);
+		// Function values capture their context, so calls taking them aren't cached
+		if (!value || (*value)->type() == Value::ValueType::FUNCTION) cacheable = false;
+		else arguments.push_back(*value);
+	}
+
+	const FunctionCallKey key(&function, std::move(arguments));
+	if (cacheable) {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (const auto entry = this->cache[key]) return entry->result;
+	}
+
+	// The call is tracked even if it isn't cached, so only its own
+	// impurity makes the calls it is part of impure
+	Frame call(context.get());
+	const ValuePtr result = function.evaluateBody(context);
+	if (cacheable && call.isPure() && result->type() != Value::ValueType::FUNCTION) {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->cache.insert(key, new cache_entry(result), memsize(key) + memsize(*result));
+	}
+	return result;
+}
+
+size_t FunctionCache::maxSizeMB() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->cache.maxCost()/(1024*1024);
+}
+
+void FunctionCache::setMaxSizeMB(size_t limit)
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->cache.setMaxCost(limit*1024*1024);
+}
+
+void FunctionCache::clear()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	cache.clear();
+}
+
+CacheStatistics FunctionCache::statistics() const
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->cache.statistics();
+}
+
+void FunctionCache::print()
+{
+	std::lock_guard<std::mutex> lock(this->mutex);
+	const auto stats = this->cache.statistics();
+	PRINTB("Function results in cache: %d", this->cache.size());
+	PRINTB("Function cache size in bytes: %d", this->cache.totalCost());
+	PRINTB("Function cache hits: %d of %d calls", stats.hits % (stats.hits + stats.misses));
+}
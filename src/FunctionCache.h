@@ -0,0 +1,91 @@
+#pragma once
+
+#include "cache.h"
+#include "value.h"
+#include "memory.h"
+#include <mutex>
+#include <vector>
+
+/*!
+	Identifies a call of a user function by the function and the values
+	its parameters were bound to. Values compare structurally, numbers by
+	their bits, so e.g. 0 and -0 are different arguments.
+*/
+struct FunctionCallKey
+{
+	FunctionCallKey(const class UserFunction *function, std::vector<ValuePtr> &&arguments);
+
+	bool operator==(const FunctionCallKey &other) const;
+
+	const UserFunction *function;
+	std::vector<ValuePtr> arguments;
+	size_t hash;
+};
+
+namespace std {
+	template<> struct hash<FunctionCallKey> {
+		size_t operator()(const FunctionCallKey &key) const { return key.hash; }
+	};
+}
+
+/*!
+	Caches the results of user function calls, so functions called again
+	with the same arguments, like the recursive steps of bezier or spline
+	sampling, are only evaluated once. Only used with the "function-cache"
+	experimental feature enabled.
+
+	Whether a result can be reused is tracked while the call is evaluated:
+	it can't if the call reads special variables, variables from outside
+	the function, calls rands() or parent_module(), or prints a message
+	(e.g. from echo(), a warning or a failed assert()). Impure nested calls
+	make the calls they are part of impure too.
+
+	Function identities are only valid for one evaluation of the design,
+	so the cache is cleared before each one.
+*/
+class FunctionCache
+{
+public:
+	FunctionCache(size_t limit = 100*1024*1024);
+
+	// Function local static, since the first use may be from concurrent threads
+	static FunctionCache *instance() { static FunctionCache inst; return &inst; }
+
+	// Evaluates function with its parameters bound in context, or returns the cached result
+	ValuePtr evaluate(const class UserFunction &function, const std::shared_ptr<class Context> &context);
+
+	// Makes the calls in progress in the calling thread uncacheable
+	static void markImpure() { if (frame) frame->pure = false; }
+	// Called with the context a variable was found in, to check it belongs to the call
+	static void noteLookup(const Context *context) { if (frame && frame->pure) checkLookup(context); }
+
+	size_t maxSizeMB() const;
+	void setMaxSizeMB(size_t limit);
+	CacheStatistics statistics() const;
+	void clear();
+	void print();
+
+private:
+	// A call being evaluated by the calling thread
+	struct Frame {
+		Frame(const Context *context);
+		~Frame();
+		bool isPure() const;
+
+		const Context *context;
+		bool pure;
+		size_t messages;
+		Frame *outer;
+	};
+	static thread_local Frame *frame;
+	static void checkLookup(const Context *context);
+
+	struct cache_entry {
+		ValuePtr result;
+		cache_entry(const ValuePtr &result) : result(result) { }
+		~cache_entry() { }
+	};
+
+	Cache<FunctionCallKey, cache_entry> cache;
+	mutable std::mutex mutex;
+};
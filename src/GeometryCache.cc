@@ -8,26 +8,40 @@
   #include "CGAL_Nef_polyhedron.h"
 #endif
 
-GeometryCache *GeometryCache::inst = nullptr;
+/*!
+	Returns the cached geometry, or nullptr if not cached.
+*/
+shared_ptr<const Geometry> GeometryCache::get(const NodeHash &id) const
+{
+	shared_ptr<const Geometry> geom;
+	lookup(id, geom);
+	return geom;
+}
 
-shared_ptr<const Geometry> GeometryCache::get(const std::string &id) const
+/*!
+	Looks up and fetches the geometry in one step, so it can't be evicted by
+	another thread in between. Returns false if not cached.
+*/
+bool GeometryCache::lookup(const NodeHash &id, shared_ptr<const Geometry> &geom) const
 {
-	const auto &geom = this->cache[id]->geom;
+	cache_entry entry;
+	if (!this->cache.get(id, entry)) return false;
+	geom = entry.geom;
 #ifdef DEBUG
-	PRINTDB("Geometry Cache hit: %s (%d bytes)", id.substr(0, 40) % (geom ? geom->memsize() : 0));
+	PRINTDB("Geometry Cache hit: %s (%d bytes)", id.toString() % (geom ? geom->memsize() : 0));
 #endif
-	return geom;
+	return true;
 }
 
-bool GeometryCache::insert(const std::string &id, const shared_ptr<const Geometry> &geom)
+bool GeometryCache::insert(const NodeHash &id, const shared_ptr<const Geometry> &geom, double buildtime)
 {
-	auto inserted = this->cache.insert(id, new cache_entry(geom), geom ? geom->memsize() : 0);
+	auto inserted = this->cache.insert(id, new cache_entry(geom, print_messages_current()), geom ? geom->memsize() : 0, buildtime);
 #ifdef DEBUG
 	assert(!dynamic_cast<const CGAL_Nef_polyhedron*>(geom.get()));
 	if (inserted) PRINTDB("Geometry Cache insert: %s (%d bytes)",
-                         id.substr(0, 40) % (geom ? geom->memsize() : 0));
+                         id.toString() % (geom ? geom->memsize() : 0));
 	else PRINTDB("Geometry Cache insert failed: %s (%d bytes)",
-                id.substr(0, 40) % (geom ? geom->memsize() : 0));
+                id.toString() % (geom ? geom->memsize() : 0));
 #endif
 	return inserted;
 }
@@ -48,8 +62,7 @@ void GeometryCache::print()
 	PRINTB("Geometry cache size in bytes: %d", this->cache.totalCost());
 }
 
-GeometryCache::cache_entry::cache_entry(const shared_ptr<const Geometry> &geom)
-	: geom(geom)
+GeometryCache::cache_entry::cache_entry(const shared_ptr<const Geometry> &geom, const std::string &msg)
+	: geom(geom), msg(msg)
 {
-	if (print_messages_stack.size() > 0) this->msg = print_messages_stack.back();
 }
@@ -1,33 +1,39 @@
 #pragma once
 
-#include "cache.h"
+#include "ShardedCache.h"
 #include "memory.h"
+#include "nodehash.h"
 #include "Geometry.h"
 
+/*!
+	Thread-safe; see ShardedCache.
+*/
 class GeometryCache
 {
 public:	
 	GeometryCache(size_t memorylimit = 100*1024*1024) : cache(memorylimit) {}
 
-	static GeometryCache *instance() { if (!inst) inst = new GeometryCache; return inst; }
+	static GeometryCache *instance() { static GeometryCache inst; return &inst; }
 
-	bool contains(const std::string &id) const { return this->cache.contains(id); }
-	shared_ptr<const class Geometry> get(const std::string &id) const;
-	bool insert(const std::string &id, const shared_ptr<const Geometry> &geom);
+	bool contains(const NodeHash &id) const { return this->cache.contains(id); }
+	shared_ptr<const class Geometry> get(const NodeHash &id) const;
+	bool lookup(const NodeHash &id, shared_ptr<const class Geometry> &geom) const;
+	bool insert(const NodeHash &id, const shared_ptr<const Geometry> &geom, double buildtime = 0);
+	void setEvictionPolicy(CacheEvictionPolicy policy) { this->cache.setEvictionPolicy(policy); }
 	size_t maxSizeMB() const;
 	void setMaxSizeMB(size_t limit);
+	CacheStatistics statistics() const { return this->cache.statistics(); }
 	void clear() { cache.clear(); }
 	void print();
 
 private:
-	static GeometryCache *inst;
-
 	struct cache_entry {
 		shared_ptr<const class Geometry> geom;
 		std::string msg;
-		cache_entry(const shared_ptr<const Geometry> &geom);
+		cache_entry() { }
+		cache_entry(const shared_ptr<const Geometry> &geom, const std::string &msg);
 		~cache_entry() { }
 	};
 
-	Cache<std::string, cache_entry> cache;
+	ShardedCache<NodeHash, cache_entry> cache;
 };
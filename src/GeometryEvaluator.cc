@@ -1,7 +1,9 @@
 #include "GeometryEvaluator.h"
+#include "TransformedGeometry.h"
 #include "Tree.h"
 #include "GeometryCache.h"
 #include "CGALCache.h"
+#include "DiskCache.h"
 #include "Polygon2d.h"
 #include "module.h"
 #include "ModuleInstantiation.h"
@@ -23,12 +25,22 @@
 #include "polyset.h"
 #include "calc.h"
 #include "printutils.h"
+#include "feature.h"
+#include "ThreadPool.h"
+#include "progress.h"
 #include "svg.h"
 #include "calc.h"
 #include "dxfdata.h"
 #include "degree_trig.h"
 #include <ciso646> // C alternative tokens (xor)
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
 
 #pragma push_macro("NDEBUG")
 #undef NDEBUG
@@ -37,30 +49,84 @@
 #pragma pop_macro("NDEBUG")
 
 GeometryEvaluator::GeometryEvaluator(const class Tree &tree):
-	tree(tree)
+	isWorker(false), tree(tree)
 {
 }
 
+namespace {
+	const char *operatorName(OpenSCADOperator op)
+	{
+		switch (op) {
+		case OpenSCADOperator::UNION: return "union";
+		case OpenSCADOperator::INTERSECTION: return "intersection";
+		case OpenSCADOperator::DIFFERENCE: return "difference";
+		case OpenSCADOperator::MINKOWSKI: return "minkowski";
+		case OpenSCADOperator::HULL: return "hull";
+		case OpenSCADOperator::RESIZE: return "resize";
+		}
+		return "unknown";
+	}
+
+	// Adds the lifetime of the timer to the operator's timing
+	class OperatorTimer
+	{
+	public:
+		OperatorTimer(GeometryEvaluator::OperatorTiming &timing)
+			: timing(timing), start(std::chrono::steady_clock::now()) {}
+		~OperatorTimer() {
+			this->timing.count++;
+			this->timing.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - this->start).count();
+		}
+	private:
+		GeometryEvaluator::OperatorTiming &timing;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	/*!
+		Looks up GeometryCache and, if \a both is set or the geometry wasn't
+		found there, CGALCache. Each cache is probed first, so the statistics
+		only count a hit in the caches holding the node; a node held by
+		neither counts as a single miss of GeometryCache.
+	*/
+	void lookupCaches(const NodeHash &key, bool both,
+										shared_ptr<const Geometry> &geom, bool &hasgeom,
+										shared_ptr<const CGAL_Nef_polyhedron> &N, bool &hascgal)
+	{
+		auto geomcache = GeometryCache::instance();
+		auto cgalcache = CGALCache::instance();
+		hasgeom = geomcache->contains(key) && geomcache->lookup(key, geom);
+		hascgal = (both || !hasgeom) && cgalcache->contains(key) && cgalcache->lookup(key, N);
+		if (!hasgeom && !hascgal) geomcache->lookup(key, geom);
+	}
+}
+
 /*!
 	Set allownef to false to force the result to _not_ be a Nef polyhedron
 */
 shared_ptr<const Geometry> GeometryEvaluator::evaluateGeometry(const AbstractNode &node, 
 																															 bool allownef)
 {
-	const std::string &key = this->tree.getIdString(node);
-	if (!GeometryCache::instance()->contains(key)) {
-		shared_ptr<const CGAL_Nef_polyhedron> N;
-		if (CGALCache::instance()->contains(key)) {
-			N = CGALCache::instance()->get(key);
-		}
-
+	const NodeHash key = this->tree.getHash(node);
+	shared_ptr<const Geometry> cached;
+	shared_ptr<const CGAL_Nef_polyhedron> N;
+	loadFromDiskCache(key);
+	bool hasgeom, hascgal;
+	lookupCaches(key, false, cached, hasgeom, N, hascgal);
+	if (!hasgeom) {
 		// If not found in any caches, we need to evaluate the geometry
 		if (N) {
 			this->root = N;
 		}	
 		else {
+			if (!this->isWorker && Feature::ExperimentalParallelEvaluation.is_enabled() &&
+					ThreadPool::configuredThreads() > 1) {
+				evaluateSubtreesInParallel(node);
+			}
 			this->traverse(node);
 		}
+		// Results of parallel subtree tasks are only used by parent nodes, which flatten them when needed.
+		// Results without Nef polyhedra are meant for rendering, so they're always flattened.
+		if (!this->isWorker || !allownef) this->root = TransformedGeometry::flatten(this->root);
 
 		if (!allownef) {
 			if (shared_ptr<const CGAL_Nef_polyhedron> N = dynamic_pointer_cast<const CGAL_Nef_polyhedron>(this->root)) {
@@ -91,9 +157,152 @@ shared_ptr<const Geometry> GeometryEvaluator::evaluateGeometry(const AbstractNod
 			}
 		}
 		smartCacheInsert(node, this->root);
+		this->pinned.clear();
 		return this->root;
 	}
-	return GeometryCache::instance()->get(key);
+	return this->isWorker && allownef ? cached : TransformedGeometry::flatten(cached);
+}
+
+/*!
+	Evaluates the uncached subtrees below \a node concurrently, so that the
+	following traversal of \a node finds all of them cached.
+
+	Every uncached node with children becomes a task, which is scheduled on
+	the thread pool once the tasks of all its descendants have finished.
+	Each task runs its own GeometryEvaluator on its node, which sees the
+	results of the child tasks as already evaluated. Leaf nodes are evaluated
+	as part of their parent's task. Repeated subtrees become a single task,
+	which all their parents wait for.
+
+	Tasks don't report progress or print messages themselves; this is done
+	from the calling thread as tasks finish.
+*/
+void GeometryEvaluator::evaluateSubtreesInParallel(const AbstractNode &node)
+{
+	const size_t none = std::numeric_limits<size_t>::max();
+	struct Task {
+		const AbstractNode *node;
+		NodeHash key;
+		bool toplevel;
+		std::vector<size_t> parents;
+		size_t unsubmittedparents;
+		size_t pending;
+		std::vector<size_t> children;
+	};
+	struct TaskResult {
+		shared_ptr<const Geometry> geom;
+		OperatorTimings timings;
+		std::vector<std::string> messages;
+		std::exception_ptr exception;
+	};
+
+	std::vector<Task> tasks;
+	std::unordered_map<NodeHash, size_t> taskByHash;
+	std::function<void(const AbstractNode &, size_t)> collect = [&](const AbstractNode &n, size_t parent) {
+		if (n.modinst->isBackground()) return;
+		const NodeHash key = this->tree.getHash(n);
+		if (GeometryCache::instance()->contains(key) || CGALCache::instance()->contains(key)) return;
+		// ListNodes only pass their children on to their parent, so they're evaluated as part of the parent
+		if (n.getChildren().empty() || dynamic_cast<const ListNode *>(&n)) {
+			for (const auto &child : n.getChildren()) collect(*child, parent);
+			return;
+		}
+		const auto inserted = taskByHash.emplace(key, tasks.size());
+		const size_t idx = inserted.first->second;
+		if (inserted.second) tasks.push_back({&n, key, false, {}, 0, 0, {}});
+		if (parent == none) {
+			tasks[idx].toplevel = true;
+		}
+		else if (std::find(tasks[parent].children.begin(), tasks[parent].children.end(), idx) == tasks[parent].children.end()) {
+			tasks[parent].pending++;
+			tasks[parent].children.push_back(idx);
+			tasks[idx].parents.push_back(parent);
+			tasks[idx].unsubmittedparents++;
+		}
+		if (inserted.second) {
+			for (const auto &child : n.getChildren()) collect(*child, idx);
+		}
+	};
+	for (const auto &child : node.getChildren()) collect(*child, none);
+	if (tasks.empty()) return;
+
+	std::vector<TaskResult> results(tasks.size());
+	std::mutex donemutex;
+	std::condition_variable donecondition;
+	std::deque<size_t> done;
+	std::atomic<bool> cancelled(false);
+	// Declared last, so it's destroyed first and waits for running tasks before the state they use goes away
+	ThreadPool pool(ThreadPool::configuredThreads());
+
+	auto submit = [&](size_t idx) {
+		std::unordered_map<NodeHash, shared_ptr<const Geometry>> evaluated;
+		for (auto child : tasks[idx].children) {
+			evaluated.emplace(tasks[child].key, results[child].geom);
+			// Keep the result until the last parent has taken it
+			if (--tasks[child].unsubmittedparents == 0) results[child].geom.reset();
+		}
+		pool.enqueue([&, idx, evaluated]() mutable {
+			auto &result = results[idx];
+			if (!cancelled) {
+				set_print_capture(&result.messages);
+				progress_report_disable(true);
+				try {
+					GeometryEvaluator worker(this->tree);
+					worker.setWorker(true);
+					for (const auto &item : evaluated) worker.pin(item.first, item.second);
+					// The worker releases child results as it consumes them
+					evaluated.clear();
+					result.geom = worker.evaluateGeometry(*tasks[idx].node, true);
+					result.timings = worker.getOperatorTimings();
+				}
+				catch (...) {
+					result.exception = std::current_exception();
+				}
+				progress_report_disable(false);
+				set_print_capture(nullptr);
+			}
+			{
+				std::lock_guard<std::mutex> lock(donemutex);
+				done.push_back(idx);
+			}
+			donecondition.notify_one();
+		});
+	};
+
+	for (size_t i = 0; i < tasks.size(); ++i) {
+		if (tasks[i].pending == 0) submit(i);
+	}
+
+	PRINTDB("Evaluating %d subtrees on %d threads", tasks.size() % pool.size());
+	for (size_t remaining = tasks.size(); remaining > 0; --remaining) {
+		size_t idx;
+		{
+			std::unique_lock<std::mutex> lock(donemutex);
+			donecondition.wait(lock, [&done]() { return !done.empty(); });
+			idx = done.front();
+			done.pop_front();
+		}
+		auto &result = results[idx];
+		try {
+			for (const auto &msg : result.messages) PRINT(msg);
+			if (result.exception) std::rethrow_exception(result.exception);
+			for (const auto &timing : result.timings) {
+				this->operatorTimings[timing.first].count += timing.second.count;
+				this->operatorTimings[timing.first].seconds += timing.second.seconds;
+			}
+			tasks[idx].node->progress_report();
+		}
+		catch (...) {
+			// Skip tasks not yet started; the pool waits for the running ones
+			cancelled = true;
+			throw;
+		}
+
+		if (tasks[idx].toplevel) pin(tasks[idx].key, result.geom);
+		for (const auto parent : tasks[idx].parents) {
+			if (--tasks[parent].pending == 0) submit(parent);
+		}
+	}
 }
 
 bool GeometryEvaluator::isValidDim(const Geometry::GeometryItem &item, unsigned int &dim) const {
@@ -123,6 +332,41 @@ GeometryEvaluator::ResultObject GeometryEvaluator::applyToChildren(const Abstrac
 	return ResultObject();
 }
 
+/*!
+	If all children are PolySets and no two of them have overlapping or
+	touching bounding boxes, their union is simply all their polygons.
+	Returns that union in this case, nullptr otherwise (also if all children
+	are empty).
+
+	PolySet bounding boxes are computed from the actual vertex coordinates,
+	so the test is exact.
+*/
+static PolySet *appendDisjointPolySets(const Geometry::Geometries &children)
+{
+	std::vector<std::pair<const PolySet *, BoundingBox>> polysets;
+	for (const auto &item : children) {
+		const PolySet *ps = dynamic_cast<const PolySet *>(item.second.get());
+		if (!ps) return nullptr;
+		if (!ps->isEmpty()) polysets.emplace_back(ps, ps->getBoundingBox());
+	}
+
+	// Sweep along the x axis, only comparing boxes whose x extents overlap
+	std::sort(polysets.begin(), polysets.end(), [](const std::pair<const PolySet *, BoundingBox> &a, const std::pair<const PolySet *, BoundingBox> &b) {
+		return a.second.min()[0] < b.second.min()[0];
+	});
+	for (size_t i = 0; i < polysets.size(); ++i) {
+		const BoundingBox &bbox = polysets[i].second;
+		for (size_t j = i + 1; j < polysets.size() && polysets[j].second.min()[0] <= bbox.max()[0]; ++j) {
+			if (bbox.intersects(polysets[j].second)) return nullptr;
+		}
+	}
+
+	if (polysets.empty()) return nullptr;
+	PolySet *result = new PolySet(3);
+	for (const auto &item : polysets) result->append(*item.first);
+	return result;
+}
+
 /*!
 	Applies the operator to all child nodes of the given node.
 	
@@ -130,6 +374,7 @@ GeometryEvaluator::ResultObject GeometryEvaluator::applyToChildren(const Abstrac
 */
 GeometryEvaluator::ResultObject GeometryEvaluator::applyToChildren3D(const AbstractNode &node, OpenSCADOperator op)
 {
+	OperatorTimer timer(this->operatorTimings[operatorName(op)]);
 	Geometry::Geometries children = collectChildren3D(node);
 	if (children.size() == 0) return ResultObject();
 
@@ -151,23 +396,36 @@ GeometryEvaluator::ResultObject GeometryEvaluator::applyToChildren3D(const Abstr
 		case OpenSCADOperator::MINKOWSKI:
 		{
 			Geometry::Geometries actualchildren;
-			for(const auto &item : children) {
-				if (!item.second->isEmpty()) actualchildren.push_back(item);
+			for(auto &item : children) {
+				if (!item.second->isEmpty()) actualchildren.push_back(std::move(item));
 			}
 			if (actualchildren.empty()) return ResultObject();
 			if (actualchildren.size() == 1) return ResultObject(actualchildren.front().second);
-			return ResultObject(CGALUtils::applyMinkowski(actualchildren));
+			return ResultObject(CGALUtils::applyMinkowski(actualchildren, &this->tree));
 			break;
 		}
 		case OpenSCADOperator::UNION:
 		{
+			if (Feature::ExperimentalDisjointUnion.is_enabled()) {
+				PolySet *ps = appendDisjointPolySets(children);
+				if (ps) return ResultObject(ps);
+			}
+			if (Feature::ExperimentalCorefinement.is_enabled()) {
+				PolySet *ps = CGALUtils::applyCorefinement(children, op);
+				if (ps) return ResultObject(ps);
+			}
 			CGAL_Nef_polyhedron* N = CGALUtils::applyUnion(children.begin(), children.end());
 			return ResultObject(N);
 			break;
 		}
 		default: 
 		{
-			CGAL_Nef_polyhedron *N = CGALUtils::applyOperator(children, op);
+			if (Feature::ExperimentalCorefinement.is_enabled() &&
+					(op == OpenSCADOperator::INTERSECTION || op == OpenSCADOperator::DIFFERENCE)) {
+				PolySet *ps = CGALUtils::applyCorefinement(children, op);
+				if (ps) return ResultObject(ps);
+			}
+			CGAL_Nef_polyhedron *N = CGALUtils::applyOperator(std::move(children), op);
 			// FIXME: Clarify when we can return nullptr and what that means
 			if (!N) N = new CGAL_Nef_polyhedron;
 			return ResultObject(N);
@@ -247,7 +505,7 @@ Polygon2d *GeometryEvaluator::applyMinkowski2D(const AbstractNode &node)
 std::vector<const class Polygon2d *> GeometryEvaluator::collectChildren2D(const AbstractNode &node)
 {
 	std::vector<const Polygon2d *> children;
-	for(const auto &item : this->visitedchildren[node.index()]) {
+	for(auto &item : this->visitedchildren[node.index()]) {
 		const AbstractNode *chnode = item.first;
 		const shared_ptr<const Geometry> &chgeom = item.second;
 		if (chnode->modinst->isBackground()) continue;
@@ -257,6 +515,7 @@ std::vector<const class Polygon2d *> GeometryEvaluator::collectChildren2D(const
 		// cache could have been modified before we reach this point due to a large
 		// sibling object. 
 		smartCacheInsert(*chnode, chgeom);
+		item.second = TransformedGeometry::flatten(item.second);
 		
 		if (chgeom) {
 			if (chgeom->getDimension() == 2) {
@@ -281,47 +540,118 @@ std::vector<const class Polygon2d *> GeometryEvaluator::collectChildren2D(const
 void GeometryEvaluator::smartCacheInsert(const AbstractNode &node, 
 																				 const shared_ptr<const Geometry> &geom)
 {
-	const std::string &key = this->tree.getIdString(node);
+	const NodeHash key = this->tree.getHash(node);
+
+	// Time since the first cache miss for this node, i.e. the time spent building it and its children
+	double buildtime = 0;
+	auto start = this->buildStart.find(key);
+	if (start != this->buildStart.end()) {
+		buildtime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start->second).count();
+		this->buildStart.erase(start);
+	}
 
 	shared_ptr<const CGAL_Nef_polyhedron> N = dynamic_pointer_cast<const CGAL_Nef_polyhedron>(geom);
 	if (N) {
-		if (!CGALCache::instance()->contains(key)) CGALCache::instance()->insert(key, N);
+		if (!CGALCache::instance()->contains(key)) {
+			CGALCache::instance()->insert(key, N, buildtime);
+			storeInDiskCache(node, key, geom);
+		}
 	}
 	else {
 		if (!GeometryCache::instance()->contains(key)) {
-			if (!GeometryCache::instance()->insert(key, geom)) {
+			if (!GeometryCache::instance()->insert(key, geom, buildtime)) {
 				PRINT("WARNING: GeometryEvaluator: Node didn't fit into cache");
 			}
+			storeInDiskCache(node, key, geom);
 		}
 	}
 }
 
+/*!
+	Writes geometry to the disk cache, if enabled. Leaf nodes and transformed
+	geometry are skipped since they're usually cheaper to recreate than to read back.
+*/
+void GeometryEvaluator::storeInDiskCache(const AbstractNode &node, const NodeHash &key,
+																				 const shared_ptr<const Geometry> &geom)
+{
+	if (!DiskCache::instance()->isEnabled() || node.getChildren().empty() ||
+			dynamic_cast<const TransformedGeometry *>(geom.get())) return;
+	DiskCache::instance()->insert(key, geom);
+}
+
+/*!
+	On a miss in the in-memory caches, looks up the disk cache and moves a hit
+	into the in-memory cache matching its type.
+*/
+void GeometryEvaluator::loadFromDiskCache(const NodeHash &key)
+{
+	if (!DiskCache::instance()->isEnabled() ||
+			GeometryCache::instance()->contains(key) ||
+			CGALCache::instance()->contains(key)) return;
+
+	auto geom = DiskCache::instance()->get(key);
+	if (!geom) return;
+	if (auto N = dynamic_pointer_cast<const CGAL_Nef_polyhedron>(geom)) {
+		CGALCache::instance()->insert(key, N);
+	}
+	else {
+		GeometryCache::instance()->insert(key, geom);
+	}
+}
+
+/*!
+	Keeps geometry available to smartCacheGet() until the end of
+	evaluateGeometry(), regardless of cache eviction.
+*/
+void GeometryEvaluator::pin(const NodeHash &key, const shared_ptr<const Geometry> &geom)
+{
+	auto &entry = this->pinned[key];
+	if (auto N = dynamic_pointer_cast<const CGAL_Nef_polyhedron>(geom)) entry.N = N;
+	else entry.geom = geom;
+	entry.hasgeom = entry.hasgeom || !entry.N;
+}
+
+/*!
+	Returns true if the node's geometry is cached. Cached geometry is pinned,
+	so it can't be evicted by other threads before smartCacheGet() is called.
+*/
 bool GeometryEvaluator::isSmartCached(const AbstractNode &node)
 {
-	const std::string &key = this->tree.getIdString(node);
-	return (GeometryCache::instance()->contains(key) ||
-					CGALCache::instance()->contains(key));
+	const NodeHash key = this->tree.getHash(node);
+	if (this->pinned.count(key)) return true;
+
+	loadFromDiskCache(key);
+	PinnedGeometry entry;
+	bool hascgal;
+	lookupCaches(key, true, entry.geom, entry.hasgeom, entry.N, hascgal);
+	if (!entry.hasgeom && !hascgal) {
+		this->buildStart.emplace(key, std::chrono::steady_clock::now());
+		return false;
+	}
+	this->pinned[key] = entry;
+	return true;
 }
 
 shared_ptr<const Geometry> GeometryEvaluator::smartCacheGet(const AbstractNode &node, bool preferNef)
 {
-	const std::string &key = this->tree.getIdString(node);
+	if (!isSmartCached(node)) return nullptr;
+	auto entry = this->pinned.find(this->tree.getHash(node));
 	shared_ptr<const Geometry> geom;
-	bool hasgeom = GeometryCache::instance()->contains(key);
-	bool hascgal = CGALCache::instance()->contains(key);
-	if (hascgal && (preferNef || !hasgeom)) geom = CGALCache::instance()->get(key);
-	else if (hasgeom) geom = GeometryCache::instance()->get(key);
+	if (entry->second.N && (preferNef || !entry->second.hasgeom)) geom = entry->second.N;
+	else geom = entry->second.geom;
+	this->pinned.erase(entry);
 	return geom;
 }
 
 /*!
 	Returns a list of 3D Geometry children of the given node.
-	May return empty geometries, but not nullptr objects
+	May return empty geometries, but not nullptr objects.
+	The returned geometries are moved out of visitedchildren.
 */
 Geometry::Geometries GeometryEvaluator::collectChildren3D(const AbstractNode &node)
 {
 	Geometry::Geometries children;
-	for(const auto &item : this->visitedchildren[node.index()]) {
+	for(auto &item : this->visitedchildren[node.index()]) {
 		const AbstractNode *chnode = item.first;
 		const shared_ptr<const Geometry> &chgeom = item.second;
 		if (chnode->modinst->isBackground()) continue;
@@ -331,6 +661,7 @@ Geometry::Geometries GeometryEvaluator::collectChildren3D(const AbstractNode &no
 		// cache could have been modified before we reach this point due to a large
 		// sibling object. 
 		smartCacheInsert(*chnode, chgeom);
+		item.second = TransformedGeometry::flatten(item.second);
 		
 		if (chgeom) {
 			if (chgeom->getDimension() == 2) {
@@ -338,18 +669,39 @@ Geometry::Geometries GeometryEvaluator::collectChildren3D(const AbstractNode &no
 				PRINTB("WARNING: Ignoring 2D child object for 3D operation, %s", loc);
 			}
 			else if (chgeom->isEmpty() || chgeom->getDimension() == 3) {
-				children.push_back(item);
+				// Move out, so the geometry can be released as soon as the operation has consumed it
+				children.push_back(std::make_pair(chnode, std::move(item.second)));
 			}
 		}
 	}
 	return children;
 }
 
+/*!
+	If exactly one child of the given node affects the output, inserts it into
+	the cache like collectChildren3D() does and returns it as is, i.e. without
+	flattening transformed geometry. Returns false otherwise.
+*/
+bool GeometryEvaluator::collectSingleChild(const AbstractNode &node, shared_ptr<const Geometry> &geom)
+{
+	const Geometry::GeometryItem *single = nullptr;
+	for (const auto &item : this->visitedchildren[node.index()]) {
+		if (item.first->modinst->isBackground()) continue;
+		if (single) return false;
+		single = &item;
+	}
+	if (!single) return false;
+	smartCacheInsert(*single->first, single->second);
+	geom = single->second;
+	return true;
+}
+
 /*!
 	
 */
 Polygon2d *GeometryEvaluator::applyToChildren2D(const AbstractNode &node, OpenSCADOperator op)
 {
+	OperatorTimer timer(this->operatorTimings[operatorName(op)]);
 	node.progress_report();
 	if (op == OpenSCADOperator::MINKOWSKI) {
 		return applyMinkowski2D(node);
@@ -484,7 +836,7 @@ Response GeometryEvaluator::lazyEvaluateRootNode(State &state, const AbstractNod
 
 		unsigned int dim = 0;
 		GeometryList::Geometries geometries;
-		for(const auto &item : this->visitedchildren[node.index()]) {
+		for(auto &item : this->visitedchildren[node.index()]) {
 			if (!isValidDim(item, dim)) break;
 			const AbstractNode *chnode = item.first;
 			const shared_ptr<const Geometry> &chgeom = item.second;
@@ -494,6 +846,7 @@ Response GeometryEvaluator::lazyEvaluateRootNode(State &state, const AbstractNod
 			// cache could have been modified before we reach this point due to a large
 			// sibling object. 
 			smartCacheInsert(*chnode, chgeom);
+			item.second = TransformedGeometry::flatten(item.second);
 			// Only use valid geometries
 			if (chgeom && !chgeom->isEmpty()) geometries.push_back(item);
 		}
@@ -633,7 +986,7 @@ Response GeometryEvaluator::visit(State &state, const TextNode &node)
 			}
 			geom.reset(ClipperUtils::apply(polygonlist, ClipperLib::ctUnion));
 		}
-		else geom = GeometryCache::instance()->get(this->tree.getIdString(node));
+		else geom = smartCacheGet(node, false);
 		addToParent(state, node, geom);
 		node.progress_report();
 	}
@@ -685,6 +1038,21 @@ Response GeometryEvaluator::visit(State &state, const TransformNode &node)
 				std::string loc = node.modinst->location().toRelativeString(this->tree.getDocumentPath());
 				PRINTB("WARNING: Transformation matrix contains Not-a-Number and/or Infinity - removing object. %s", loc);
 			}
+			else if (collectSingleChild(node, geom)) {
+				// Nef polyhedra are transformed right away, see TransformedGeometry
+				if (auto N = dynamic_pointer_cast<const CGAL_Nef_polyhedron>(geom)) {
+					shared_ptr<CGAL_Nef_polyhedron> newN(static_cast<CGAL_Nef_polyhedron *>(N->copy()));
+					newN->transform(node.matrix);
+					geom = newN;
+				}
+				// Others are wrapped instead of copied, so transformed instances of cached geometry share it
+				else if (geom) {
+					shared_ptr<const TransformedGeometry> transformed(new TransformedGeometry(geom, node.matrix));
+					geom = transformed;
+					// Singular matrices remove the object with a warning, which is done when flattening
+					if (transformed->getMatrix().matrix().determinant() == 0) geom = transformed->flatten();
+				}
+			}
 			else {
 				// First union all children
 				ResultObject res = applyToChildren(node, OpenSCADOperator::UNION);
@@ -746,11 +1114,7 @@ Response GeometryEvaluator::visit(State &state, const TransformNode &node)
 
 static void translate_PolySet(PolySet &ps, const Vector3d &translation)
 {
-	for(auto &p : ps.polygons) {
-		for(auto &v : p) {
-			v += translation;
-		}
-	}
+	ps.transform(Transform3d(Eigen::Translation3d(translation)));
 }
 
 static void add_slice(PolySet *ps, const Polygon2d &poly, 
@@ -826,9 +1190,7 @@ static Geometry *extrudePolygon(const LinearExtrudeNode &node, const Polygon2d &
 	PolySet *ps_bottom = poly.tessellate(); // bottom
 	
 	// Flip vertex ordering for bottom polygon
-	for(auto &p : ps_bottom->polygons) {
-		std::reverse(p.begin(), p.end());
-	}
+	ps_bottom->flipPolygons();
 	translate_PolySet(*ps_bottom, Vector3d(0,0,h1));
 
 	ps->append(*ps_bottom);
@@ -968,9 +1330,7 @@ static Geometry *rotatePolygon(const RotateExtrudeNode &node, const Polygon2d &p
 		ps_start->transform(rot);
 		// Flip vertex ordering
 		if (!flip_faces) {
-			for(auto &p : ps_start->polygons) {
-				std::reverse(p.begin(), p.end());
-			}
+			ps_start->flipPolygons();
 		}
 		ps->append(*ps_start);
 		delete ps_start;
@@ -979,9 +1339,7 @@ static Geometry *rotatePolygon(const RotateExtrudeNode &node, const Polygon2d &p
 		Transform3d rot2(angle_axis_degrees(node.angle, Vector3d::UnitZ()) * angle_axis_degrees(90, Vector3d::UnitX()));
 		ps_end->transform(rot2);
 		if (flip_faces) {
-			for(auto &p : ps_end->polygons) {
-				std::reverse(p.begin(), p.end());
-			}
+			ps_end->flipPolygons();
 		}
 		ps->append(*ps_end);
 		delete ps_end;
@@ -1083,7 +1441,7 @@ Response GeometryEvaluator::visit(State &state, const ProjectionNode &node)
 				ClipperLib::Clipper sumclipper;
 				for(const auto &item : this->visitedchildren[node.index()]) {
 					const AbstractNode *chnode = item.first;
-					const shared_ptr<const Geometry> &chgeom = item.second;
+					const shared_ptr<const Geometry> chgeom = TransformedGeometry::flatten(item.second);
 					if (chnode->modinst->isBackground()) continue;
 
 					const Polygon2d *poly = nullptr;
@@ -4,15 +4,27 @@
 #include "enums.h"
 #include "memory.h"
 #include "Geometry.h"
+#include "nodehash.h"
 
 #include <utility>
 #include <list>
 #include <vector>
 #include <map>
+#include <string>
+#include <unordered_map>
+#include <chrono>
 
 class GeometryEvaluator : public NodeVisitor
 {
 public:
+	// Accumulated wall clock time spent per CSG operator
+	struct OperatorTiming {
+		OperatorTiming() : count(0), seconds(0) {}
+		size_t count;
+		double seconds;
+	};
+	typedef std::map<std::string, OperatorTiming> OperatorTimings;
+
 	GeometryEvaluator(const class Tree &tree);
 	~GeometryEvaluator() {}
 
@@ -36,6 +48,9 @@ public:
 	Response visit(State &state, const OffsetNode &node) override;
 
 	const Tree &getTree() const { return this->tree; }
+	// For evaluators run by parallel tasks, see isWorker
+	void setWorker(bool worker) { this->isWorker = worker; }
+	const OperatorTimings &getOperatorTimings() const { return this->operatorTimings; }
 
 private:
 	class ResultObject {
@@ -59,9 +74,14 @@ private:
 	void smartCacheInsert(const AbstractNode &node, const shared_ptr<const Geometry> &geom);
 	shared_ptr<const Geometry> smartCacheGet(const AbstractNode &node, bool preferNef);
 	bool isSmartCached(const AbstractNode &node);
+	void pin(const NodeHash &key, const shared_ptr<const Geometry> &geom);
+	void evaluateSubtreesInParallel(const AbstractNode &node);
+	void loadFromDiskCache(const NodeHash &key);
+	void storeInDiskCache(const AbstractNode &node, const NodeHash &key, const shared_ptr<const Geometry> &geom);
 	bool isValidDim(const Geometry::GeometryItem &item, unsigned int &dim) const;
 	std::vector<const class Polygon2d *> collectChildren2D(const AbstractNode &node);
 	Geometry::Geometries collectChildren3D(const AbstractNode &node);
+	bool collectSingleChild(const AbstractNode &node, shared_ptr<const Geometry> &geom);
 	Polygon2d *applyMinkowski2D(const AbstractNode &node);
 	Polygon2d *applyHull2D(const AbstractNode &node);
 	Geometry *applyHull3D(const AbstractNode &node);
@@ -73,6 +93,20 @@ private:
 	Response lazyEvaluateRootNode(State &state, const AbstractNode& node);
 
 	std::map<int, Geometry::Geometries> visitedchildren;
+	// When evaluation of a node started, used to weigh cache entries by their build time
+	std::unordered_map<NodeHash, std::chrono::steady_clock::time_point> buildStart;
+	OperatorTimings operatorTimings;
+
+	// Cached geometry this evaluator has found and will use, see isSmartCached()
+	struct PinnedGeometry {
+		PinnedGeometry() : hasgeom(false) {}
+		shared_ptr<const Geometry> geom;
+		shared_ptr<const class CGAL_Nef_polyhedron> N;
+		bool hasgeom;
+	};
+	std::unordered_map<NodeHash, PinnedGeometry> pinned;
+	// Set for the evaluators of parallel tasks, which must not spawn tasks themselves
+	bool isWorker;
 	const Tree &tree;
 	shared_ptr<const Geometry> root;
 
@@ -50,7 +50,9 @@ public:
 	ModuleInstantiation root_inst;	// Top level instance
 	AbstractNode *absolute_root_node; // Result of tree evaluation
 	AbstractNode *root_node;		  // Root if the root modifier (!) is used
+	AbstractNode *simplified_root_node; // Simplified copy of root_node, evaluated instead if set
 	Tree tree;
+	Tree simplified_tree;
 	EditorInterface *activeEditor;
 	TabManager *tabManager;
 
@@ -115,6 +117,9 @@ private:
 	void updateCompileResult();
 	void compile(bool reload, bool forcedone = false, bool rebuildParameterWidget=true);
 	void compileCSG();
+	// The design is shown and exported as written, but may be evaluated simplified
+	AbstractNode *evaluatedRoot() const { return this->simplified_root_node ? this->simplified_root_node : this->root_node; }
+	Tree &evaluatedTree() { return this->simplified_root_node ? this->simplified_tree : this->tree; }
 	bool checkEditorModified();
 	QString dumpCSGTree(AbstractNode *root);
 
@@ -189,7 +194,10 @@ protected:
 private slots:
 	void actionRenderPreview(bool rebuildParameterWidget=true);
 	void csgRender();
+	void csgRenderDone();
 	void csgReloadRender();
+	void csgReloadRenderDone();
+	void compileCSGDone();
 	void action3DPrint();
 	void sendToOctoPrint();
 	void sendToPrintService();
@@ -305,10 +313,12 @@ private:
 	shared_ptr<CSGProducts> background_products;
 
 	char const * afterCompileSlot;
+	char const * afterCSGSlot;
 	bool procevents;
 	class QTemporaryFile *tempFile;
 	class ProgressWidget *progresswidget;
 	class CGALWorker *cgalworker;
+	class CSGWorker *csgworker;
 	QMutex consolemutex;
 	EditorInterface *renderedEditor; // stores pointer to editor which has been most recently rendered
 	time_t includes_mtime;   // latest include mod time
@@ -0,0 +1,106 @@
+#include "NodeSimplifier.h"
+#include "node.h"
+#include "csgops.h"
+#include "colornode.h"
+#include "transformnode.h"
+#include "ModuleInstantiation.h"
+
+namespace {
+	bool hasModifier(const AbstractNode &node)
+	{
+		return node.modinst->isBackground() || node.modinst->isHighlight() || node.modinst->isRoot();
+	}
+
+	bool isIdentity(const TransformNode &node)
+	{
+		return node.matrix.matrix() == Eigen::Matrix4d::Identity();
+	}
+
+	/*
+		2D objects only use the xy part of a matrix, so two transformations may
+		only be folded if z doesn't leak into x and y, otherwise the product
+		would transform 2D objects differently than the two steps.
+		Invalid matrices are left alone to keep the warning about them.
+	*/
+	bool canFold(const Transform3d &outer, const Transform3d &inner)
+	{
+		if (matrix_contains_infinity(outer) || matrix_contains_nan(outer) ||
+				matrix_contains_infinity(inner) || matrix_contains_nan(inner)) return false;
+		return (outer(0,2) == 0 && outer(1,2) == 0) ||
+			(inner(2,0) == 0 && inner(2,1) == 0 && inner(2,3) == 0);
+	}
+}
+
+void NodeSimplifier::simplify(AbstractNode &root)
+{
+	simplifyChildren(root);
+}
+
+/*!
+	Nodes which only union their children: groups, unions, identity
+	transformations and, unless kept, colors. The root node isn't included,
+	since its children are kept separate by lazy unions.
+*/
+bool NodeSimplifier::isUnion(const AbstractNode &node) const
+{
+	if (dynamic_cast<const RootNode *>(&node)) return false;
+	if (dynamic_cast<const GroupNode *>(&node)) return true;
+	if (const auto csgop = dynamic_cast<const CsgOpNode *>(&node)) return csgop->type == OpenSCADOperator::UNION;
+	if (const auto transform = dynamic_cast<const TransformNode *>(&node)) return isIdentity(*transform);
+	if (dynamic_cast<const ColorNode *>(&node)) return !this->keepColors;
+	return false;
+}
+
+/*!
+	Deletes node, returning its only child.
+*/
+AbstractNode *NodeSimplifier::replaceWithChild(AbstractNode *node)
+{
+	AbstractNode *child = node->children.front();
+	node->children.clear();
+	delete node;
+	this->removed++;
+	return child;
+}
+
+void NodeSimplifier::simplifyChildren(AbstractNode &node)
+{
+	const bool flatten = isUnion(node);
+	std::vector<AbstractNode *> children;
+	children.reserve(node.children.size());
+	for (auto child : node.children) {
+		simplifyChildren(*child);
+		if (hasModifier(*child)) {
+			children.push_back(child);
+			continue;
+		}
+
+		// Fold a transformation of a single transformation into one
+		auto transform = dynamic_cast<TransformNode *>(child);
+		while (transform && transform->children.size() == 1) {
+			auto inner = dynamic_cast<TransformNode *>(transform->children.front());
+			if (!inner || hasModifier(*inner) || !canFold(transform->matrix, inner->matrix)) break;
+			inner->matrix = transform->matrix * inner->matrix;
+			child = transform = static_cast<TransformNode *>(replaceWithChild(transform));
+		}
+
+		// Replace no-op nodes by their child. Children with modifiers stay
+		// where they are, since e.g. a background object would otherwise
+		// take its parent's place as the first operand of a difference.
+		while (child->children.size() == 1 && isUnion(*child) && !hasModifier(*child->children.front())) {
+			child = replaceWithChild(child);
+		}
+
+		// Splice the operands of nested unions and lists into this union
+		if (flatten && !hasModifier(*child) && (isUnion(*child) || dynamic_cast<ListNode *>(child))) {
+			children.insert(children.end(), child->children.begin(), child->children.end());
+			child->children.clear();
+			delete child;
+			this->removed++;
+		}
+		else {
+			children.push_back(child);
+		}
+	}
+	node.children.swap(children);
+}
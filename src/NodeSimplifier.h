@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+/*!
+	Simplifies a freshly instantiated node tree in place, before it's
+	evaluated, without changing the resulting geometry:
+
+	o Chains of transformations are folded into a single TransformNode
+	o Identity transformations, single-child groups and unions, and
+	  (optionally) colors are replaced by their child
+	o Nested groups, unions and lists are flattened into their parent union,
+	  so the union sees all operands at once
+
+	Nodes carrying a modifier (%, #, !) are never removed or merged, and are
+	only moved from a nested union into the enclosing one, where the order
+	of operands doesn't matter. The root itself is never replaced. Removed
+	nodes are deleted.
+*/
+class NodeSimplifier
+{
+public:
+	NodeSimplifier(bool keepColors) : keepColors(keepColors), removed(0) {}
+	~NodeSimplifier() {}
+
+	void simplify(class AbstractNode &root);
+	// Number of nodes removed so far
+	size_t removedNodes() const { return this->removed; }
+
+private:
+	void simplifyChildren(AbstractNode &node);
+	bool isUnion(const AbstractNode &node) const;
+	AbstractNode *replaceWithChild(AbstractNode *node);
+
+	bool keepColors;
+	size_t removed;
+};
@@ -1,5 +1,6 @@
 #include "Polygon2d.h"
 #include "printutils.h"
+#include "vertex-kernels.h"
 
 /*!
 	Class for holding 2D geometry.
@@ -63,9 +64,7 @@ void Polygon2d::transform(const Transform2d &mat)
 		return;
 	}
 	for (auto &o : this->theoutlines) {
-		for (auto &v : o.vertices) {
-			v = mat * v;
-		}
+		VertexKernels::transform(o.vertices.data(), o.vertices.size(), mat);
 	}
 }
 
@@ -37,6 +37,7 @@
 #include "feature.h"
 #ifdef ENABLE_CGAL
 #include "CGALCache.h"
+#include "DecompositionCache.h"
 #endif
 #include "colormap.h"
 #include "rendersettings.h"
@@ -141,6 +142,8 @@ void Preferences::init() {
 	this->defaultmap["advanced/cgalCacheSize"] = qulonglong(CGALCache::instance()->maxSizeMB())*1024*1024;
 	this->defaultmap["advanced/cgalCacheSizeMB"] = getValue("advanced/cgalCacheSize").toULongLong()/(1024*1024); // carry over old settings if they exist
 #endif
+	this->defaultmap["advanced/threads"] = RenderSettings::inst()->threads;
+	this->defaultmap["advanced/costAwareCacheEviction"] = false;
 	this->defaultmap["advanced/openCSGLimit"] = RenderSettings::inst()->openCSGTermLimit;
 	this->defaultmap["advanced/forceGoldfeather"] = false;
 	this->defaultmap["advanced/undockableWindows"] = false;
@@ -193,6 +196,7 @@ void Preferences::init() {
 	this->cgalCacheSizeMBEdit->setValidator(memvalidator);
 #endif
 	this->polysetCacheSizeMBEdit->setValidator(memvalidator);
+	this->threadsEdit->setValidator(new QIntValidator(0, 1024, this));
 	this->opencsgLimitEdit->setValidator(validator);
 	this->timeThresholdOnRenderCompleteSoundEdit->setValidator(validator);
 	this->lineEditCharacterThreshold->setValidator(validator1);
@@ -458,6 +462,7 @@ void Preferences::on_cgalCacheSizeMBEdit_textChanged(const QString &text)
 	settings.setValue("advanced/cgalCacheSizeMB", text);
 #ifdef ENABLE_CGAL
 	CGALCache::instance()->setMaxSizeMB(text.toULong());
+	DecompositionCache::instance()->setMaxSizeMB(text.toULong());
 #endif
 }
 
@@ -468,6 +473,24 @@ void Preferences::on_polysetCacheSizeMBEdit_textChanged(const QString &text)
 	GeometryCache::instance()->setMaxSizeMB(text.toULong());
 }
 
+void Preferences::on_costAwareCacheEvictionBox_toggled(bool state)
+{
+	QSettingsCached settings;
+	settings.setValue("advanced/costAwareCacheEviction", state);
+	auto policy = state ? CacheEvictionPolicy::CostAware : CacheEvictionPolicy::LeastRecentlyUsed;
+	GeometryCache::instance()->setEvictionPolicy(policy);
+#ifdef ENABLE_CGAL
+	CGALCache::instance()->setEvictionPolicy(policy);
+#endif
+}
+
+void Preferences::on_threadsEdit_textChanged(const QString &text)
+{
+	QSettingsCached settings;
+	settings.setValue("advanced/threads", text);
+	RenderSettings::inst()->threads = text.toUInt();
+}
+
 void Preferences::on_opencsgLimitEdit_textChanged(const QString &text)
 {
 	QSettingsCached settings;
@@ -876,6 +899,8 @@ void Preferences::updateGUI()
 	BlockSignals<QCheckBox *>(this->enableOpenCSGBox)->setChecked(getValue("advanced/enable_opencsg_opengl1x").toBool());
 	BlockSignals<QLineEdit *>(this->cgalCacheSizeMBEdit)->setText(getValue("advanced/cgalCacheSizeMB").toString());
 	BlockSignals<QLineEdit *>(this->polysetCacheSizeMBEdit)->setText(getValue("advanced/polysetCacheSizeMB").toString());
+	BlockSignals<QCheckBox *>(this->costAwareCacheEvictionBox)->setChecked(getValue("advanced/costAwareCacheEviction").toBool());
+	BlockSignals<QLineEdit *>(this->threadsEdit)->setText(getValue("advanced/threads").toString());
 	BlockSignals<QLineEdit *>(this->opencsgLimitEdit)->setText(getValue("advanced/openCSGLimit").toString());
 	BlockSignals<QCheckBox *>(this->localizationCheckBox)->setChecked(getValue("advanced/localization").toBool());
 	BlockSignals<QCheckBox *>(this->autoReloadRaiseCheckBox)->setChecked(getValue("advanced/autoReloadRaise").toBool());
@@ -36,6 +36,8 @@ public slots:
 	void on_enableOpenCSGBox_toggled(bool);
 	void on_cgalCacheSizeMBEdit_textChanged(const QString &);
 	void on_polysetCacheSizeMBEdit_textChanged(const QString &);
+	void on_costAwareCacheEvictionBox_toggled(bool);
+	void on_threadsEdit_textChanged(const QString &);
 	void on_opencsgLimitEdit_textChanged(const QString &);
 	void on_forceGoldfeatherBox_toggled(bool);
 	void on_mouseWheelZoomBox_toggled(bool);
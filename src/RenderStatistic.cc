@@ -26,21 +26,139 @@
 #include "printutils.h"
 #include "GeometryCache.h"
 #include "CGALCache.h"
+#include "DecompositionCache.h"
+#include "DiskCache.h"
+#include "FunctionCache.h"
+#include "feature.h"
 #include "polyset.h"
 #include "Polygon2d.h"
 
 #ifdef ENABLE_CGAL
 #include "CGAL_Nef_polyhedron.h"
+#include "cgalutils.h"
 #endif // ENABLE_CGAL
 
 #include "RenderStatistic.h"
 
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <set>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace {
+  // Peak resident set size of the process in bytes, or 0 if not available
+  size_t peakMemoryUsage()
+  {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return usage.ru_maxrss * size_t(1024);
+#endif
+#endif
+  }
+
+  struct GeometryStatistic {
+    GeometryStatistic() : dimension(0), objects(0), facets(0), vertices(0), volume(0), area(0) {}
+    unsigned int dimension;
+    size_t objects, facets, vertices;
+    double volume, area;
+  };
+
+  // Signed volume of a closed PolySet, using the divergence theorem on fan triangulated faces
+  double polySetVolume(const PolySet &ps)
+  {
+    double volume = 0;
+    for (const auto &p : ps.polygons()) {
+      for (size_t i = 1; i + 1 < p.size(); ++i) {
+        volume += p[0].dot(p[i].cross(p[i + 1]));
+      }
+    }
+    // PolySet faces are clockwise when seen from the outside
+    return -volume / 6;
+  }
+
+  size_t polySetVertices(const PolySet &ps)
+  {
+    std::set<std::array<double, 3>> vertices;
+    for (const auto &v : ps.getVertices()) vertices.insert({{v[0], v[1], v[2]}});
+    return vertices.size();
+  }
+
+  void collectStatistic(const Geometry &geom, GeometryStatistic &stat)
+  {
+    if (const auto geomlist = dynamic_cast<const GeometryList *>(&geom)) {
+      for (const auto &item : geomlist->flatten()) collectStatistic(*item.second, stat);
+      return;
+    }
+    if (geom.isEmpty()) return;
+    stat.objects++;
+    stat.dimension = std::max(stat.dimension, geom.getDimension());
+    if (const auto ps = dynamic_cast<const PolySet *>(&geom)) {
+      stat.facets += ps->numFacets();
+      stat.vertices += polySetVertices(*ps);
+      if (ps->getDimension() == 3) stat.volume += polySetVolume(*ps);
+    }
+    else if (const auto poly = dynamic_cast<const Polygon2d *>(&geom)) {
+      for (const auto &o : poly->outlines()) {
+        stat.vertices += o.vertices.size();
+        // Shoelace formula; holes have opposite orientation and subtract
+        for (size_t i = 0; i < o.vertices.size(); ++i) {
+          const auto &a = o.vertices[i];
+          const auto &b = o.vertices[(i + 1) % o.vertices.size()];
+          stat.area += (a[0] * b[1] - b[0] * a[1]) / 2;
+        }
+      }
+    }
+#ifdef ENABLE_CGAL
+    else if (const auto N = dynamic_cast<const CGAL_Nef_polyhedron *>(&geom)) {
+      stat.facets += N->p3->number_of_facets();
+      stat.vertices += N->p3->number_of_vertices();
+      PolySet ps(3);
+      if (!CGALUtils::createPolySetFromNefPolyhedron3(*N->p3, ps)) stat.volume += polySetVolume(ps);
+    }
+#endif // ENABLE_CGAL
+  }
+
+  // JSON has no representation of NaN and infinity
+  void writeNumber(std::ostream &out, double d)
+  {
+    if (std::isfinite(d)) out << d;
+    else out << "null";
+  }
+
+  void writeCacheStatistic(std::ostream &out, const char *name, const CacheStatistics &stats, bool last = false)
+  {
+    out << "    \"" << name << "\": {"
+        << "\"hits\": " << stats.hits << ", "
+        << "\"misses\": " << stats.misses << ", "
+        << "\"inserts\": " << stats.inserts << ", "
+        << "\"evictions\": " << stats.evictions << ", "
+        << "\"entries\": " << stats.entries << ", "
+        << "\"bytes\": " << stats.bytes << ", "
+        << "\"limit\": " << stats.limit << "}"
+        << (last ? "\n" : ",\n");
+  }
+}
+
 
 void RenderStatistic::printCacheStatistic()
 {
   GeometryCache::instance()->print();
+  if (Feature::ExperimentalFunctionCache.is_enabled()) FunctionCache::instance()->print();
 #ifdef ENABLE_CGAL
   CGALCache::instance()->print();
+  DecompositionCache::instance()->print();
+  DiskCache::instance()->print();
 #endif
 }
 
@@ -54,6 +172,69 @@ void RenderStatistic::printRenderingTime(std::chrono::milliseconds ms)
   );
 }
 
+bool RenderStatistic::writeSummary(const std::string &filename, std::chrono::milliseconds ms,
+                                   const shared_ptr<const Geometry> &geom,
+                                   const GeometryEvaluator::OperatorTimings &timings)
+{
+  std::ofstream out(filename, std::ios::out | std::ios::trunc);
+  if (!out.is_open()) {
+    PRINTB("Can't open file \"%s\" for writing summary", filename);
+    return false;
+  }
+  out << std::setprecision(std::numeric_limits<double>::max_digits10);
+
+  out << "{\n";
+  out << "  \"time_ms\": " << ms.count() << ",\n";
+  out << "  \"peak_memory_bytes\": " << peakMemoryUsage() << ",\n";
+
+  out << "  \"cache\": {\n";
+  writeCacheStatistic(out, "geometry", GeometryCache::instance()->statistics());
+  writeCacheStatistic(out, "function", FunctionCache::instance()->statistics());
+#ifdef ENABLE_CGAL
+  writeCacheStatistic(out, "cgal", CGALCache::instance()->statistics());
+  writeCacheStatistic(out, "decomposition", DecompositionCache::instance()->statistics());
+  out << "    \"disk\": {"
+      << "\"enabled\": " << (DiskCache::instance()->isEnabled() ? "true" : "false") << ", "
+      << "\"hits\": " << DiskCache::instance()->numHits() << ", "
+      << "\"misses\": " << DiskCache::instance()->numMisses() << "}\n";
+#endif // ENABLE_CGAL
+  out << "  },\n";
+
+  out << "  \"operators\": {";
+  bool first = true;
+  for (const auto &timing : timings) {
+    out << (first ? "\n" : ",\n");
+    out << "    \"" << timing.first << "\": {"
+        << "\"count\": " << timing.second.count << ", "
+        << "\"time_ms\": ";
+    writeNumber(out, timing.second.seconds * 1000);
+    out << "}";
+    first = false;
+  }
+  out << (first ? "},\n" : "\n  },\n");
+
+  out << "  \"geometry\": ";
+  if (geom) {
+    GeometryStatistic stat;
+    collectStatistic(*geom, stat);
+    out << "{"
+        << "\"dimension\": " << stat.dimension << ", "
+        << "\"objects\": " << stat.objects << ", "
+        << "\"facets\": " << stat.facets << ", "
+        << "\"vertices\": " << stat.vertices << ", "
+        << "\"volume\": ";
+    writeNumber(out, stat.volume);
+    out << ", \"area\": ";
+    writeNumber(out, stat.area);
+    out << "}\n";
+  }
+  else {
+    out << "null\n";
+  }
+  out << "}\n";
+  return out.good();
+}
+
 void RenderStatistic::print(const Geometry &geom)
 {
   geom.accept(*this);
@@ -27,8 +27,10 @@
 #define RENDERSTATISTIC_H
 
 #include "Geometry.h"
+#include "GeometryEvaluator.h"
 
 #include <chrono>
+#include <string>
 
 /**
  * An utility class to collect and print rendering statistics for the given
@@ -43,8 +45,8 @@ public:
   RenderStatistic() {};
   
   /**
-   * Print some statistic on cache usage. Namely, stats on the @ref GeometryCache
-   * and @ref CGALCache (if enabled).
+   * Print some statistic on cache usage. Namely, stats on the @ref GeometryCache,
+   * @ref FunctionCache and @ref CGALCache (if enabled).
    */
   static void printCacheStatistic();
   
@@ -53,6 +55,19 @@ public:
    * @arg time elapsed by rendering in seconds
    */
   static void printRenderingTime(std::chrono::milliseconds ms);
+
+  /**
+   * Write cache statistics, rendering time, peak memory usage, per-operator
+   * timings and statistics of the resulting geometry as JSON.
+   * @arg filename file to write to
+   * @arg ms time elapsed by rendering
+   * @arg geom resulting geometry, may be nullptr
+   * @arg timings operator timings collected by the GeometryEvaluator
+   * @return false if the file couldn't be written
+   */
+  static bool writeSummary(const std::string &filename, std::chrono::milliseconds ms,
+                           const shared_ptr<const Geometry> &geom,
+                           const GeometryEvaluator::OperatorTimings &timings);
   
   /**
    * Actaully print the statistic based on the given Geometry
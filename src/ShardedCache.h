@@ -0,0 +1,191 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include "cache.h"
+
+/*!
+	A thread-safe Cache, split into N independently locked shards selected by
+	the hash of the key, so threads working on different keys rarely wait
+	for each other.
+
+	The cost limit applies to all shards together. Once an insert exceeds it,
+	entries are evicted across shards in the order the eviction policy would
+	evict them from a single Cache, so sharding doesn't change which entries
+	are kept. Eviction is serialized by a separate lock and only holds one
+	shard lock at a time, so it doesn't block lookups in other shards.
+
+	Objects are copied out by get() while the shard is locked, since another
+	thread may evict them right after the lock is released.
+*/
+template <class Key, class T, size_t N = 16>
+class ShardedCache
+{
+	struct Shard {
+		Cache<Key, T> cache;
+		mutable std::mutex mutex;
+	};
+	typedef std::lock_guard<std::mutex> lock_type;
+
+	std::array<Shard, N> shards;
+	std::atomic<size_t> mx, total;
+	// The highest GreedyDual-Size priority evicted so far, shared by all shards
+	std::atomic<double> clock;
+	std::mutex evictMutex;
+
+	Shard &shard(const Key &key) { return shards[std::hash<Key>()(key) % N]; }
+	const Shard &shard(const Key &key) const { return shards[std::hash<Key>()(key) % N]; }
+
+	// Must be called with the shard locked, after changing it
+	void account(size_t before, size_t after) {
+		if (after >= before) total += after - before;
+		else total -= before - after;
+	}
+	void trim(size_t m);
+
+public:
+	explicit ShardedCache(size_t maxCost = 100) : mx(maxCost), total(0), clock(0) {
+		// A single shard may use up the whole limit
+		for (auto &s : shards) s.cache.setMaxCost(maxCost);
+	}
+
+	size_t maxCost() const { return mx; }
+	void setMaxCost(size_t m);
+	size_t totalCost() const { return total; }
+	void setEvictionPolicy(CacheEvictionPolicy p) {
+		for (auto &s : shards) {
+			lock_type lock(s.mutex);
+			s.cache.setEvictionPolicy(p);
+		}
+	}
+
+	size_t size() const {
+		size_t n = 0;
+		for (const auto &s : shards) {
+			lock_type lock(s.mutex);
+			n += s.cache.size();
+		}
+		return n;
+	}
+
+	bool insert(const Key &key, T *object, size_t cost, double weight = 0);
+	bool contains(const Key &key) const {
+		const auto &s = shard(key);
+		lock_type lock(s.mutex);
+		return s.cache.contains(key);
+	}
+	/*!
+		Copies the cached object into out and returns true, or returns false
+		if not cached. Counts as a lookup in the statistics.
+	*/
+	bool get(const Key &key, T &out) const {
+		const auto &s = shard(key);
+		lock_type lock(s.mutex);
+		const T *object = s.cache.object(key);
+		if (!object) return false;
+		out = *object;
+		return true;
+	}
+	bool remove(const Key &key) {
+		auto &s = shard(key);
+		lock_type lock(s.mutex);
+		const size_t before = s.cache.totalCost();
+		const bool removed = s.cache.remove(key);
+		account(before, s.cache.totalCost());
+		return removed;
+	}
+	void clear() {
+		for (auto &s : shards) {
+			lock_type lock(s.mutex);
+			account(s.cache.totalCost(), 0);
+			s.cache.clear();
+		}
+		clock = 0;
+	}
+
+	CacheStatistics statistics() const {
+		CacheStatistics stats;
+		for (const auto &s : shards) {
+			lock_type lock(s.mutex);
+			const auto st = s.cache.statistics();
+			stats.hits += st.hits;
+			stats.misses += st.misses;
+			stats.inserts += st.inserts;
+			stats.evictions += st.evictions;
+			stats.entries += st.entries;
+		}
+		stats.bytes = total;
+		stats.limit = mx;
+		return stats;
+	}
+	void resetStatistics() {
+		for (auto &s : shards) {
+			lock_type lock(s.mutex);
+			s.cache.resetStatistics();
+		}
+	}
+};
+
+template <class Key, class T, size_t N>
+bool ShardedCache<Key,T,N>::insert(const Key &key, T *object, size_t cost, double weight)
+{
+	bool inserted;
+	{
+		auto &s = shard(key);
+		lock_type lock(s.mutex);
+		// New entries are prioritized relative to evictions from all shards
+		s.cache.advanceClock(clock);
+		const size_t before = s.cache.totalCost();
+		inserted = s.cache.insert(key, object, cost, weight);
+		account(before, s.cache.totalCost());
+	}
+	if (total > mx) trim(mx);
+	return inserted;
+}
+
+template <class Key, class T, size_t N>
+void ShardedCache<Key,T,N>::setMaxCost(size_t m)
+{
+	mx = m;
+	for (auto &s : shards) {
+		lock_type lock(s.mutex);
+		const size_t before = s.cache.totalCost();
+		s.cache.setMaxCost(m);
+		account(before, s.cache.totalCost());
+	}
+	trim(m);
+}
+
+/*!
+	Evicts the globally lowest priority entry until the total cost is at most m.
+	Shards are inspected one at a time; an entry chosen as victim may have been
+	accessed in the meantime, in which case we evict a slightly better entry,
+	which is harmless. Each shard finds its next victim in constant time, so
+	an eviction costs N lookups regardless of the number of entries.
+*/
+template <class Key, class T, size_t N>
+void ShardedCache<Key,T,N>::trim(size_t m)
+{
+	lock_type evictLock(evictMutex);
+	while (total > m) {
+		Shard *victim = nullptr;
+		double lowest = 0;
+		for (auto &s : shards) {
+			double priority;
+			lock_type lock(s.mutex);
+			if (s.cache.nextVictim(priority) && (!victim || priority < lowest)) {
+				victim = &s;
+				lowest = priority;
+			}
+		}
+		if (!victim) break;
+
+		lock_type lock(victim->mutex);
+		const size_t before = victim->cache.totalCost();
+		victim->cache.evictOne();
+		account(before, victim->cache.totalCost());
+		if (victim->cache.evictionPolicy() == CacheEvictionPolicy::CostAware && lowest > clock) clock = lowest;
+	}
+}
@@ -0,0 +1,57 @@
+#include "ThreadPool.h"
+#include "rendersettings.h"
+
+thread_local bool ThreadPool::workerThread = false;
+
+ThreadPool::ThreadPool(size_t numThreads) : stopping(false)
+{
+	if (numThreads < 1) numThreads = 1;
+	this->workers.reserve(numThreads);
+	for (size_t i = 0; i < numThreads; ++i) {
+		this->workers.emplace_back(&ThreadPool::work, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+	}
+	this->condition.notify_all();
+	for (auto &worker : this->workers) worker.join();
+}
+
+void ThreadPool::work()
+{
+	workerThread = true;
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->condition.wait(lock, [this]() { return this->stopping || !this->tasks.empty(); });
+			// Drain the queue before exiting so no enqueued future is left unsatisfied
+			if (this->tasks.empty()) return;
+			task = std::move(this->tasks.front());
+			this->tasks.pop_front();
+		}
+		task();
+	}
+}
+
+size_t ThreadPool::hardwareThreads()
+{
+	auto n = std::thread::hardware_concurrency();
+	return n > 0 ? n : 1;
+}
+
+/*!
+	Returns the number of worker threads to use for parallel geometry
+	evaluation, as configured by the user. A setting of 0 selects one thread
+	per hardware thread.
+*/
+size_t ThreadPool::configuredThreads()
+{
+	auto n = RenderSettings::inst()->threads;
+	return n > 0 ? n : hardwareThreads();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+	A fixed-size pool of worker threads executing queued tasks in FIFO order.
+
+	The destructor waits for all queued and running tasks to finish, so any
+	state captured by reference in a task must outlive the pool.
+
+	Tasks must not call into the GUI or the progress reporting functions;
+	those are only safe to call from the thread which owns the pool.
+*/
+class ThreadPool
+{
+public:
+	explicit ThreadPool(size_t numThreads);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	size_t size() const { return this->workers.size(); }
+
+	template <typename F>
+	std::future<typename std::result_of<F()>::type> enqueue(F &&f);
+
+	static size_t hardwareThreads();
+	static size_t configuredThreads();
+	// True on the threads of any pool, where tasks must not start pools of their own
+	static bool isWorkerThread() { return workerThread; }
+
+private:
+	void work();
+
+	static thread_local bool workerThread;
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stopping;
+};
+
+template <typename F>
+std::future<typename std::result_of<F()>::type> ThreadPool::enqueue(F &&f)
+{
+	typedef typename std::result_of<F()>::type result_type;
+	// std::function requires a copyable target, so keep the task behind a shared_ptr
+	auto task = std::make_shared<std::packaged_task<result_type()>>(std::forward<F>(f));
+	auto result = task->get_future();
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->tasks.emplace_back([task]() { (*task)(); });
+	}
+	this->condition.notify_one();
+	return result;
+}
@@ -0,0 +1,98 @@
+#include "TransformedGeometry.h"
+#include "polyset.h"
+#include "Polygon2d.h"
+#include "clipper-utils.h"
+
+namespace {
+	/*
+		Keeps only the part of a 3D matrix which applies to 2D objects, leaving
+		z untouched. Products of such matrices are again such matrices and
+		have the product of the 2D parts as 2D part, so nested 2D
+		transformations can be collapsed the same way as 3D ones.
+	*/
+	Transform3d embed2D(const Transform3d &m)
+	{
+		Transform3d e(Transform3d::Identity());
+		e(0,0) = m(0,0); e(0,1) = m(0,1); e(0,3) = m(0,3);
+		e(1,0) = m(1,0); e(1,1) = m(1,1); e(1,3) = m(1,3);
+		return e;
+	}
+}
+
+TransformedGeometry::TransformedGeometry(const shared_ptr<const Geometry> &geom, const Transform3d &matrix)
+	: geom(geom), matrix(geom->getDimension() == 2 ? embed2D(matrix) : matrix)
+{
+	if (const auto inner = dynamic_cast<const TransformedGeometry *>(geom.get())) {
+		this->geom = inner->geom;
+		this->matrix = this->matrix * inner->matrix;
+	}
+	this->convexity = geom->getConvexity();
+}
+
+/*!
+	The shared geometry is only charged while this is its sole owner.
+	Otherwise its other owners, e.g. the cache entry of the untransformed
+	geometry or other instances, account for it, and charging it to every
+	wrapper would count it once per instance.
+*/
+size_t TransformedGeometry::memsize() const
+{
+	return sizeof(TransformedGeometry) + (this->geom.use_count() == 1 ? this->geom->memsize() : 0);
+}
+
+/*!
+	Transforms the bounding box of the untransformed geometry, which is exact
+	for translations and scaling, but may be larger than needed for rotations.
+*/
+BoundingBox TransformedGeometry::getBoundingBox() const
+{
+	return this->matrix * this->geom->getBoundingBox();
+}
+
+std::string TransformedGeometry::dump() const
+{
+	return flatten()->dump();
+}
+
+/*!
+	Returns a transformed copy of the geometry.
+*/
+shared_ptr<const Geometry> TransformedGeometry::flatten() const
+{
+	const Transform3d &m = this->matrix;
+	if (const auto poly = dynamic_cast<const Polygon2d *>(this->geom.get())) {
+		Transform2d mat2;
+		mat2.matrix() <<
+			m(0,0), m(0,1), m(0,3),
+			m(1,0), m(1,1), m(1,3),
+			m(3,0), m(3,1), m(3,3);
+		auto newpoly = std::make_shared<Polygon2d>(*poly);
+		newpoly->transform(mat2);
+		// A 2D transformation may flip the winding order of a polygon.
+		// If that happens with a sanitized polygon, we need to reverse
+		// the winding order for it to be correct.
+		if (newpoly->isSanitized() && mat2.matrix().determinant() <= 0) {
+			return shared_ptr<const Geometry>(ClipperUtils::sanitize(*newpoly));
+		}
+		return newpoly;
+	}
+	if (const auto ps = dynamic_cast<const PolySet *>(this->geom.get())) {
+		auto newps = std::make_shared<PolySet>(*ps);
+		newps->transform(m);
+		return newps;
+	}
+	assert(false && "Unsupported geometry type");
+	return this->geom;
+}
+
+/*!
+	Returns geom itself if it isn't a TransformedGeometry, so this can be
+	applied to any geometry which is about to be used.
+*/
+shared_ptr<const Geometry> TransformedGeometry::flatten(const shared_ptr<const Geometry> &geom)
+{
+	if (const auto transformed = dynamic_cast<const TransformedGeometry *>(geom.get())) {
+		return transformed->flatten();
+	}
+	return geom;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Geometry.h"
+#include "linalg.h"
+
+/*!
+	A geometry with a transformation which hasn't been applied yet.
+
+	Transforming cached geometry would otherwise require a full copy of it,
+	so models using many transformed instances of the same part would keep
+	one copy per instance in the cache. Instead, the transformed geometry
+	shares the untransformed one and is only flattened into concrete
+	coordinates when they're needed, e.g. by a boolean operation. Nested
+	transformations collapse into a single matrix.
+
+	Only the GeometryEvaluator creates these; it flattens them before
+	handing geometry to any other consumer, so code outside the evaluator
+	never sees one. Only PolySets and Polygon2ds are wrapped: flattening
+	isn't memoized, and copying a Nef polyhedron for each use would cost
+	more than transforming it once.
+*/
+class TransformedGeometry : public Geometry
+{
+public:
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	TransformedGeometry(const shared_ptr<const Geometry> &geom, const Transform3d &matrix);
+
+	// Visitors see the flattened geometry
+	void accept(class GeometryVisitor &visitor) const override { flatten()->accept(visitor); }
+
+	size_t memsize() const override;
+	BoundingBox getBoundingBox() const override;
+	std::string dump() const override;
+	unsigned int getDimension() const override { return this->geom->getDimension(); }
+	bool isEmpty() const override { return this->geom->isEmpty(); }
+	Geometry *copy() const override { return new TransformedGeometry(*this); }
+	size_t numFacets() const override { return this->geom->numFacets(); }
+
+	const shared_ptr<const Geometry> &getGeometry() const { return this->geom; }
+	const Transform3d &getMatrix() const { return this->matrix; }
+
+	shared_ptr<const Geometry> flatten() const;
+	static shared_ptr<const Geometry> flatten(const shared_ptr<const Geometry> &geom);
+
+private:
+	shared_ptr<const Geometry> geom;
+	// For 2D geometry, only the xy part of the matrix is used, see embed2D()
+	Transform3d matrix;
+};
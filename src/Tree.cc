@@ -34,14 +34,10 @@ const std::string Tree::getString(const AbstractNode &node, const std::string &i
 }
 
 /*!
-	Returns the cached ID string representation of the subtree rooted by \a node.
-	If node is not cached, the cache will be rebuilt.
-
-	The difference between this method and getString() is that the ID string
-	is stripped for whitespace. Especially indentation whitespace is important to
-	strip to enable cache hits for equivalent nodes from different scopes.
+	Returns the node cache holding ID strings and hashes, making sure it
+	contains \a node. If node is not cached, the cache will be rebuilt.
 */
-const std::string Tree::getIdString(const AbstractNode &node) const
+NodeCache &Tree::getIdCache(const AbstractNode &node) const
 {
 	assert(this->root_node);
 	const std::string indent = "";
@@ -57,7 +53,32 @@ const std::string Tree::getIdString(const AbstractNode &node) const
 		assert(nodecache.contains(*this->root_node) &&
 					 "NodeDumper failed to create id cache");
 	}
-	return nodecache[node];
+	return nodecache;
+}
+
+/*!
+	Returns the cached ID string representation of the subtree rooted by \a node.
+	If node is not cached, the cache will be rebuilt.
+
+	The difference between this method and getString() is that the ID string
+	is stripped for whitespace. Especially indentation whitespace is important to
+	strip to enable cache hits for equivalent nodes from different scopes.
+
+	This is mainly useful for diagnostics; use getHash() to identify subtrees.
+*/
+const std::string Tree::getIdString(const AbstractNode &node) const
+{
+	return getIdCache(node)[node];
+}
+
+/*!
+	Returns a hash of the ID string of the subtree rooted by \a node. Unlike
+	the ID string itself, it is cheap to copy, hash and compare, which makes
+	it suitable as a cache key.
+*/
+NodeHash Tree::getHash(const AbstractNode &node) const
+{
+	return getIdCache(node).hash(node);
 }
 
 /*!
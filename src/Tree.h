@@ -21,9 +21,12 @@ public:
 
 	const std::string getString(const AbstractNode &node, const std::string &indent) const;
 	const std::string getIdString(const AbstractNode &node) const;
+	NodeHash getHash(const AbstractNode &node) const;
 	const std::string getDocumentPath() const;
 
 private:
+	NodeCache &getIdCache(const AbstractNode &node) const;
+
 	const AbstractNode *root_node;
 	// keep a separate nodecache per tuple of NodeDumper constructor parameters
 	mutable std::map<std::tuple<std::string, bool>, NodeCache>  nodecachemap;
@@ -0,0 +1,44 @@
+#include "VariableSlot.h"
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+	struct SlotTable {
+		std::mutex mutex;
+		std::unordered_map<std::string, unsigned int> slots;
+		// A deque keeps references to names valid while it grows
+		std::deque<std::string> names;
+	};
+
+	// Builtins may resolve names during static initialization
+	SlotTable &table()
+	{
+		static SlotTable table;
+		return table;
+	}
+
+	// $children is not a config_variable. config_variables have dynamic scope,
+	// meaning they are passed down the call chain implicitly.
+	// $children is simply misnamed and shouldn't have included the '$'.
+	bool is_config_variable(const std::string &name)
+	{
+		return name[0] == '$' && name != "$children";
+	}
+}
+
+VariableSlot::VariableSlot(const std::string &name) : config(is_config_variable(name))
+{
+	auto &t = table();
+	std::lock_guard<std::mutex> lock(t.mutex);
+	auto inserted = t.slots.emplace(name, t.names.size());
+	if (inserted.second) t.names.push_back(name);
+	this->id = inserted.first->second;
+}
+
+const std::string &VariableSlot::name() const
+{
+	auto &t = table();
+	std::lock_guard<std::mutex> lock(t.mutex);
+	return t.names[this->id];
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+
+/*!
+	Identifies a variable by a number instead of by its name.
+
+	Each name resolves to the same slot for the lifetime of the program.
+	Lookup and Assignment resolve their names once, when the AST is built,
+	so contexts can store variables by slot and find them by comparing
+	integers rather than hashing the name in every context on the way.
+	The name itself is only needed again for messages.
+*/
+class VariableSlot
+{
+public:
+	explicit VariableSlot(const std::string &name);
+
+	const std::string &name() const;
+	bool isConfigVariable() const { return this->config; }
+
+	bool operator==(const VariableSlot &other) const { return this->id == other.id; }
+	bool operator!=(const VariableSlot &other) const { return this->id != other.id; }
+	bool operator<(const VariableSlot &other) const { return this->id < other.id; }
+
+private:
+	unsigned int id;
+	// Config variables are dynamically scoped, see isConfigVariable()
+	bool config;
+};
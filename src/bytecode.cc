@@ -0,0 +1,591 @@
+#include "bytecode.h"
+#include "expression.h"
+#include "function.h"
+#include "evalcontext.h"
+#include "exceptions.h"
+#include "printutils.h"
+#include <cmath>
+
+typedef Bytecode::OpCode OpCode;
+
+namespace {
+	/*
+		Operand stack and lists under construction, shared by all calls on a
+		thread so calls don't allocate their own. Each call only uses the
+		part above its base, and truncates it to the base again when it
+		returns or throws.
+	*/
+	template <typename T>
+	class SharedStack
+	{
+	public:
+		SharedStack(std::vector<T> &stack) : stack(stack), base(stack.size()) {}
+		~SharedStack() { this->stack.resize(this->base); }
+
+		void push(T value) { this->stack.push_back(std::move(value)); }
+		T pop() {
+			T value = std::move(this->stack.back());
+			this->stack.pop_back();
+			return value;
+		}
+		T &top() { return this->stack.back(); }
+
+	private:
+		std::vector<T> &stack;
+		const size_t base;
+	};
+
+	thread_local std::vector<ValuePtr> operands;
+	thread_local std::vector<Value::VectorType> lists;
+
+	const ValuePtr TRUE(true);
+	const ValuePtr FALSE(false);
+	const ValuePtr INDEX[] = { ValuePtr(0), ValuePtr(1), ValuePtr(2) };
+
+	/*
+		The values a for loop iterates over, like LcFor::evaluate()
+	*/
+	struct Loop {
+		VariableSlot slot;
+		ValuePtr values;
+		double begin, step;
+		Value::VectorType characters;
+		size_t next;
+		size_t count;
+
+		Loop(const VariableSlot &slot, const ValuePtr &values) : slot(slot), values(values), begin(0), step(0), next(0), count(0) {}
+
+		ValuePtr value(size_t i) const {
+			switch (this->values->type()) {
+			case Value::ValueType::RANGE:
+				// Same values as RangeType::iterator
+				return ValuePtr(i == 0 ? this->begin : this->begin + this->step * i);
+			case Value::ValueType::VECTOR:
+				return this->values->toVector()[i];
+			case Value::ValueType::STRING:
+				return this->characters[i];
+			default:
+				return this->values;
+			}
+		}
+	};
+
+	void print_range_warning(uint32_t steps, const Expression &node, const std::shared_ptr<Context> &ctx)
+	{
+		PRINTB("WARNING: Bad range parameter in for statement: too many elements (%lu), %s", steps % node.location().toRelativeString(ctx->documentPath()));
+	}
+}
+
+shared_ptr<const Bytecode> Bytecode::compile(const UserFunction &function)
+{
+	shared_ptr<Bytecode> bytecode(new Bytecode(function));
+	BytecodeCompiler compiler(*bytecode);
+	compiler.compile(*function.expr, true);
+	compiler.emit(OpCode::Return);
+	return bytecode;
+}
+
+/*!
+	Calls the function, like evaluate_function().
+*/
+ValuePtr Bytecode::call(const std::shared_ptr<Context> &c_next) const
+{
+	unsigned int counter = 0;
+	while (true) {
+		ContextStack scopes;
+		scopes.emplace_front(std::shared_ptr<Context>(new Context(c_next)));
+		ValuePtr result;
+		const FunctionCall *tailCall = execute(scopes, result);
+		if (!tailCall) return result;
+
+		// Update c_next with new parameters for tail call
+		tailCall->prepareTailCallContext(scopes.front().ctx, c_next, this->function.definition_arguments);
+		if (counter++ == 1000000) {
+			const std::string locs = this->function.location().toRelativeString(c_next->documentPath());
+			PRINTB("ERROR: Recursion detected calling function '%s' %s", this->function.name % locs);
+			throw RecursionException::create("function", this->function.name, this->function.location());
+		}
+	}
+}
+
+void Bytecode::startContext(ContextStack &scopes) const
+{
+	scopes.emplace_front(std::shared_ptr<Context>(new Context(scopes.front().ctx)));
+}
+
+/*!
+	Runs the bytecode in the innermost of scopes until it returns a result,
+	or until it calls the function itself as its last step, in which case
+	it returns the call.
+*/
+const FunctionCall *Bytecode::execute(ContextStack &scopes, ValuePtr &result) const
+{
+	SharedStack<ValuePtr> stack(operands);
+	SharedStack<Value::VectorType> list(lists);
+	std::vector<Loop> loops;
+
+	size_t pc = 0;
+	while (true) {
+		const Instruction &i = this->code[pc++];
+		const std::shared_ptr<Context> &ctx = scopes.front().ctx;
+		switch (i.op) {
+		case OpCode::Constant:
+			stack.push(this->constants[i.arg]);
+			break;
+		case OpCode::Lookup:
+			stack.push(ctx->lookup_variable(this->slots[i.arg], false, i.node->location()));
+			break;
+		case OpCode::Evaluate:
+			stack.push(i.node->evaluate(ctx));
+			break;
+		case OpCode::Not:
+			stack.top() = !stack.top();
+			break;
+		case OpCode::Negate:
+			stack.top() = -stack.top();
+			break;
+		case OpCode::Exponent: {
+			const ValuePtr right = stack.pop();
+			stack.top() = ValuePtr(pow(stack.top()->toDouble(), right->toDouble()));
+			break;
+		}
+		case OpCode::Multiply: {
+			const ValuePtr right = stack.pop();
+			stack.top() = stack.top() * right;
+			break;
+		}
+		case OpCode::Divide: {
+			const ValuePtr right = stack.pop();
+			stack.top() = stack.top() / right;
+			break;
+		}
+		case OpCode::Modulo: {
+			const ValuePtr right = stack.pop();
+			stack.top() = stack.top() % right;
+			break;
+		}
+		case OpCode::Plus: {
+			const ValuePtr right = stack.pop();
+			stack.top() = stack.top() + right;
+			break;
+		}
+		case OpCode::Minus: {
+			const ValuePtr right = stack.pop();
+			stack.top() = stack.top() - right;
+			break;
+		}
+		case OpCode::Less: {
+			const ValuePtr right = stack.pop();
+			stack.top() = stack.top() < right ? TRUE : FALSE;
+			break;
+		}
+		case OpCode::LessEqual: {
+			const ValuePtr right = stack.pop();
+			stack.top() = stack.top() <= right ? TRUE : FALSE;
+			break;
+		}
+		case OpCode::Greater: {
+			const ValuePtr right = stack.pop();
+			stack.top() = stack.top() > right ? TRUE : FALSE;
+			break;
+		}
+		case OpCode::GreaterEqual: {
+			const ValuePtr right = stack.pop();
+			stack.top() = stack.top() >= right ? TRUE : FALSE;
+			break;
+		}
+		case OpCode::Equal: {
+			const ValuePtr right = stack.pop();
+			stack.top() = stack.top() == right ? TRUE : FALSE;
+			break;
+		}
+		case OpCode::NotEqual: {
+			const ValuePtr right = stack.pop();
+			stack.top() = stack.top() != right ? TRUE : FALSE;
+			break;
+		}
+		case OpCode::Truth:
+			stack.top() = stack.top() ? TRUE : FALSE;
+			break;
+		case OpCode::Index: {
+			const ValuePtr index = stack.pop();
+			stack.top() = stack.top()[index];
+			break;
+		}
+		case OpCode::Member: {
+			// Members 0-2 are x, y and z of vectors, 3-5 begin, step and end of ranges
+			const auto type = stack.top()->type();
+			if (i.arg >= 0 && i.arg < 3 && type == Value::ValueType::VECTOR) stack.top() = stack.top()[INDEX[i.arg]];
+			else if (i.arg >= 3 && type == Value::ValueType::RANGE) stack.top() = stack.top()[INDEX[i.arg - 3]];
+			else stack.top() = ValuePtr::undefined;
+			break;
+		}
+		case OpCode::Jump:
+			pc = i.arg;
+			break;
+		case OpCode::JumpIfFalse: {
+			const bool condition = stack.pop();
+			if (!condition) pc = i.arg;
+			break;
+		}
+		case OpCode::JumpIfTrue: {
+			const bool condition = stack.pop();
+			if (condition) pc = i.arg;
+			break;
+		}
+		case OpCode::PushContext:
+			startContext(scopes);
+			break;
+		case OpCode::PopContext:
+			scopes.pop_front();
+			break;
+		case OpCode::Assign: {
+			// Like EvalContext::assignTo()
+			const Assignment &assignment = *this->assignments[i.arg];
+			const ValuePtr v = stack.pop();
+			if (assignment.name.empty()) {
+				PRINTB("WARNING: Assignment without variable name %s, %s", v->toEchoString() % i.node->location().toRelativeString(ctx->documentPath()));
+			} else if (ctx->has_local_variable(assignment.slot)) {
+				PRINTB("WARNING: Ignoring duplicate variable assignment %s = %s, %s", assignment.name % v->toEchoString() % i.node->location().toRelativeString(ctx->documentPath()));
+			} else {
+				ctx->set_variable(assignment.slot, v);
+			}
+			break;
+		}
+		case OpCode::Assert:
+			static_cast<const class Assert *>(i.node)->evaluateStep(ctx);
+			break;
+		case OpCode::Echo:
+			static_cast<const class Echo *>(i.node)->evaluateStep(ctx);
+			break;
+		case OpCode::NewList:
+			list.push(Value::VectorType());
+			break;
+		case OpCode::Append:
+			list.top().push_back(stack.pop());
+			break;
+		case OpCode::Extend: {
+			const ValuePtr v = stack.pop();
+			const auto &elements = v->toVector();
+			list.top().insert(list.top().end(), elements.begin(), elements.end());
+			break;
+		}
+		case OpCode::Each: {
+			// Like LcEach::evaluate()
+			const ValuePtr v = stack.pop();
+			if (v->type() == Value::ValueType::RANGE) {
+				RangeType range = v->toRange();
+				uint32_t steps = range.numValues();
+				if (steps >= 1000000) {
+					print_range_warning(steps, *i.node, ctx);
+				} else {
+					for (RangeType::iterator it = range.begin();it != range.end();it++) {
+						list.top().push_back(ValuePtr(*it));
+					}
+				}
+			} else if (v->type() == Value::ValueType::VECTOR) {
+				const auto &elements = v->toVector();
+				list.top().insert(list.top().end(), elements.begin(), elements.end());
+			} else if (v->type() == Value::ValueType::STRING) {
+				utf8_split(v->toString(), [&](ValuePtr v) {
+					list.top().push_back(v);
+				});
+			} else if (v->type() != Value::ValueType::UNDEFINED) {
+				list.top().push_back(v);
+			}
+			break;
+		}
+		case OpCode::EndList:
+			stack.push(ValuePtr(list.pop()));
+			break;
+		case OpCode::ForBegin: {
+			// Like LcFor::evaluate()
+			loops.emplace_back(this->slots[i.arg], stack.pop());
+			Loop &loop = loops.back();
+			if (loop.values->type() == Value::ValueType::RANGE) {
+				RangeType range = loop.values->toRange();
+				uint32_t steps = range.numValues();
+				if (steps >= 1000000) {
+					print_range_warning(steps, *i.node, ctx);
+				} else if (range.step_value() != 0) {
+					loop.begin = range.begin_value();
+					loop.step = range.step_value();
+					loop.count = steps;
+				}
+			} else if (loop.values->type() == Value::ValueType::VECTOR) {
+				loop.count = loop.values->toVector().size();
+			} else if (loop.values->type() == Value::ValueType::STRING) {
+				utf8_split(loop.values->toString(), [&](ValuePtr v) {
+					loop.characters.push_back(v);
+				});
+				loop.count = loop.characters.size();
+			} else if (loop.values->type() != Value::ValueType::UNDEFINED) {
+				loop.count = 1;
+			}
+			startContext(scopes);
+			break;
+		}
+		case OpCode::ForNext: {
+			Loop &loop = loops.back();
+			if (loop.next < loop.count) {
+				ctx->set_variable(loop.slot, loop.value(loop.next++));
+			} else {
+				loops.pop_back();
+				scopes.pop_front();
+				pc = i.arg;
+			}
+			break;
+		}
+		case OpCode::TailCall:
+			return static_cast<const FunctionCall *>(i.node);
+		case OpCode::Return:
+			result = stack.pop();
+			return nullptr;
+		}
+	}
+}
+
+void BytecodeCompiler::compile(const Expression &expr, bool tail)
+{
+	expr.compile(*this, tail);
+}
+
+void BytecodeCompiler::compileElements(const shared_ptr<Expression> &expr)
+{
+	if (const auto lc = dynamic_cast<const ListComprehension *>(expr.get())) {
+		lc->compileElements(*this);
+	} else {
+		compile(*expr);
+		emit(OpCode::Append);
+	}
+}
+
+void BytecodeCompiler::compileAssignments(const AssignmentList &assignments, const Expression &node)
+{
+	for (const auto &assignment : assignments) {
+		if (assignment->expr) compile(*assignment->expr);
+		else emitConstant(ValuePtr());
+		emit(OpCode::Assign, this->bytecode.assignments.size(), &node);
+		this->bytecode.assignments.push_back(assignment.get());
+	}
+}
+
+size_t BytecodeCompiler::emit(OpCode op, int arg, const Expression *node)
+{
+	this->bytecode.code.emplace_back(op, arg, node);
+	return this->bytecode.code.size() - 1;
+}
+
+void BytecodeCompiler::emitConstant(const ValuePtr &value)
+{
+	emit(OpCode::Constant, this->bytecode.constants.size());
+	this->bytecode.constants.push_back(value);
+}
+
+size_t BytecodeCompiler::emitSlot(OpCode op, const VariableSlot &slot, const Expression *node)
+{
+	this->bytecode.slots.push_back(slot);
+	return emit(op, this->bytecode.slots.size() - 1, node);
+}
+
+void BytecodeCompiler::patch(size_t jump)
+{
+	this->bytecode.code[jump].arg = position();
+}
+
+const std::string &BytecodeCompiler::functionName() const
+{
+	return this->bytecode.function.name;
+}
+
+void Expression::compile(BytecodeCompiler &compiler, bool) const
+{
+	compiler.emit(OpCode::Evaluate, this);
+}
+
+void UnaryOp::compile(BytecodeCompiler &compiler, bool) const
+{
+	compiler.compile(*this->expr);
+	switch (this->op) {
+	case Op::Not:
+		compiler.emit(OpCode::Not);
+		break;
+	case Op::Negate:
+		compiler.emit(OpCode::Negate);
+		break;
+	default:
+		compiler.emit(OpCode::Evaluate, this);
+	}
+}
+
+void BinaryOp::compile(BytecodeCompiler &compiler, bool) const
+{
+	if (this->op == Op::LogicalAnd || this->op == Op::LogicalOr) {
+		compiler.compile(*this->left);
+		size_t shortcut = compiler.emit(this->op == Op::LogicalAnd ? OpCode::JumpIfFalse : OpCode::JumpIfTrue);
+		compiler.compile(*this->right);
+		compiler.emit(OpCode::Truth);
+		size_t end = compiler.emit(OpCode::Jump);
+		compiler.patch(shortcut);
+		compiler.emitConstant(ValuePtr(this->op == Op::LogicalOr));
+		compiler.patch(end);
+		return;
+	}
+
+	compiler.compile(*this->left);
+	compiler.compile(*this->right);
+	switch (this->op) {
+	case Op::Exponent:     compiler.emit(OpCode::Exponent); break;
+	case Op::Multiply:     compiler.emit(OpCode::Multiply); break;
+	case Op::Divide:       compiler.emit(OpCode::Divide); break;
+	case Op::Modulo:       compiler.emit(OpCode::Modulo); break;
+	case Op::Plus:         compiler.emit(OpCode::Plus); break;
+	case Op::Minus:        compiler.emit(OpCode::Minus); break;
+	case Op::Less:         compiler.emit(OpCode::Less); break;
+	case Op::LessEqual:    compiler.emit(OpCode::LessEqual); break;
+	case Op::Greater:      compiler.emit(OpCode::Greater); break;
+	case Op::GreaterEqual: compiler.emit(OpCode::GreaterEqual); break;
+	case Op::Equal:        compiler.emit(OpCode::Equal); break;
+	case Op::NotEqual:     compiler.emit(OpCode::NotEqual); break;
+	default:
+		// Unknown operators evaluate to undef
+		compiler.emitConstant(ValuePtr::undefined);
+	}
+}
+
+void TernaryOp::compile(BytecodeCompiler &compiler, bool tail) const
+{
+	compiler.compile(*this->cond);
+	size_t otherwise = compiler.emit(OpCode::JumpIfFalse);
+	compiler.compile(*this->ifexpr, tail);
+	size_t end = compiler.emit(OpCode::Jump);
+	compiler.patch(otherwise);
+	compiler.compile(*this->elseexpr, tail);
+	compiler.patch(end);
+}
+
+void ArrayLookup::compile(BytecodeCompiler &compiler, bool) const
+{
+	compiler.compile(*this->array);
+	compiler.compile(*this->index);
+	compiler.emit(OpCode::Index);
+}
+
+void Literal::compile(BytecodeCompiler &compiler, bool) const
+{
+	compiler.emitConstant(this->value);
+}
+
+void Vector::compile(BytecodeCompiler &compiler, bool) const
+{
+	compiler.emit(OpCode::NewList);
+	for (const auto &e : this->children) {
+		compiler.compileElements(e);
+	}
+	compiler.emit(OpCode::EndList);
+}
+
+void Lookup::compile(BytecodeCompiler &compiler, bool) const
+{
+	compiler.emitSlot(OpCode::Lookup, this->slot, this);
+}
+
+void MemberLookup::compile(BytecodeCompiler &compiler, bool) const
+{
+	static const char *members[] = { "x", "y", "z", "begin", "step", "end" };
+	int member = -1;
+	for (int i = 0; i < 6; i++) {
+		if (this->member == members[i]) member = i;
+	}
+	compiler.compile(*this->expr);
+	compiler.emit(OpCode::Member, member);
+}
+
+void FunctionCall::compile(BytecodeCompiler &compiler, bool tail) const
+{
+	if (tail && this->name == compiler.functionName()) compiler.emit(OpCode::TailCall, this);
+	else compiler.emit(OpCode::Evaluate, this);
+}
+
+void Assert::compile(BytecodeCompiler &compiler, bool tail) const
+{
+	compiler.emit(OpCode::Assert, this);
+	if (this->expr) compiler.compile(*this->expr, tail);
+	else compiler.emitConstant(ValuePtr::undefined);
+}
+
+void Echo::compile(BytecodeCompiler &compiler, bool tail) const
+{
+	compiler.emit(OpCode::Echo, this);
+	if (this->expr) compiler.compile(*this->expr, tail);
+	else compiler.emitConstant(ValuePtr::undefined);
+}
+
+void Let::compile(BytecodeCompiler &compiler, bool tail) const
+{
+	compiler.emit(OpCode::PushContext);
+	compiler.compileAssignments(this->arguments, *this);
+	compiler.compile(*this->expr, tail);
+	// Contexts of the returned expression are released on return
+	if (!tail) compiler.emit(OpCode::PopContext);
+}
+
+void ListComprehension::compile(BytecodeCompiler &compiler, bool) const
+{
+	compiler.emit(OpCode::NewList);
+	compileElements(compiler);
+	compiler.emit(OpCode::EndList);
+}
+
+void ListComprehension::compileElements(BytecodeCompiler &compiler) const
+{
+	compiler.emit(OpCode::Evaluate, this);
+	compiler.emit(OpCode::Extend);
+}
+
+void LcIf::compileElements(BytecodeCompiler &compiler) const
+{
+	compiler.compile(*this->cond);
+	size_t otherwise = compiler.emit(OpCode::JumpIfFalse);
+	compiler.compileElements(this->ifexpr);
+	if (this->elseexpr) {
+		size_t end = compiler.emit(OpCode::Jump);
+		compiler.patch(otherwise);
+		compiler.compileElements(this->elseexpr);
+		compiler.patch(end);
+	} else {
+		compiler.patch(otherwise);
+	}
+}
+
+void LcFor::compileElements(BytecodeCompiler &compiler) const
+{
+	// The parser reduces comprehension for statements to a single variable
+	const auto &arg = this->arguments[0];
+	if (arg->expr) compiler.compile(*arg->expr);
+	else compiler.emitConstant(ValuePtr());
+	compiler.emitSlot(OpCode::ForBegin, arg->slot, this);
+	size_t next = compiler.emit(OpCode::ForNext);
+	compiler.compileElements(this->expr);
+	compiler.emit(OpCode::Jump, next);
+	compiler.patch(next);
+}
+
+void LcEach::compileElements(BytecodeCompiler &compiler) const
+{
+	// each of a list comprehension also flattens the elements, see LcEach::evaluate()
+	if (dynamic_cast<const ListComprehension *>(this->expr.get())) {
+		ListComprehension::compileElements(compiler);
+		return;
+	}
+	compiler.compile(*this->expr);
+	compiler.emit(OpCode::Each, this);
+}
+
+void LcLet::compileElements(BytecodeCompiler &compiler) const
+{
+	compiler.emit(OpCode::PushContext);
+	compiler.compileAssignments(this->arguments, *this);
+	compiler.compileElements(this->expr);
+	compiler.emit(OpCode::PopContext);
+}
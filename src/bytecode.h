@@ -0,0 +1,124 @@
+#pragma once
+
+#include <forward_list>
+#include <vector>
+#include "value.h"
+#include "context.h"
+#include "VariableSlot.h"
+#include "memory.h"
+
+/*!
+	The body of a user function, lowered into a compact stack bytecode.
+
+	The tree walker in expr.cc recurses through a virtual evaluate() call
+	for every node. Compiled, operators, variable lookups, vectors, let(),
+	assert(), echo(), the ternary operator and list comprehensions run as a
+	flat instruction sequence on an operand stack shared by all calls, and
+	tail calls of the function to itself become jumps. Nodes which aren't
+	lowered, such as other function calls, ranges and function literals,
+	are evaluated by the tree walker from within the bytecode.
+
+	The tree walker remains the reference: the bytecode creates the same
+	contexts and prints the same messages, in the same order. It is only
+	used with the "bytecode" experimental feature enabled.
+*/
+class Bytecode
+{
+public:
+	enum class OpCode {
+		Constant,     // Push constants[arg]
+		Lookup,       // Push the value of variable slots[arg]
+		Evaluate,     // Push node->evaluate()
+		Not,
+		Negate,
+		Exponent,
+		Multiply,
+		Divide,
+		Modulo,
+		Plus,
+		Minus,
+		Less,
+		LessEqual,
+		Greater,
+		GreaterEqual,
+		Equal,
+		NotEqual,
+		Truth,        // Replace the top with its truth value
+		Index,        // Pop index and value, push value[index]
+		Member,       // Replace the top with its member arg, see MemberLookup
+		Jump,         // Continue at arg
+		JumpIfFalse,  // Pop, continue at arg if it is false
+		JumpIfTrue,   // Pop, continue at arg if it is true
+		PushContext,  // Start a nested context for let()
+		PopContext,
+		Assign,       // Pop, assign to assignments[arg] in the current context
+		Assert,       // Run the assertion of node
+		Echo,         // Print the echo() of node
+		NewList,      // Start a list, for vectors and list comprehensions
+		Append,       // Pop, append to the current list
+		Extend,       // Pop, append its elements to the current list
+		Each,         // Pop, append its elements like each does
+		EndList,      // Push the current list
+		ForBegin,     // Pop the values of a for loop over slots[arg] in a new context
+		ForNext,      // Assign the next value of the loop, or end it and continue at arg
+		TailCall,     // Call the function itself with the arguments of node
+		Return
+	};
+
+	struct Instruction {
+		Instruction(OpCode op, int arg, const class Expression *node) : op(op), arg(arg), node(node) {}
+		OpCode op;
+		int arg;
+		// Node for fallbacks, locations and messages
+		const Expression *node;
+	};
+
+	static shared_ptr<const Bytecode> compile(const class UserFunction &function);
+
+	// Runs the function with the arguments of the call set in c_next
+	ValuePtr call(const std::shared_ptr<Context> &c_next) const;
+
+private:
+	Bytecode(const UserFunction &function) : function(function) {}
+
+	typedef std::forward_list<ContextHandle<Context>> ContextStack;
+	const class FunctionCall *execute(ContextStack &scopes, ValuePtr &result) const;
+	void startContext(ContextStack &scopes) const;
+
+	const UserFunction &function;
+	std::vector<Instruction> code;
+	std::vector<ValuePtr> constants;
+	std::vector<VariableSlot> slots;
+	std::vector<const class Assignment *> assignments;
+
+	friend class BytecodeCompiler;
+};
+
+/*!
+	Emits the bytecode of a function body. Each Expression lowers itself
+	through compile(), which by default falls back to evaluate().
+*/
+class BytecodeCompiler
+{
+public:
+	BytecodeCompiler(Bytecode &bytecode) : bytecode(bytecode) {}
+
+	// tail is true for the expression whose value the function returns
+	void compile(const Expression &expr, bool tail = false);
+	// Lowers the elements of a list comprehension, or appends a value
+	void compileElements(const shared_ptr<Expression> &expr);
+	void compileAssignments(const AssignmentList &assignments, const Expression &node);
+
+	size_t emit(Bytecode::OpCode op, int arg = 0, const Expression *node = nullptr);
+	size_t emit(Bytecode::OpCode op, const Expression *node) { return emit(op, 0, node); }
+	void emitConstant(const ValuePtr &value);
+	size_t emitSlot(Bytecode::OpCode op, const VariableSlot &slot, const Expression *node);
+	// Makes the jump at the given position continue at the next instruction
+	void patch(size_t jump);
+	size_t position() const { return this->bytecode.code.size(); }
+
+	const std::string &functionName() const;
+
+private:
+	Bytecode &bytecode;
+};
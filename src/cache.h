@@ -44,32 +44,93 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <map>
 #include <unordered_map>
+#include <utility>
 #include <boost/format.hpp>
 #include "printutils.h"
 
+/*!
+	LeastRecentlyUsed evicts the entry which hasn't been accessed for the
+	longest time.
+
+	CostAware implements GreedyDual-Size: every entry gets a priority of
+	clock + weight/cost, refreshed on each access, and the entry with the
+	lowest priority is evicted first, advancing the clock to its priority.
+	Entries which were expensive to build relative to their size thus stay
+	longer, while unused entries still age out eventually. Entries are kept
+	ordered by priority, so finding the next victim takes constant time.
+*/
+enum class CacheEvictionPolicy { LeastRecentlyUsed, CostAware };
+
+/*!
+	Usage counters of a Cache. Only fetching an object with object() or
+	operator[] counts as a lookup; contains() is a plain existence check.
+*/
+struct CacheStatistics {
+	CacheStatistics() : hits(0), misses(0), inserts(0), evictions(0), entries(0), bytes(0), limit(0) {}
+	size_t hits, misses, inserts, evictions;
+	size_t entries, bytes, limit;
+};
+
+// A clock shared by all caches, so access times of entries in different caches can be compared
+inline uint64_t cacheTick()
+{
+	static std::atomic<uint64_t> tick(0);
+	return ++tick;
+}
+
 template <class Key, class T>
 class Cache
 {
+	struct Node;
+	// Ordered by GreedyDual-Size priority, ties broken by access time, i.e. LRU-style
+	typedef std::map<std::pair<double, uint64_t>, Node *> queue_type;
 	struct Node {
-		inline Node() : keyPtr(nullptr), t(nullptr), c(0), p(nullptr), n(nullptr) {}
-		inline Node(T *data, size_t cost) : keyPtr(nullptr), t(data), c(cost), p(nullptr), n(nullptr) {}
-		const Key *keyPtr; T *t; size_t c; Node *p,*n;
+		inline Node() : keyPtr(nullptr), t(nullptr), c(0), w(0), h(0), a(0), p(nullptr), n(nullptr), queued(false) {}
+		inline Node(T *data, size_t cost, double weight) : keyPtr(nullptr), t(data), c(cost), w(weight), h(0), a(0), p(nullptr), n(nullptr), queued(false) {}
+		// c: size cost, w: weight (time to rebuild), h: GreedyDual-Size priority, a: last access tick
+		const Key *keyPtr; T *t; size_t c; double w, h; uint64_t a; Node *p,*n;
+		// q: position in the priority queue, only valid if queued
+		bool queued; typename queue_type::iterator q;
 	};
 	typedef typename std::unordered_map<Key, Node> map_type;
 	typedef typename map_type::iterator iterator_type;
 	typedef typename map_type::value_type value_type;
 
 	std::unordered_map<Key, Node> hash;
+	// Only maintained for the CostAware policy
+	queue_type queue;
 	Node *f, *l;
 	void *unused;
 	size_t mx, total;
+	CacheEvictionPolicy policy;
+	double clock;
+	mutable CacheStatistics stats;
+
+	inline void prioritize(Node &n) {
+		dequeue(n);
+		n.h = clock + n.w / (n.c > 0 ? n.c : 1);
+		n.a = cacheTick();
+		if (policy == CacheEvictionPolicy::CostAware) enqueue(n);
+	}
+	inline void enqueue(Node &n) {
+		n.q = queue.emplace(std::make_pair(n.h, n.a), &n).first;
+		n.queued = true;
+	}
+	inline void dequeue(Node &n) {
+		if (n.queued) queue.erase(n.q);
+		n.queued = false;
+	}
 
 	inline void unlink(Node &n) {
 		if (n.p) n.p->n = n.n;
 		if (n.n) n.n->p = n.p;
 		if (l == &n) l = n.p;
 		if (f == &n) f = n.n;
+		dequeue(n);
 		total -= n.c;
 		T *obj = n.t;
 		hash.erase(*n.keyPtr);
@@ -77,9 +138,14 @@ class Cache
 	}
 	inline T *relink(const Key &key) {
 		iterator_type i = hash.find(key);
-		if (i == hash.end()) return nullptr;
+		if (i == hash.end()) {
+			stats.misses++;
+			return nullptr;
+		}
+		stats.hits++;
 
 		Node &n = i->second;
+		prioritize(n);
 		if (f != &n) {
 			if (n.p) n.p->n = n.n;
 			if (n.n) n.n->p = n.p;
@@ -94,33 +160,74 @@ class Cache
 
 public:
 	inline explicit Cache(size_t maxCost = 100)
-		: f(nullptr), l(nullptr), unused(nullptr), mx(maxCost), total(0) { }
+		: f(nullptr), l(nullptr), unused(nullptr), mx(maxCost), total(0),
+			policy(CacheEvictionPolicy::LeastRecentlyUsed), clock(0) { }
 	inline ~Cache() { clear(); }
 
 	inline size_t maxCost() const { return mx; }
 	void setMaxCost(size_t m) { mx = m; trim(mx); }
 	inline size_t totalCost() const { return total; }
+	inline CacheEvictionPolicy evictionPolicy() const { return policy; }
+	void setEvictionPolicy(CacheEvictionPolicy p);
 
 	inline size_t size() const { return hash.size(); }
 	inline bool empty() const { return hash.empty(); }
 
 	void clear() {
 		while (f) { delete f->t; f = f->n; }
-		hash.clear(); l = nullptr; total = 0;
+		hash.clear(); queue.clear(); l = nullptr; total = 0; clock = 0;
 	}
 
-	bool insert(const Key &key, T *object, size_t cost);
+	bool insert(const Key &key, T *object, size_t cost, double weight = 0);
 	T *object(const Key &key) const { return const_cast<Cache<Key,T>*>(this)->relink(key); }
 	inline bool contains(const Key &key) const { return hash.find(key) != hash.end(); }
 	T *operator[](const Key &key) const { return object(key); }
 
+	CacheStatistics statistics() const {
+		CacheStatistics s = stats;
+		s.entries = size();
+		s.bytes = total;
+		s.limit = mx;
+		return s;
+	}
+	void resetStatistics() { stats = CacheStatistics(); }
+
+	/*!
+		Returns false if empty, otherwise the priority of the entry which would
+		be evicted next; lower priorities are evicted first. Priorities of
+		caches using the same policy are comparable, which allows evicting
+		across several caches.
+	*/
+	bool nextVictim(double &priority) const {
+		const Node *u = victim();
+		if (!u) return false;
+		priority = policy == CacheEvictionPolicy::CostAware ? u->h : static_cast<double>(u->a);
+		return true;
+	}
+	void evictOne() { if (Node *u = victim()) evict(*u); }
+	// Moves the GreedyDual-Size clock forward, e.g. to follow evictions from other caches
+	void advanceClock(double c) { if (c > clock) clock = c; }
+
 	bool remove(const Key &key);
 	T *take(const Key &key);
 
 private:
+	Node *victim() const;
+	void evict(Node &n);
 	void trim(size_t m);
 };
 
+template <class Key, class T>
+void Cache<Key,T>::setEvictionPolicy(CacheEvictionPolicy p)
+{
+	if (p == policy) return;
+	policy = p;
+	for (Node *n = l; n; n = n->p) {
+		if (policy == CacheEvictionPolicy::CostAware) enqueue(*n);
+		else dequeue(*n);
+	}
+}
+
 template <class Key, class T>
 inline bool Cache<Key,T>::remove(const Key &key)
 {
@@ -147,7 +254,7 @@ inline T *Cache<Key,T>::take(const Key &key)
 }
 
 template <class Key, class T>
-bool Cache<Key,T>::insert(const Key &akey, T *aobject, size_t acost)
+bool Cache<Key,T>::insert(const Key &akey, T *aobject, size_t acost, double aweight)
 {
 	remove(akey);
 	if (acost > mx) {
@@ -155,29 +262,45 @@ bool Cache<Key,T>::insert(const Key &akey, T *aobject, size_t acost)
 		return false;
 	}
 	trim(mx - acost);
-	Node node(aobject, acost);
+	Node node(aobject, acost, aweight);
 	hash[akey] = node;
 	iterator_type i = hash.find(akey);
 	total += acost;
 	Node *n = &i->second;
 	n->keyPtr = &i->first;
+	prioritize(*n);
 	if (f) f->p = n;
 	n->n = f;
 	f = n;
 	if (!l) l = f;
+	stats.inserts++;
 	return true;
 }
 
 template <class Key, class T>
-void Cache<Key,T>::trim(size_t m)
+typename Cache<Key,T>::Node *Cache<Key,T>::victim() const
+{
+	if (policy != CacheEvictionPolicy::CostAware) return l;
+	return queue.empty() ? nullptr : queue.begin()->second;
+}
+
+template <class Key, class T>
+void Cache<Key,T>::evict(Node &u)
 {
-	Node *n = l;
-	while (n && total > m) {
-		Node *u = n;
-		n = n->p;
+	if (policy == CacheEvictionPolicy::CostAware) clock = u.h;
 #ifdef DEBUG
-		PRINTB("Trimming cache: %1% (%2% bytes)", u->keyPtr->substr(0, 40) % u->c);
+	PRINTB("Trimming cache: %1% (%2% bytes, weight %3%)", *u.keyPtr % u.c % u.w);
 #endif
-		unlink(*u);
+	unlink(u);
+	stats.evictions++;
+}
+
+template <class Key, class T>
+void Cache<Key,T>::trim(size_t m)
+{
+	while (total > m) {
+		Node *u = victim();
+		if (!u) break;
+		evict(*u);
 	}
 }
@@ -20,6 +20,7 @@ public:
 	~CgaladvNode() { }
 	std::string toString() const override;
 	std::string name() const override;
+	AbstractNode *clone() const override { return cloneAs(*this); }
 
 	ValuePtr path;
 	unsigned int convexity;
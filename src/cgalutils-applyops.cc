@@ -11,6 +11,9 @@
 #include "polyset-utils.h"
 #include "grid.h"
 #include "node.h"
+#include "ThreadPool.h"
+#include "DecompositionCache.h"
+#include "Tree.h"
 
 #include "cgal.h"
 #pragma push_macro("NDEBUG")
@@ -30,7 +33,12 @@
 #include "Reindexer.h"
 #include "GeometryUtils.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <map>
+#include <mutex>
 #include <queue>
 #include <unordered_set>
 
@@ -72,11 +80,67 @@ namespace CGALUtils {
 		return visited.size() == p.size_of_facets();
 	}
 
+	static shared_ptr<const CGAL_Nef_polyhedron> getNefPolyhedron(const shared_ptr<const Geometry> &geom)
+	{
+		shared_ptr<const CGAL_Nef_polyhedron> N = dynamic_pointer_cast<const CGAL_Nef_polyhedron>(geom);
+		if (!N) {
+			const PolySet *ps = dynamic_cast<const PolySet*>(geom.get());
+			if (ps) N.reset(createNefPolyhedronFromGeometry(*ps));
+		}
+		return N;
+	}
+
+	/*!
+		Removes subtrahends whose bounding box doesn't overlap the bounding box
+		of the first child, as they cannot change the result of a difference.
+		Boxes which only touch are kept.
+	*/
+	static void cullSubtrahends(Geometry::Geometries &children)
+	{
+		if (children.size() < 2) return;
+		const BoundingBox bbox = children.front().second->getBoundingBox();
+		auto it = std::next(children.begin());
+		while (it != children.end()) {
+			if (!bbox.intersects(it->second->getBoundingBox())) {
+				if (it->first) it->first->progress_report();
+				it = children.erase(it);
+			}
+			else ++it;
+		}
+	}
+
+	/*!
+		Returns false if the bounding boxes of the children have no common
+		region, in which case their intersection is known to be empty.
+	*/
+	static bool boundingBoxesIntersect(const Geometry::Geometries &children)
+	{
+		BoundingBox common;
+		bool first = true;
+		for (const auto &item : children) {
+			const BoundingBox bbox = item.second->getBoundingBox();
+			if (first) common = bbox;
+			else common = common.intersection(bbox);
+			if (common.isEmpty()) return false;
+			first = false;
+		}
+		return true;
+	}
+
 /*!
 	Applies op to all children and returns the result.
 	The child list should be guaranteed to contain non-NULL 3D or empty Geometry objects
+
+	For difference and intersection, bounding boxes are compared before doing
+	any Nef conversion: subtrahends which cannot touch the first child are
+	skipped, and an intersection of objects without a common bounding box
+	region is empty. The remaining subtrahends are unioned first so the
+	(usually large) first child only goes through a single Nef difference.
+
+	Each operand is released once it has been applied, so callers which move
+	their list in don't keep all inputs alive until the end.
 */
-	CGAL_Nef_polyhedron *applyOperator(const Geometry::Geometries &children, OpenSCADOperator op)
+	CGAL_Nef_polyhedron *applyOperator(Geometry::Geometries operands, OpenSCADOperator op)
 	{
 		CGAL_Nef_polyhedron *N = nullptr;
 		CGAL::Failure_behaviour old_behaviour = CGAL::set_error_behaviour(CGAL::THROW_EXCEPTION);
@@ -84,14 +148,50 @@ namespace CGALUtils {
 		assert(op != OpenSCADOperator::UNION && "use applyUnion() instead of applyOperator()");
 
 		try {
-			for(const auto &item : children) {
-				const shared_ptr<const Geometry> &chgeom = item.second;
-				shared_ptr<const CGAL_Nef_polyhedron> chN = 
-					dynamic_pointer_cast<const CGAL_Nef_polyhedron>(chgeom);
-				if (!chN) {
-					const PolySet *chps = dynamic_cast<const PolySet*>(chgeom.get());
-					if (chps) chN.reset(createNefPolyhedronFromGeometry(*chps));
+			if (op == OpenSCADOperator::INTERSECTION && !boundingBoxesIntersect(operands)) {
+				PRINTD("Intersection: bounding boxes are disjoint, result is empty");
+				N = new CGAL_Nef_polyhedron();
+				operands.clear();
+			}
+			else if (op == OpenSCADOperator::DIFFERENCE) {
+				auto numChildren = operands.size();
+				cullSubtrahends(operands);
+				if (numChildren > operands.size()) {
+					PRINTDB("Difference: skipped %d of %d subtrahends", (numChildren - operands.size()) % (numChildren - 1));
+				}
+				if (operands.size() > 2) {
+					shared_ptr<const CGAL_Nef_polyhedron> first = getNefPolyhedron(operands.front().second);
+					N = new CGAL_Nef_polyhedron(*first);
+					bool separately = false;
+					if (!N->isEmpty()) {
+						// N - A - B == N - (A + B), so do the expensive difference only once.
+						// applyUnion() releases its inputs, so pass a copy to keep them for the fallback below.
+						// Its errors aren't reported, as the fallback may still succeed.
+						Geometry::Geometries subtrahendItems(std::next(operands.begin()), operands.end());
+						CGAL_Nef_polyhedron *subtrahends = applyUnion(subtrahendItems.begin(), subtrahendItems.end(), false);
+						if (subtrahends) {
+							*N -= *subtrahends;
+							delete subtrahends;
+						}
+						else {
+							// All subtrahends were empty, or applyUnion() failed; subtract them one by one
+							// from the already converted first child
+							operands.erase(operands.begin());
+							separately = true;
+						}
+					}
+					if (!separately) {
+						for (const auto &item : operands) {
+							if (item.first) item.first->progress_report();
+						}
+						operands.clear();
+					}
 				}
+			}
+
+			for(auto &item : operands) {
+				shared_ptr<const CGAL_Nef_polyhedron> chN = getNefPolyhedron(item.second);
+				item.second.reset();
 				// Initialize N with first expected geometric object
 				if (!N) {
 					N = new CGAL_Nef_polyhedron(*chN);
@@ -133,29 +233,98 @@ namespace CGALUtils {
 	}
 
 
-	CGAL_Nef_polyhedron *applyUnion(Geometry::Geometries::iterator chbegin, Geometry::Geometries::iterator chend)
+	typedef std::pair<shared_ptr<const CGAL_Nef_polyhedron>, int> QueueConstItem;
+	struct QueueItemGreater {
+		// stable sort for priority_queue by facets, then progress mark
+		bool operator()(const QueueConstItem &lhs, const QueueConstItem& rhs) const
+		{
+			size_t l = lhs.first->p3->number_of_facets();
+			size_t r = rhs.first->p3->number_of_facets();
+			return (l > r) || (l == r && lhs.second > rhs.second);
+		}
+	};
+	typedef std::priority_queue<QueueConstItem, std::vector<QueueConstItem>, QueueItemGreater> UnionQueue;
+
+	/*!
+		Reduces the queue to a single item by repeatedly unioning the two
+		smallest polyhedra, running up to numThreads independent unions at the
+		same time.
+
+		Only the calling thread reports progress, so cancellation (a
+		ProgressCancelException thrown by progress_tick()) is raised here. Unions
+		already running cannot be interrupted; they are allowed to finish before
+		the exception leaves this function.
+	*/
+	static void parallelUnion(UnionQueue &q, size_t numThreads)
 	{
-		typedef std::pair<shared_ptr<const CGAL_Nef_polyhedron>, int> QueueConstItem;
-		struct QueueItemGreater {
-			// stable sort for priority_queue by facets, then progress mark
-			bool operator()(const QueueConstItem &lhs, const QueueConstItem& rhs) const
+		struct UnionResult {
+			shared_ptr<const CGAL_Nef_polyhedron> N;
+			std::exception_ptr error;
+		};
+		std::mutex mutex;
+		std::condition_variable finished;
+		std::deque<UnionResult> results;
+		// Declared after the result queue so it's destroyed (and joined) first
+		ThreadPool pool(numThreads);
+
+		size_t running = 0;
+		while (q.size() + running > 1) {
+			while (q.size() > 1 && running < pool.size()) {
+				auto p1 = q.top();
+				q.pop();
+				auto p2 = q.top();
+				q.pop();
+				pool.enqueue([p1, p2, &mutex, &finished, &results]() {
+					UnionResult result;
+					try {
+						result.N = make_shared<const CGAL_Nef_polyhedron>(*p1.first + *p2.first);
+					}
+					catch (...) {
+						result.error = std::current_exception();
+					}
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						results.push_back(result);
+					}
+					finished.notify_one();
+				});
+				running++;
+			}
+
+			UnionResult result;
 			{
-				size_t l = lhs.first->p3->number_of_facets();
-				size_t r = rhs.first->p3->number_of_facets();
-				return (l > r) || (l == r && lhs.second > rhs.second);
+				std::unique_lock<std::mutex> lock(mutex);
+				finished.wait(lock, [&results]() { return !results.empty(); });
+				result = results.front();
+				results.pop_front();
 			}
-		};
-		std::priority_queue<QueueConstItem, std::vector<QueueConstItem>, QueueItemGreater> q;
+			running--;
+			if (result.error) std::rethrow_exception(result.error);
+			q.emplace(result.N, -1);
+			progress_tick();
+		}
+	}
+
+	/*!
+		Unions the given children, smallest first. The geometry of each child is
+		released from the list once it's been converted, so converted PolySets
+		aren't kept alongside their Nef polyhedra. CGAL errors are printed unless
+		printErrors is false; either way nullptr is returned.
+	*/
+	CGAL_Nef_polyhedron *applyUnion(Geometry::Geometries::iterator chbegin, Geometry::Geometries::iterator chend, bool printErrors)
+	{
+		UnionQueue q;
 
 		try {
 			// sort children by fewest faces
 			for (auto it = chbegin; it != chend; ++it) {
-				const shared_ptr<const Geometry> &chgeom = it->second;
+				shared_ptr<const Geometry> chgeom = std::move(it->second);
 				shared_ptr<const CGAL_Nef_polyhedron> curChild = dynamic_pointer_cast<const CGAL_Nef_polyhedron>(chgeom);
 				if (!curChild) {
 					const PolySet *chps = dynamic_cast<const PolySet*>(chgeom.get());
 					if (chps) curChild.reset(createNefPolyhedronFromGeometry(*chps));
 				}
+				chgeom.reset();
 				if (curChild && !curChild->isEmpty()) {
 					int node_mark = -1;
 					if (it->first) {
@@ -166,6 +335,11 @@ namespace CGALUtils {
 			}
 
 			progress_tick();
+			// Unions of parallel subtree tasks run serially, the other tasks keep the threads busy
+			auto numThreads = ThreadPool::configuredThreads();
+			if (numThreads > 1 && q.size() > 2 && !ThreadPool::isWorkerThread()) {
+				parallelUnion(q, numThreads);
+			}
 			while (q.size() > 1) {
 				auto p1 = q.top();
 				q.pop();
@@ -182,7 +356,8 @@ namespace CGALUtils {
 			}
 		}
 		catch (const CGAL::Failure_exception &e) {
-			PRINTB("ERROR: CGAL error in CGALUtils::applyUnion: %s", e.what());
+			if (printErrors) PRINTB("ERROR: CGAL error in CGALUtils::applyUnion: %s", e.what());
+			else PRINTDB("CGAL error in CGALUtils::applyUnion: %s", e.what());
 		}
 		return nullptr;
 	}
@@ -209,10 +384,8 @@ namespace CGALUtils {
 			} else {
 				const PolySet *ps = dynamic_cast<const PolySet *>(chgeom.get());
 				if (ps) {
-					for(const auto &p : ps->polygons) {
-						for(const auto &v : p) {
-							points.push_back(K::Point_3(v[0], v[1], v[2]));
-						}
+					for(const auto &v : ps->getVertices()) {
+						points.push_back(K::Point_3(v[0], v[1], v[2]));
 					}
 				}
 			}
@@ -242,186 +415,250 @@ namespace CGALUtils {
 	}
 
 
+	typedef CGAL::Epick Hull_kernel;
+
 	/*!
-		children cannot contain nullptr objects
+		Returns the convex hull of the Minkowski sum of two convex point clouds,
+		or nullptr if the sum has too few points to form a volume.
+		Doesn't report anything, so it's safe to call from worker threads.
 	*/
-	Geometry const * applyMinkowski(const Geometry::Geometries &children)
+	static shared_ptr<const PolySet> minkowskiHull(const std::vector<Hull_kernel::Point_3> &points0, const std::vector<Hull_kernel::Point_3> &points1)
 	{
-		CGAL::Failure_behaviour old_behaviour = CGAL::set_error_behaviour(CGAL::THROW_EXCEPTION);
-		CGAL::Timer t,t_tot;
-		assert(children.size() >= 2);
-		Geometry::Geometries::const_iterator it = children.begin();
-		t_tot.start();
-		Geometry const* operands[2] = {it->second.get(), nullptr};
-		try {
-			while (++it != children.end()) {
-				operands[1] = it->second.get();
-
-				typedef CGAL::Epick Hull_kernel;
+		std::vector<Hull_kernel::Point_3> minkowski_points;
+		minkowski_points.reserve(points0.size() * points1.size());
+		for (size_t i = 0; i < points0.size(); i++) {
+			for (size_t j = 0; j < points1.size(); j++) {
+				minkowski_points.push_back(points0[i]+(points1[j]-CGAL::ORIGIN));
+			}
+		}
 
-				std::list<CGAL_Polyhedron> P[2];
-				std::list<CGAL::Polyhedron_3<Hull_kernel>> result_parts;
+		if (minkowski_points.size() <= 3) return nullptr;
 
-				for (size_t i = 0; i < 2; i++) {
-					CGAL_Polyhedron poly;
+		CGAL::Polyhedron_3<Hull_kernel> result;
+		CGAL::convex_hull_3(minkowski_points.begin(), minkowski_points.end(), result);
 
-					const PolySet * ps = dynamic_cast<const PolySet *>(operands[i]);
-
-					const CGAL_Nef_polyhedron * nef = dynamic_cast<const CGAL_Nef_polyhedron *>(operands[i]);
-
-					if (ps) CGALUtils::createPolyhedronFromPolySet(*ps, poly);
-					else if (nef && nef->p3->is_simple()) nef->p3->convert_to_polyhedron(poly);
-					else throw 0;
-
-					if ((ps && ps->is_convex()) ||
-							(!ps && is_weakly_convex(poly))) {
-						PRINTDB("Minkowski: child %d is convex and %s",i % (ps?"PolySet":"Nef"));
-						P[i].push_back(poly);
-					} else {
-						CGAL_Nef_polyhedron3 decomposed_nef;
-
-						if (ps) {
-							PRINTDB("Minkowski: child %d is nonconvex PolySet, transforming to Nef and decomposing...", i);
-							CGAL_Nef_polyhedron *p = createNefPolyhedronFromGeometry(*ps);
-							if (!p->isEmpty()) decomposed_nef = *p->p3;
-							delete p;
-						} else {
-							PRINTDB("Minkowski: child %d is nonconvex Nef, decomposing...",i);
-							decomposed_nef = *nef->p3;
-						}
+		std::vector<Hull_kernel::Point_3> strict_points;
+		strict_points.reserve(minkowski_points.size());
 
-						t.start();
-						CGAL::convex_decomposition_3(decomposed_nef);
-
-						// the first volume is the outer volume, which ignored in the decomposition
-						CGAL_Nef_polyhedron3::Volume_const_iterator ci = ++decomposed_nef.volumes_begin();
-						for(; ci != decomposed_nef.volumes_end(); ++ci) {
-							if(ci->mark()) {
-								CGAL_Polyhedron poly;
-								decomposed_nef.convert_inner_shell_to_polyhedron(ci->shells_begin(), poly);
-								P[i].push_back(poly);
-							}
-						}
+		for (CGAL::Polyhedron_3<Hull_kernel>::Vertex_iterator i = result.vertices_begin(); i != result.vertices_end(); ++i) {
+			Hull_kernel::Point_3 const& p = i->point();
 
+			CGAL::Polyhedron_3<Hull_kernel>::Vertex::Halfedge_handle h,e;
+			h = i->halfedge();
+			e = h;
+			bool collinear = false;
+			bool coplanar = true;
 
-						PRINTDB("Minkowski: decomposed into %d convex parts", P[i].size());
-						t.stop();
-						PRINTDB("Minkowski: decomposition took %f s", t.time());
-					}
+			do {
+				Hull_kernel::Point_3 const& q = h->opposite()->vertex()->point();
+				if (coplanar && !CGAL::coplanar(p,q,
+												h->next_on_vertex()->opposite()->vertex()->point(),
+												h->next_on_vertex()->next_on_vertex()->opposite()->vertex()->point())) {
+					coplanar = false;
 				}
 
-				std::vector<Hull_kernel::Point_3> points[2];
-				std::vector<Hull_kernel::Point_3> minkowski_points;
-
-				for (size_t i = 0; i < P[0].size(); i++) {
-					for (size_t j = 0; j < P[1].size(); j++) {
-						t.start();
-						points[0].clear();
-						points[1].clear();
 
-						for (int k = 0; k < 2; k++) {
-							std::list<CGAL_Polyhedron>::iterator it = P[k].begin();
-							std::advance(it, k==0?i:j);
+				for (CGAL::Polyhedron_3<Hull_kernel>::Vertex::Halfedge_handle j = h->next_on_vertex();
+					 j != h && !collinear && ! coplanar;
+					 j = j->next_on_vertex()) {
 
-							CGAL_Polyhedron const& poly = *it;
-							points[k].reserve(poly.size_of_vertices());
-
-							for (CGAL_Polyhedron::Vertex_const_iterator pi = poly.vertices_begin(); pi != poly.vertices_end(); ++pi) {
-								CGAL_Polyhedron::Point_3 const& p = pi->point();
-								points[k].push_back(Hull_kernel::Point_3(to_double(p[0]),to_double(p[1]),to_double(p[2])));
-							}
-						}
+					Hull_kernel::Point_3 const& r = j->opposite()->vertex()->point();
+					if (CGAL::collinear(p,q,r)) {
+						collinear = true;
+					}
+				}
 
-						minkowski_points.clear();
-						minkowski_points.reserve(points[0].size() * points[1].size());
-						for (size_t i = 0; i < points[0].size(); i++) {
-							for (size_t j = 0; j < points[1].size(); j++) {
-								minkowski_points.push_back(points[0][i]+(points[1][j]-CGAL::ORIGIN));
-							}
-						}
+				h = h->next_on_vertex();
+			} while (h != e && !collinear);
 
-						if (minkowski_points.size() <= 3) {
-							t.stop();
-							continue;
-						}
+			if (!collinear && !coplanar)
+				strict_points.push_back(p);
+		}
 
+		result.clear();
+		CGAL::convex_hull_3(strict_points.begin(), strict_points.end(), result);
 
-						CGAL::Polyhedron_3<Hull_kernel> result;
-						t.stop();
-						PRINTDB("Minkowski: Point cloud creation (%d ⨉ %d -> %d) took %f ms", points[0].size() % points[1].size() % minkowski_points.size() % (t.time()*1000));
-						t.reset();
+		auto ps = make_shared<PolySet>(3, true);
+		createPolySetFromPolyhedron(result, *ps);
+		return ps;
+	}
 
-						t.start();
+	/*!
+		Returns f(0), ..., f(n-1). The calls are distributed over the configured
+		number of worker threads, so f must be safe to call concurrently.
+		On a pool thread the calls run serially instead of starting a nested pool.
+		An exception thrown by f is rethrown here.
+	*/
+	template <typename T>
+	static std::vector<T> parallelMap(size_t n, const std::function<T(size_t)> &f)
+	{
+		std::vector<T> results;
+		results.reserve(n);
+		auto numThreads = ThreadPool::configuredThreads();
+		if (numThreads > 1 && n > 1 && !ThreadPool::isWorkerThread()) {
+			std::vector<std::future<T>> futures;
+			futures.reserve(n);
+			ThreadPool pool(std::min(numThreads, n));
+			for (size_t i = 0; i < n; ++i) {
+				futures.push_back(pool.enqueue([&f, i]() { return f(i); }));
+			}
+			for (auto &future : futures) results.push_back(future.get());
+		}
+		else {
+			for (size_t i = 0; i < n; ++i) results.push_back(f(i));
+		}
+		return results;
+	}
 
-						CGAL::convex_hull_3(minkowski_points.begin(), minkowski_points.end(), result);
+	/*!
+		Splits a minkowski() operand into convex parts, and returns the vertices
+		of each part. Throws if the operand can't be converted to a polyhedron.
+	*/
+	static shared_ptr<const DecompositionCache::ConvexParts> decomposeMinkowskiOperand(const Geometry *operand, size_t i, CGAL::Timer &t)
+	{
+		std::list<CGAL_Polyhedron> P;
+		CGAL_Polyhedron poly;
 
-						std::vector<Hull_kernel::Point_3> strict_points;
-						strict_points.reserve(minkowski_points.size());
+		const PolySet * ps = dynamic_cast<const PolySet *>(operand);
 
-						for (CGAL::Polyhedron_3<Hull_kernel>::Vertex_iterator i = result.vertices_begin(); i != result.vertices_end(); ++i) {
-							Hull_kernel::Point_3 const& p = i->point();
+		const CGAL_Nef_polyhedron * nef = dynamic_cast<const CGAL_Nef_polyhedron *>(operand);
 
-							CGAL::Polyhedron_3<Hull_kernel>::Vertex::Halfedge_handle h,e;
-							h = i->halfedge();
-							e = h;
-							bool collinear = false;
-							bool coplanar = true;
+		if (ps) CGALUtils::createPolyhedronFromPolySet(*ps, poly);
+		else if (nef && nef->p3->is_simple()) nef->p3->convert_to_polyhedron(poly);
+		else throw 0;
 
-							do {
-								Hull_kernel::Point_3 const& q = h->opposite()->vertex()->point();
-								if (coplanar && !CGAL::coplanar(p,q,
-																h->next_on_vertex()->opposite()->vertex()->point(),
-																h->next_on_vertex()->next_on_vertex()->opposite()->vertex()->point())) {
-									coplanar = false;
-								}
+		if ((ps && ps->is_convex()) ||
+				(!ps && is_weakly_convex(poly))) {
+			PRINTDB("Minkowski: child %d is convex and %s",i % (ps?"PolySet":"Nef"));
+			P.push_back(poly);
+		} else {
+			CGAL_Nef_polyhedron3 decomposed_nef;
 
+			if (ps) {
+				PRINTDB("Minkowski: child %d is nonconvex PolySet, transforming to Nef and decomposing...", i);
+				CGAL_Nef_polyhedron *p = createNefPolyhedronFromGeometry(*ps);
+				if (!p->isEmpty()) decomposed_nef = *p->p3;
+				delete p;
+			} else {
+				PRINTDB("Minkowski: child %d is nonconvex Nef, decomposing...",i);
+				decomposed_nef = *nef->p3;
+			}
 
-								for (CGAL::Polyhedron_3<Hull_kernel>::Vertex::Halfedge_handle j = h->next_on_vertex();
-									 j != h && !collinear && ! coplanar;
-									 j = j->next_on_vertex()) {
+			t.start();
+			CGAL::convex_decomposition_3(decomposed_nef);
 
-									Hull_kernel::Point_3 const& r = j->opposite()->vertex()->point();
-									if (CGAL::collinear(p,q,r)) {
-										collinear = true;
-									}
-								}
+			// the first volume is the outer volume, which ignored in the decomposition
+			CGAL_Nef_polyhedron3::Volume_const_iterator ci = ++decomposed_nef.volumes_begin();
+			for(; ci != decomposed_nef.volumes_end(); ++ci) {
+				if(ci->mark()) {
+					CGAL_Polyhedron poly;
+					decomposed_nef.convert_inner_shell_to_polyhedron(ci->shells_begin(), poly);
+					P.push_back(poly);
+				}
+			}
 
-								h = h->next_on_vertex();
-							} while (h != e && !collinear);
 
-							if (!collinear && !coplanar)
-								strict_points.push_back(p);
-						}
+			PRINTDB("Minkowski: decomposed into %d convex parts", P.size());
+			t.stop();
+			PRINTDB("Minkowski: decomposition took %f s", t.time());
+			t.reset();
+		}
 
-						result.clear();
-						CGAL::convex_hull_3(strict_points.begin(), strict_points.end(), result);
+		auto parts = make_shared<DecompositionCache::ConvexParts>();
+		parts->reserve(P.size());
+		for (const auto &poly : P) {
+			parts->emplace_back();
+			parts->back().reserve(poly.size_of_vertices());
+			for (CGAL_Polyhedron::Vertex_const_iterator pi = poly.vertices_begin(); pi != poly.vertices_end(); ++pi) {
+				CGAL_Polyhedron::Point_3 const& p = pi->point();
+				parts->back().push_back(Vector3d(to_double(p[0]),to_double(p[1]),to_double(p[2])));
+			}
+		}
+		return parts;
+	}
 
+	/*!
+		children cannot contain nullptr objects
+	*/
+	Geometry const * applyMinkowski(const Geometry::Geometries &children, const Tree *tree)
+	{
+		CGAL::Failure_behaviour old_behaviour = CGAL::set_error_behaviour(CGAL::THROW_EXCEPTION);
+		CGAL::Timer t,t_tot;
+		assert(children.size() >= 2);
+		Geometry::Geometries::const_iterator it = children.begin();
+		t_tot.start();
+		Geometry const* operands[2] = {it->second.get(), nullptr};
+		try {
+			while (++it != children.end()) {
+				operands[1] = it->second.get();
 
-						t.stop();
-						PRINTDB("Minkowski: Computing convex hull took %f s", t.time());
-						t.reset();
+				shared_ptr<const DecompositionCache::ConvexParts> parts[2];
+				for (size_t i = 0; i < 2; i++) {
+					// Only the original children can be looked up; operands[0] is an
+					// intermediate result after the first iteration
+					const auto &child = i == 0 ? children.front() : *it;
+					const bool haskey = tree && child.first && (i == 1 || it == std::next(children.begin()));
+					NodeHash key;
+					if (haskey) key = tree->getHash(*child.first);
+					if (haskey) parts[i] = DecompositionCache::instance()->get(key);
+					if (parts[i]) {
+						PRINTDB("Minkowski: child %d found in decomposition cache", i);
+					}
+					else {
+						parts[i] = decomposeMinkowskiOperand(operands[i], i, t);
+						if (haskey) DecompositionCache::instance()->insert(key, parts[i]);
+					}
+				}
 
-						result_parts.push_back(result);
+				t.start();
+				std::vector<std::vector<Hull_kernel::Point_3>> points[2];
+				for (size_t k = 0; k < 2; k++) {
+					for (const auto &part : *parts[k]) {
+						points[k].emplace_back();
+						points[k].back().reserve(part.size());
+						for (const auto &v : part) {
+							points[k].back().push_back(Hull_kernel::Point_3(v[0], v[1], v[2]));
+						}
 					}
 				}
+				t.stop();
+				PRINTDB("Minkowski: Point cloud creation (%d, %d parts) took %f ms", points[0].size() % points[1].size() % (t.time()*1000));
+				t.reset();
+
+				t.start();
+				const size_t numParts1 = points[1].size();
+				std::vector<shared_ptr<const PolySet>> hulls = parallelMap<shared_ptr<const PolySet>>(points[0].size() * numParts1, [&points, numParts1](size_t idx) {
+					return minkowskiHull(points[0][idx / numParts1], points[1][idx % numParts1]);
+				});
+				std::vector<shared_ptr<const PolySet>> result_parts;
+				for (const auto &hull : hulls) {
+					if (hull) result_parts.push_back(hull);
+				}
+				t.stop();
+				PRINTDB("Minkowski: Computing %d convex hulls took %f s", hulls.size() % t.time());
+				t.reset();
 
 				if (it != std::next(children.begin()))
 					delete operands[0];
 
 				if (result_parts.size() == 1) {
-					PolySet *ps = new PolySet(3,true);
-					createPolySetFromPolyhedron(*result_parts.begin(), *ps);
-					operands[0] = ps;
+					operands[0] = new PolySet(*result_parts.front());
 				} else if (!result_parts.empty()) {
 					t.start();
-					PRINTDB("Minkowski: Computing union of %d parts",result_parts.size());
+					std::vector<shared_ptr<const Geometry>> nefs = parallelMap<shared_ptr<const Geometry>>(result_parts.size(), [&result_parts](size_t idx) {
+						return shared_ptr<const Geometry>(createNefPolyhedronFromGeometry(*result_parts[idx]));
+					});
 					Geometry::Geometries fake_children;
-					for (std::list<CGAL::Polyhedron_3<Hull_kernel>>::iterator i = result_parts.begin(); i != result_parts.end(); ++i) {
-						PolySet ps(3,true);
-						createPolySetFromPolyhedron(*i, ps);
-						fake_children.push_back(std::make_pair((const AbstractNode*)nullptr,
-															   shared_ptr<const Geometry>(createNefPolyhedronFromGeometry(ps))));
+					for (auto &N : nefs) {
+						fake_children.push_back(std::make_pair((const AbstractNode*)nullptr, std::move(N)));
 					}
+					t.stop();
+					PRINTDB("Minkowski: Converting %d parts to Nef took %f s", nefs.size() % t.time());
+					nefs.clear();
+					t.reset();
+
+					t.start();
+					PRINTDB("Minkowski: Computing union of %d parts",result_parts.size());
 					CGAL_Nef_polyhedron *N = CGALUtils::applyUnion(fake_children.begin(), fake_children.end());
 					// FIXME: This should really never throw.
 					// Assert once we figured out what went wrong with issue #1069?
@@ -0,0 +1,169 @@
+#ifdef ENABLE_CGAL
+
+#include "cgalutils.h"
+#include "polyset.h"
+#include "polyset-utils.h"
+#include "printutils.h"
+#include "grid.h"
+#include "node.h"
+
+#include "cgal.h"
+#pragma push_macro("NDEBUG")
+#undef NDEBUG
+#include <CGAL/Surface_mesh.h>
+#include <CGAL/boost/graph/helpers.h>
+#include <CGAL/Polygon_mesh_processing/corefinement.h>
+#include <CGAL/Polygon_mesh_processing/orientation.h>
+#include <CGAL/Polygon_mesh_processing/self_intersections.h>
+#pragma pop_macro("NDEBUG")
+
+
+namespace PMP = CGAL::Polygon_mesh_processing;
+
+typedef CGAL::Exact_predicates_exact_constructions_kernel CGAL_ExactKernel3;
+typedef CGAL::Surface_mesh<CGAL_ExactKernel3::Point_3> CGAL_SurfaceMesh;
+
+namespace /* anonymous */ {
+
+/*!
+	Builds a triangulated Surface_mesh from a PolySet. Vertices are snapped to
+	the same grid as used for Nef conversion, so both backends see the same
+	input geometry.
+
+	Returns false if the result cannot be used for corefinement, i.e. if it is
+	not a closed, outward oriented 2-manifold without self-intersections.
+*/
+	bool createSurfaceMeshFromPolySet(const PolySet &ps, CGAL_SurfaceMesh &mesh)
+	{
+		PolySet tessellated(3);
+		PolysetUtils::tessellate_faces(ps, tessellated);
+
+		Grid3d<int> grid(GRID_FINE);
+		std::vector<CGAL_SurfaceMesh::Vertex_index> vertices;
+		std::vector<CGAL_SurfaceMesh::Vertex_index> face;
+		// Shared vertices of the PolySet are only aligned once
+		std::vector<int> aligned(tessellated.getVertices().size(), -1);
+		for (const auto &p : tessellated.polygons()) {
+			face.clear();
+			// PolySet faces are clockwise when seen from the outside
+			for (size_t i = p.size(); i-- > 0;) {
+				int &idx = aligned[p.index(i)];
+				if (idx < 0) {
+					Vector3d v = p[i];
+					idx = grid.align(v);
+					if (size_t(idx) == vertices.size()) {
+						vertices.push_back(mesh.add_vertex(CGAL_ExactKernel3::Point_3(v[0], v[1], v[2])));
+					}
+				}
+				face.push_back(vertices[idx]);
+			}
+			// Skip triangles which collapsed when aligning to the grid
+			if (face.size() != 3 || face[0] == face[1] || face[1] == face[2] || face[2] == face[0]) continue;
+			if (mesh.add_face(face) == CGAL_SurfaceMesh::null_face()) return false;
+		}
+
+		if (mesh.is_empty()) return true;
+		if (!CGAL::is_closed(mesh)) return false;
+		if (PMP::does_self_intersect(mesh)) return false;
+		return PMP::is_outward_oriented(mesh);
+	}
+
+	PolySet *createPolySetFromSurfaceMesh(const CGAL_SurfaceMesh &mesh)
+	{
+		PolySet *ps = new PolySet(3);
+		for (const auto &f : mesh.faces()) {
+			ps->append_poly();
+			// Insert at the front to turn the counter-clockwise faces clockwise
+			for (const auto &v : CGAL::vertices_around_face(mesh.halfedge(f), mesh)) {
+				const auto &p = mesh.point(v);
+				ps->insert_vertex(CGAL::to_double(p.x()), CGAL::to_double(p.y()), CGAL::to_double(p.z()));
+			}
+		}
+		return ps;
+	}
+
+	bool createSurfaceMeshFromGeometry(const Geometry &geom, CGAL_SurfaceMesh &mesh)
+	{
+		if (const PolySet *ps = dynamic_cast<const PolySet *>(&geom)) {
+			return createSurfaceMeshFromPolySet(*ps, mesh);
+		}
+		if (const CGAL_Nef_polyhedron *N = dynamic_cast<const CGAL_Nef_polyhedron *>(&geom)) {
+			if (N->isEmpty()) return true;
+			PolySet ps(3);
+			bool err = CGALUtils::createPolySetFromNefPolyhedron3(*N->p3, ps);
+			return !err && createSurfaceMeshFromPolySet(ps, mesh);
+		}
+		return false;
+	}
+}
+
+namespace CGALUtils {
+
+/*!
+	Applies union, intersection or difference to all children using
+	corefinement of triangle meshes over an exact kernel instead of Nef
+	polyhedra.
+
+	Returns nullptr if any child is not a closed 2-manifold, or if an
+	intermediate result isn't one. The caller is then expected to fall back
+	to the Nef polyhedron based applyUnion() or applyOperator().
+*/
+	PolySet *applyCorefinement(const Geometry::Geometries &children, OpenSCADOperator op)
+	{
+		assert(op == OpenSCADOperator::UNION || op == OpenSCADOperator::INTERSECTION || op == OpenSCADOperator::DIFFERENCE);
+
+		CGAL::Failure_behaviour old_behaviour = CGAL::set_error_behaviour(CGAL::THROW_EXCEPTION);
+		PolySet *result = nullptr;
+		try {
+			CGAL_SurfaceMesh mesh;
+			bool first = true;
+			bool ok = true;
+			for (const auto &item : children) {
+				CGAL_SurfaceMesh chmesh;
+				if (!createSurfaceMeshFromGeometry(*item.second, chmesh)) {
+					PRINTD("Corefinement: non-manifold operand, falling back to Nef polyhedra");
+					ok = false;
+					break;
+				}
+				if (first) {
+					mesh = std::move(chmesh);
+					first = false;
+				}
+				else if (chmesh.is_empty()) {
+					if (op == OpenSCADOperator::INTERSECTION) mesh.clear();
+				}
+				else if (mesh.is_empty()) {
+					if (op == OpenSCADOperator::UNION) mesh = std::move(chmesh);
+				}
+				else {
+					switch (op) {
+					case OpenSCADOperator::UNION:
+						ok = PMP::corefine_and_compute_union(mesh, chmesh, mesh);
+						break;
+					case OpenSCADOperator::INTERSECTION:
+						ok = PMP::corefine_and_compute_intersection(mesh, chmesh, mesh);
+						break;
+					case OpenSCADOperator::DIFFERENCE:
+						ok = PMP::corefine_and_compute_difference(mesh, chmesh, mesh);
+						break;
+					default:
+						ok = false;
+					}
+					if (!ok) {
+						PRINTD("Corefinement: non-manifold result, falling back to Nef polyhedra");
+						break;
+					}
+				}
+				if (op != OpenSCADOperator::UNION && item.first) item.first->progress_report();
+			}
+			if (ok) result = createPolySetFromSurfaceMesh(mesh);
+		}
+		catch (const std::exception &e) {
+			PRINTDB("Corefinement failed, falling back to Nef polyhedra: %s", e.what());
+		}
+		CGAL::set_error_behaviour(old_behaviour);
+		return result;
+	}
+}; // namespace CGALUtils
+
+#endif /* ENABLE_CGAL */
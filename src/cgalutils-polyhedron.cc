@@ -50,16 +50,22 @@ namespace /* anonymous */ {
 			std::vector<CGALPoint> vertices;
 			std::vector<std::vector<size_t>> indices;
 
-			// Align all vertices to grid and build vertex array in vertices
-			for(const auto &p : ps.polygons) {
+			// Align all vertices to grid and build vertex array in vertices.
+			// Shared vertices of the PolySet are only aligned once.
+			std::vector<int> aligned(ps.getVertices().size(), -1);
+			for(const auto &p : ps.polygons()) {
 				indices.push_back(std::vector<size_t>());
 				indices.back().reserve(p.size());
-				for (auto v : boost::adaptors::reverse(p)) {
-					// align v to the grid; the CGALPoint will receive the aligned vertex
-					size_t idx = grid.align(v);
-					if (idx == vertices.size()) {
-						CGALPoint p(v[0], v[1], v[2]);
-						vertices.push_back(p);
+				for (size_t i = p.size(); i-- > 0;) {
+					int &idx = aligned[p.index(i)];
+					if (idx < 0) {
+						// align v to the grid; the CGALPoint will receive the aligned vertex
+						Vector3d v = p[i];
+						idx = grid.align(v);
+						if (size_t(idx) == vertices.size()) {
+							CGALPoint p(v[0], v[1], v[2]);
+							vertices.push_back(p);
+						}
 					}
 					indices.back().push_back(idx);
 				}
@@ -69,7 +75,7 @@ namespace /* anonymous */ {
 			printf("polyhedron(faces=[");
 			int pidx = 0;
 #endif
-			B.begin_surface(vertices.size(), ps.polygons.size());
+			B.begin_surface(vertices.size(), ps.polygons().size());
 			for(const auto &p : vertices) {
 				B.add_vertex(p);
 			}
@@ -119,12 +125,12 @@ namespace /* anonymous */ {
 				std::vector<size_t> indices(3);
 
 				// Estimating same # of vertices as polygons (very rough)
-				B.begin_surface(ps.polygons.size(), ps.polygons.size());
+				B.begin_surface(ps.polygons().size(), ps.polygons().size());
 				int pidx = 0;
 #ifdef GEN_SURFACE_DEBUG
 				printf("polyhedron(faces=[");
 #endif
-				for(const auto &p : ps.polygons) {
+				for(const auto &p : ps.polygons()) {
 #ifdef GEN_SURFACE_DEBUG
 					if (pidx++ > 0) printf(",");
 #endif
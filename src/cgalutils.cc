@@ -51,10 +51,8 @@ static CGAL_Nef_polyhedron *createNefPolyhedronFromPolySet(const PolySet &ps)
 		// NB! CGAL's convex_hull_3() doesn't like std::set iterators, so we use a list
 		// instead.
 		std::list<K::Point_3> points;
-		for (const auto &poly : psq.polygons) {
-			for (const auto &p : poly) {
-				points.push_back(vector_convert<K::Point_3>(p));
-			}
+		for (const auto &p : psq.getVertices()) {
+			points.push_back(vector_convert<K::Point_3>(p));
 		}
 
 		if (points.size() <= 3) return new CGAL_Nef_polyhedron();
@@ -169,16 +167,17 @@ namespace CGALUtils {
 		typedef std::map<Edge, int, VecPairCompare> Edge_to_facet_map;
 		Edge_to_facet_map edge_to_facet_map;
 		std::vector<Plane> facet_planes;
-		facet_planes.reserve(ps.polygons.size());
+		const auto polygons = ps.polygons();
+		facet_planes.reserve(polygons.size());
 
-		for (size_t i = 0; i < ps.polygons.size(); i++) {
+		for (size_t i = 0; i < polygons.size(); i++) {
 			Plane plane;
-			auto N = ps.polygons[i].size();
+			auto N = polygons[i].size();
 			if (N >= 3) {
 				std::vector<Point> v(N);
 				for (size_t j = 0; j < N; j++) {
-					v[j] = vector_convert<Point>(ps.polygons[i][j]);
-					Edge edge(ps.polygons[i][j],ps.polygons[i][(j+1)%N]);
+					v[j] = vector_convert<Point>(polygons[i][j]);
+					Edge edge(polygons[i][j],polygons[i][(j+1)%N]);
 					if (edge_to_facet_map.count(edge)) return false; // edge already exists: nonmanifold
 					edge_to_facet_map[edge] = i;
 				}
@@ -189,18 +188,18 @@ namespace CGALUtils {
 			facet_planes.push_back(plane);
 		}
 
-		for (size_t i = 0; i < ps.polygons.size(); i++) {
-			auto N = ps.polygons[i].size();
+		for (size_t i = 0; i < polygons.size(); i++) {
+			auto N = polygons[i].size();
 			if (N < 3) continue;
 			for (size_t j = 0; j < N; j++) {
-				Edge other_edge(ps.polygons[i][(j+1)%N], ps.polygons[i][j]);
+				Edge other_edge(polygons[i][(j+1)%N], polygons[i][j]);
 				if (edge_to_facet_map.count(other_edge) == 0) return false;//
 				//Edge_to_facet_map::const_iterator it = edge_to_facet_map.find(other_edge);
 				//if (it == edge_to_facet_map.end()) return false; // not a closed manifold
 				//int other_facet = it->second;
 				int other_facet = edge_to_facet_map[other_edge];
 
-				auto p = vector_convert<Point>(ps.polygons[i][(j+2)%N]);
+				auto p = vector_convert<Point>(polygons[i][(j+2)%N]);
 
 				if (facet_planes[other_facet].has_on_positive_side(p)) {
 					// Check angle
@@ -223,9 +222,9 @@ namespace CGALUtils {
 		while(!facets_to_visit.empty()) {
 			int f = facets_to_visit.front(); facets_to_visit.pop();
 
-			for (size_t i = 0; i < ps.polygons[f].size(); i++) {
-				int j = (i+1) % ps.polygons[f].size();
-				auto it = edge_to_facet_map.find(Edge(ps.polygons[f][j], ps.polygons[f][i]));
+			for (size_t i = 0; i < polygons[f].size(); i++) {
+				int j = (i+1) % polygons[f].size();
+				auto it = edge_to_facet_map.find(Edge(polygons[f][j], polygons[f][i]));
 				if (it == edge_to_facet_map.end()) return false; // Nonmanifold
 				if (!explored_facets.count(it->second)) {
 					explored_facets.insert(it->second);
@@ -235,7 +234,7 @@ namespace CGALUtils {
 		}
 
 		// Make sure that we were able to reach all polygons during our visit
-		return explored_facets.size() == ps.polygons.size();
+		return explored_facets.size() == polygons.size();
 	}
 
 
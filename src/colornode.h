@@ -10,6 +10,7 @@ public:
 	ColorNode(const ModuleInstantiation *mi, const std::shared_ptr<EvalContext> &ctx) : AbstractNode(mi, ctx), color(-1.0f, -1.0f, -1.0f, 1.0f) { }
 	std::string toString() const override;
 	std::string name() const override;
+	AbstractNode *clone() const override { return cloneAs(*this); }
 
 	Color4f color;
 };
@@ -0,0 +1,196 @@
+#include "constantfolding.h"
+#include "expression.h"
+#include "function.h"
+#include "localscope.h"
+#include "ModuleInstantiation.h"
+#include "UserModule.h"
+
+namespace {
+	// Constant expressions don't look at their context
+	ValuePtr value_of(const shared_ptr<Expression> &expr)
+	{
+		return expr->evaluate(nullptr);
+	}
+
+	// Folds expr, and replaces it by a Literal if it is constant
+	bool fold(shared_ptr<Expression> &expr)
+	{
+		if (!expr->foldConstants()) return false;
+		if (!dynamic_cast<const Literal *>(expr.get())) {
+			expr = make_shared<Literal>(value_of(expr), expr);
+		}
+		return true;
+	}
+
+	bool fold(const AssignmentList &assignments)
+	{
+		bool constant = true;
+		for (const auto &assignment : assignments) {
+			if (assignment->expr && !fold(assignment->expr)) constant = false;
+		}
+		return constant;
+	}
+}
+
+void fold_constants(LocalScope &scope)
+{
+	for (const auto &function : scope.astFunctions) {
+		fold(function.second->definition_arguments);
+		if (function.second->expr) fold(function.second->expr);
+	}
+	for (const auto &module : scope.astModules) {
+		fold(module.second->definition_arguments);
+		fold_constants(module.second->scope);
+	}
+	fold(scope.assignments);
+	for (const auto &inst : scope.children_inst) {
+		fold(inst->arguments);
+		fold_constants(inst->scope);
+		if (auto ifelse = dynamic_pointer_cast<IfElseModuleInstantiation>(inst)) {
+			fold_constants(ifelse->else_scope);
+		}
+	}
+}
+
+bool Expression::foldConstants()
+{
+	return false;
+}
+
+bool UnaryOp::foldConstants()
+{
+	return fold(this->expr);
+}
+
+bool BinaryOp::foldConstants()
+{
+	const bool left = fold(this->left);
+	const bool right = fold(this->right);
+	if (!left || !right) return false;
+	// Multiplying a vector by a malformed matrix prints a warning
+	return this->op != Op::Multiply
+		|| value_of(this->left)->type() != Value::ValueType::VECTOR
+		|| value_of(this->right)->type() != Value::ValueType::VECTOR;
+}
+
+bool TernaryOp::foldConstants()
+{
+	const bool cond = fold(this->cond);
+	const bool ifexpr = fold(this->ifexpr);
+	const bool elseexpr = fold(this->elseexpr);
+	return cond && ifexpr && elseexpr;
+}
+
+bool ArrayLookup::foldConstants()
+{
+	fold(this->array);
+	fold(this->index);
+	return false;
+}
+
+bool Range::foldConstants()
+{
+	const bool begin = fold(this->begin);
+	const bool step = !this->step || fold(this->step);
+	const bool end = fold(this->end);
+	if (!begin || !step || !end) return false;
+
+	// Ranges in the wrong direction print a warning, see evaluate()
+	const ValuePtr beginValue = value_of(this->begin);
+	const ValuePtr endValue = value_of(this->end);
+	if (beginValue->type() != Value::ValueType::NUMBER || endValue->type() != Value::ValueType::NUMBER) return true;
+	const double begin_val = beginValue->toDouble();
+	const double end_val = endValue->toDouble();
+	if (!this->step) return begin_val <= end_val;
+	const ValuePtr stepValue = value_of(this->step);
+	if (stepValue->type() != Value::ValueType::NUMBER) return true;
+	const double step_val = stepValue->toDouble();
+	return !(step_val > 0 && end_val < begin_val) && !(step_val < 0 && end_val > begin_val);
+}
+
+bool Vector::foldConstants()
+{
+	bool constant = true;
+	for (auto &e : this->children) {
+		if (!fold(e)) constant = false;
+	}
+	return constant;
+}
+
+bool MemberLookup::foldConstants()
+{
+	fold(this->expr);
+	return false;
+}
+
+bool FunctionCall::foldConstants()
+{
+	if (!this->isLookup) fold(this->expr);
+	fold(this->arguments);
+	return false;
+}
+
+bool FunctionDefinition::foldConstants()
+{
+	fold(this->definition_arguments);
+	fold(this->expr);
+	return false;
+}
+
+bool Assert::foldConstants()
+{
+	fold(this->arguments);
+	if (this->expr) fold(this->expr);
+	return false;
+}
+
+bool Echo::foldConstants()
+{
+	fold(this->arguments);
+	if (this->expr) fold(this->expr);
+	return false;
+}
+
+bool Let::foldConstants()
+{
+	fold(this->arguments);
+	fold(this->expr);
+	return false;
+}
+
+bool LcIf::foldConstants()
+{
+	fold(this->cond);
+	fold(this->ifexpr);
+	if (this->elseexpr) fold(this->elseexpr);
+	return false;
+}
+
+bool LcFor::foldConstants()
+{
+	fold(this->arguments);
+	fold(this->expr);
+	return false;
+}
+
+bool LcForC::foldConstants()
+{
+	fold(this->arguments);
+	fold(this->incr_arguments);
+	fold(this->cond);
+	fold(this->expr);
+	return false;
+}
+
+bool LcEach::foldConstants()
+{
+	fold(this->expr);
+	return false;
+}
+
+bool LcLet::foldConstants()
+{
+	fold(this->arguments);
+	fold(this->expr);
+	return false;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+/*!
+	Constant folding, run on the AST of each file once it is parsed.
+
+	Constant subexpressions, i.e. operators, vectors and ranges built only
+	from literals, are evaluated once and replaced by Literals holding the
+	value. Evaluating them again then only copies a ValuePtr, and nested
+	constant vectors, such as the points of a polyhedron, share their
+	elements instead of rebuilding them on every reference.
+
+	Folded Literals keep the expression they replace, so the AST still
+	prints as written. Expressions whose evaluation could print a warning
+	are not folded, as the warning must be printed on every evaluation.
+*/
+void fold_constants(class LocalScope &scope);
@@ -33,15 +33,24 @@
 #include "ModuleInstantiation.h"
 #include "builtin.h"
 #include "printutils.h"
+#include "FunctionCache.h"
 #include <boost/filesystem.hpp>
+#include <algorithm>
 namespace fs = boost::filesystem;
 
-// $children is not a config_variable. config_variables have dynamic scope, 
-// meaning they are passed down the call chain implicitly.
-// $children is simply misnamed and shouldn't have included the '$'.
-static bool is_config_variable(const std::string &name)
+const ValuePtr *Context::ValueMap::find(const VariableSlot &slot) const
 {
-	return name[0] == '$' && name != "$children";
+	auto it = std::lower_bound(this->values.begin(), this->values.end(), slot,
+		[](const value_type &value, const VariableSlot &slot) { return value.first < slot; });
+	return (it != this->values.end() && it->first == slot) ? &it->second : nullptr;
+}
+
+void Context::ValueMap::set(const VariableSlot &slot, const ValuePtr &value)
+{
+	auto it = std::lower_bound(this->values.begin(), this->values.end(), slot,
+		[](const value_type &value, const VariableSlot &slot) { return value.first < slot; });
+	if (it != this->values.end() && it->first == slot) it->second = value;
+	else this->values.emplace(it, slot, value);
 }
 
 /*!
@@ -86,7 +95,7 @@ void Context::setVariables(const std::shared_ptr<EvalContext> evalctx, const Ass
 {
 	// Set any default values
 	for (const auto &arg : args) {
-		set_variable(arg->name, arg->expr ? arg->expr->evaluate(this->parent) : ValuePtr::undefined);
+		set_variable(arg->slot, arg->expr ? arg->expr->evaluate(this->parent) : ValuePtr::undefined);
 	}
 	
 	if (evalctx) {
@@ -97,10 +106,15 @@ void Context::setVariables(const std::shared_ptr<EvalContext> evalctx, const Ass
 	}
 }
 
+void Context::set_variable(const VariableSlot &slot, const ValuePtr &value)
+{
+	if (slot.isConfigVariable()) this->config_variables.set(slot, value);
+	else this->variables.set(slot, value);
+}
+
 void Context::set_variable(const std::string &name, const ValuePtr &value)
 {
-	if (is_config_variable(name)) this->config_variables[name] = value;
-	else this->variables[name] = value;
+	set_variable(VariableSlot(name), value);
 }
 
 void Context::set_variable(const std::string &name, const Value &value)
@@ -110,11 +124,12 @@ void Context::set_variable(const std::string &name, const Value &value)
 
 void Context::set_constant(const std::string &name, const ValuePtr &value)
 {
-	if (this->constants.find(name) != this->constants.end()) {
+	VariableSlot slot(name);
+	if (this->constants.contains(slot)) {
 		PRINTB("WARNING: Attempt to modify constant '%s'.", name);
 	}
 	else {
-		this->constants[name] = value;
+		this->constants.set(slot, value);
 	}
 }
 
@@ -148,39 +163,45 @@ void Context::apply_config_variables(const std::shared_ptr<Context> other)
 	}
 }
 
-ValuePtr Context::lookup_variable(const std::string &name, bool silent, const Location &loc) const
+ValuePtr Context::lookup_variable(const VariableSlot &slot, bool silent, const Location &loc) const
 {
 	if (!this->ctx_stack) {
 		PRINT("ERROR: Context had null stack in lookup_variable()!!");
 		return ValuePtr::undefined;
 	}
-	if (is_config_variable(name)) {
+	if (slot.isConfigVariable()) {
+		// Special variables are dynamically scoped, see FunctionCache
+		FunctionCache::markImpure();
 		for (int i = this->ctx_stack->size()-1; i >= 0; i--) {
-			const auto &confvars = ctx_stack->at(i)->config_variables;
-			if (confvars.find(name) != confvars.end()) {
-				return confvars.find(name)->second;
-			}
+			if (const auto value = ctx_stack->at(i)->config_variables.find(slot)) return *value;
 		}
 		if (!silent) {
-			PRINTB("WARNING: Ignoring unknown variable '%s', %s.", name % loc.toRelativeString(this->documentPath()));
+			PRINTB("WARNING: Ignoring unknown variable '%s', %s.", slot.name() % loc.toRelativeString(this->documentPath()));
 		}
 		return ValuePtr::undefined;
 	}
-	if (!this->parent && this->constants.find(name) != this->constants.end()) {
-		return this->constants.find(name)->second;
-	}
-	if (this->variables.find(name) != this->variables.end()) {
-		return this->variables.find(name)->second;
-	}
-	if (this->parent) {
-		return this->parent->lookup_variable(name, silent, loc);
+	const Context *c = this;
+	while (true) {
+		if (!c->parent) {
+			if (const auto value = c->constants.find(slot)) return *value;
+		}
+		if (const auto value = c->variables.find(slot)) {
+			FunctionCache::noteLookup(c);
+			return *value;
+		}
+		if (!c->parent) break;
+		c = c->parent.get();
 	}
 	if (!silent) {
-		PRINTB("WARNING: Ignoring unknown variable '%s', %s.", name % loc.toRelativeString(this->documentPath()));
+		PRINTB("WARNING: Ignoring unknown variable '%s', %s.", slot.name() % loc.toRelativeString(c->documentPath()));
 	}
 	return ValuePtr::undefined;
 }
 
+ValuePtr Context::lookup_variable(const std::string &name, bool silent, const Location &loc) const
+{
+	return lookup_variable(VariableSlot(name), silent, loc);
+}
 
 double Context::lookup_variable_with_default(const std::string &variable, const double &def, const Location &loc) const
 {
@@ -194,15 +215,20 @@ std::string Context::lookup_variable_with_default(const std::string &variable, c
 	return (v->type() == Value::ValueType::STRING) ? v->toString() : def;
 }
 
-bool Context::has_local_variable(const std::string &name) const
+bool Context::has_local_variable(const VariableSlot &slot) const
 {
-	if (is_config_variable(name)) {
-		return config_variables.find(name) != config_variables.end();
+	if (slot.isConfigVariable()) {
+		return config_variables.contains(slot);
 	}
-	if (!parent && constants.find(name) != constants.end()) {
+	if (!parent && constants.contains(slot)) {
 		return true;
 	}
-	return variables.find(name) != variables.end();
+	return variables.contains(slot);
+}
+
+bool Context::has_local_variable(const std::string &name) const
+{
+	return has_local_variable(VariableSlot(name));
 }
 
 /**
@@ -265,20 +291,21 @@ std::string Context::dump(const AbstractModule *mod, const ModuleInstantiation *
 		if (m) {
 			s << "  module args:";
 			for(const auto &arg : m->definition_arguments) {
-				s << boost::format("    %s = %s\n") % arg->name % variables[arg->name];
+				const auto value = variables.find(arg->slot);
+				s << boost::format("    %s = %s\n") % arg->name % (value ? (*value)->toEchoString() : "");
 			}
 		}
 	}
 	typedef std::pair<std::string, ValuePtr> ValueMapType;
 	s << "  vars:\n";
 	for(const auto &v : constants) {
-		s << boost::format("    %s = %s\n") % v.first % v.second->toEchoString();
+		s << boost::format("    %s = %s\n") % v.first.name() % v.second->toEchoString();
 	}
 	for(const auto &v : variables) {
-		s << boost::format("    %s = %s\n") % v.first % v.second->toEchoString();
+		s << boost::format("    %s = %s\n") % v.first.name() % v.second->toEchoString();
 	}
 	for(const auto &v : config_variables) {
-		s << boost::format("    %s = %s\n") % v.first % v.second->toEchoString();
+		s << boost::format("    %s = %s\n") % v.first.name() % v.second->toEchoString();
 	}
 	return s.str();
 }
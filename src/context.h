@@ -4,9 +4,9 @@
 #include <string>
 #include <vector>
 #include <memory>
-#include <unordered_map>
 #include "value.h"
 #include "Assignment.h"
+#include "VariableSlot.h"
 #include "memory.h"
 
 /**
@@ -64,6 +64,7 @@ public:
 
 	void setVariables(const std::shared_ptr<EvalContext> evalctx, const AssignmentList &args, const AssignmentList &optargs={}, bool usermodule=false);
 
+	void set_variable(const VariableSlot &slot, const ValuePtr &value);
 	void set_variable(const std::string &name, const ValuePtr &value);
 	void set_variable(const std::string &name, const Value &value);
 	void set_constant(const std::string &name, const ValuePtr &value);
@@ -71,10 +72,12 @@ public:
 
 	void apply_variables(const std::shared_ptr<Context> other);
 	void apply_config_variables(const std::shared_ptr<Context> other);
+	ValuePtr lookup_variable(const VariableSlot &slot, bool silent = false, const Location &loc=Location::NONE) const;
 	ValuePtr lookup_variable(const std::string &name, bool silent = false, const Location &loc=Location::NONE) const;
 	double lookup_variable_with_default(const std::string &variable, const double &def, const Location &loc=Location::NONE) const;
 	std::string lookup_variable_with_default(const std::string &variable, const std::string &def, const Location &loc=Location::NONE) const;
 
+	bool has_local_variable(const VariableSlot &slot) const;
 	bool has_local_variable(const std::string &name) const;
 
 	void setDocumentPath(const std::string &path) { this->document_path = std::make_shared<std::string>(path); }
@@ -87,7 +90,28 @@ protected:
 	const std::shared_ptr<Context> parent;
 	Stack *ctx_stack;
 
-	typedef std::unordered_map<std::string, ValuePtr> ValueMap;
+	/*!
+		Variables of one context, sorted by slot. Most contexts only hold a
+		few variables, which a binary search in a flat vector finds faster
+		than a hash map, and which are cheaper to set up for every call.
+	*/
+	class ValueMap
+	{
+	public:
+		typedef std::pair<VariableSlot, ValuePtr> value_type;
+		typedef std::vector<value_type>::const_iterator const_iterator;
+
+		const ValuePtr *find(const VariableSlot &slot) const;
+		void set(const VariableSlot &slot, const ValuePtr &value);
+		bool contains(const VariableSlot &slot) const { return find(slot) != nullptr; }
+		bool empty() const { return this->values.empty(); }
+		const_iterator begin() const { return this->values.begin(); }
+		const_iterator end() const { return this->values.end(); }
+
+	private:
+		std::vector<value_type> values;
+	};
+
 	ValueMap constants;
 	ValueMap variables;
 	ValueMap config_variables;
@@ -99,12 +123,15 @@ public:
 	virtual std::string dump(const class AbstractModule *mod, const ModuleInstantiation *inst);
 #endif
 
-	// Making friends with evaluate_function() to allow it to call the Context
+	// Making friends with evaluate_function_body() to allow it to call the Context
 	// constructor for creating ContextHandle objects in-place in the local
 	// context list. This is needed as ContextHandle handles the Context
 	// stack via RAII so we need to use emplace_front() to create the objects.
-	friend ValuePtr evaluate_function(const std::string& name,
+	friend ValuePtr evaluate_function_body(const std::string& name,
 			const std::shared_ptr<Expression>& expr, const AssignmentList &definition_arguments,
-			const std::shared_ptr<Context>& ctx, const std::shared_ptr<EvalContext>& evalctx,
-			const Location& loc);
+			const std::shared_ptr<Context>& c_next, const Location& loc);
+	// Same for the bytecode version of evaluate_function_body()
+	friend class Bytecode;
+	// Reads the arguments of calls and the parents of contexts
+	friend class FunctionCache;
 };
@@ -71,7 +71,7 @@ void ControlModule::for_eval(AbstractNode &node, const ModuleInstantiation &inst
 							const std::shared_ptr<Context> ctx, const std::shared_ptr<EvalContext> evalctx)
 {
 	if (evalctx->numArgs() > l) {
-		const std::string &it_name = evalctx->getArgName(l);
+		const VariableSlot &it_slot = evalctx->getArgSlot(l);
 		ValuePtr it_values = evalctx->getArgValue(l, ctx);
 		ContextHandle<Context> c{Context::create<Context>(ctx)};
 		if (it_values->type() == Value::ValueType::RANGE) {
@@ -81,25 +81,25 @@ void ControlModule::for_eval(AbstractNode &node, const ModuleInstantiation &inst
 				PRINTB("WARNING: Bad range parameter in for statement: too many elements (%lu), %s", steps % inst.location().toRelativeString(ctx->documentPath()));
 			} else {
 				for (RangeType::iterator it = range.begin();it != range.end();it++) {
-					c->set_variable(it_name, ValuePtr(*it));
+					c->set_variable(it_slot, ValuePtr(*it));
 					for_eval(node, inst, l+1, c.ctx, evalctx);
 				}
 			}
 		}
 		else if (it_values->type() == Value::ValueType::VECTOR) {
 			for (size_t i = 0; i < it_values->toVector().size(); i++) {
-				c->set_variable(it_name, it_values->toVector()[i]);
+				c->set_variable(it_slot, it_values->toVector()[i]);
 				for_eval(node, inst, l+1, c.ctx, evalctx);
 			}
 		}
 		else if (it_values->type() == Value::ValueType::STRING) {
 			utf8_split(it_values->toString(), [&](ValuePtr v) {
-				c->set_variable(it_name, v);
+				c->set_variable(it_slot, v);
 				for_eval(node, inst, l+1, c.ctx, evalctx);
 			});
 		}
 		else if (it_values->type() != Value::ValueType::UNDEFINED) {
-			c->set_variable(it_name, it_values);
+			c->set_variable(it_slot, it_values);
 			for_eval(node, inst, l+1, c.ctx, evalctx);
 		}
 	} else if (l > 0) {
@@ -107,7 +107,7 @@ void ControlModule::for_eval(AbstractNode &node, const ModuleInstantiation &inst
 		// the local scope (as they may depend on the for loop variables
 		ContextHandle<Context> c{Context::create<Context>(ctx)};
 		for (const auto &assignment : inst.scope.assignments) {
-			c->set_variable(assignment->name, assignment->expr->evaluate(c.ctx));
+			c->set_variable(assignment->slot, assignment->expr->evaluate(c.ctx));
 		}
 
 		std::vector<AbstractNode *> instantiatednodes = inst.instantiateChildren(c.ctx);
@@ -311,7 +311,7 @@ AbstractNode *ControlModule::instantiate(const std::shared_ptr<Context>& ctx, co
 		ContextHandle<Context> c{Context::create<Context>(evalctx)};
 		for (size_t i = 0; i < evalctx->numArgs(); i++) {
 			if (!evalctx->getArgName(i).empty())
-				c->set_variable(evalctx->getArgName(i), evalctx->getArgValue(i));
+				c->set_variable(evalctx->getArgSlot(i), evalctx->getArgValue(i));
 		}
 		// Let any local variables override the parameters
 		inst->scope.apply(c.ctx);
@@ -121,10 +121,16 @@ void CSGLeaf::initBoundingBox()
 	this->bbox = this->matrix * this->geom->getBoundingBox();
 }
 
+/*!
+	Also called by CSGTreeNormalizer after replacing children, which may
+	leave a child nullptr until the operation is collapsed. Such children
+	count as empty.
+*/
 void CSGOperation::initBoundingBox()
 {
-	const auto &leftbox = this->left()->getBoundingBox();
-	const auto &rightbox = this->right()->getBoundingBox();
+	static const BoundingBox empty;
+	const auto &leftbox = this->left() ? this->left()->getBoundingBox() : empty;
+	const auto &rightbox = this->right() ? this->right()->getBoundingBox() : empty;
 	Vector3d newmin, newmax;
 	switch (this->type) {
 	case OpenSCADOperator::UNION:
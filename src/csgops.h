@@ -11,4 +11,5 @@ public:
 	CsgOpNode(const ModuleInstantiation *mi, const std::shared_ptr<EvalContext> &ctx, OpenSCADOperator type) : AbstractNode(mi, ctx), type(type) { }
 	std::string toString() const override;
 	std::string name() const override;
+	AbstractNode *clone() const override { return cloneAs(*this); }
 };
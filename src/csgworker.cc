@@ -0,0 +1,98 @@
+#include "csgworker.h"
+#include <QThread>
+
+#include "Tree.h"
+#include "GeometryEvaluator.h"
+#include "CSGTreeEvaluator.h"
+#include "CSGTreeNormalizer.h"
+#include "csgnode.h"
+#include "RenderStatistic.h"
+#include "progress.h"
+#include "printutils.h"
+#include "exceptions.h"
+
+CSGWorker::CSGWorker()
+{
+	this->tree = nullptr;
+	this->normalizelimit = 0;
+	this->thread = new QThread();
+	if (this->thread->stackSize() < 1024*1024) this->thread->setStackSize(1024*1024);
+	connect(this->thread, SIGNAL(started()), this, SLOT(work()));
+	moveToThread(this->thread);
+}
+
+CSGWorker::~CSGWorker()
+{
+	delete this->thread;
+}
+
+void CSGWorker::start(const Tree &tree, size_t normalizelimit)
+{
+	this->tree = &tree;
+	this->normalizelimit = normalizelimit;
+	this->thread->start();
+}
+
+void CSGWorker::clear()
+{
+	this->csgRoot.reset();
+	this->normalizedRoot.reset();
+	this->root_products.reset();
+	this->highlights_products.reset();
+	this->background_products.reset();
+}
+
+void CSGWorker::work()
+{
+	clear();
+	try {
+		GeometryEvaluator geomevaluator(*this->tree);
+		CSGTreeEvaluator csgrenderer(*this->tree, &geomevaluator);
+		this->csgRoot = csgrenderer.buildCSGTree(*this->tree->root());
+		RenderStatistic::printCacheStatistic();
+
+		PRINT("Compiling design (CSG Products normalization)...");
+		CSGTreeNormalizer normalizer(this->normalizelimit);
+		if (this->csgRoot) {
+			this->normalizedRoot = normalizer.normalize(this->csgRoot);
+			if (this->normalizedRoot) {
+				this->root_products.reset(new CSGProducts());
+				this->root_products->import(this->normalizedRoot);
+			}
+			else {
+				PRINT("WARNING: CSG normalization resulted in an empty tree");
+			}
+		}
+
+		const auto &highlight_terms = csgrenderer.getHighlightNodes();
+		if (highlight_terms.size() > 0) {
+			PRINTB("Compiling highlights (%d CSG Trees)...", highlight_terms.size());
+			this->highlights_products.reset(new CSGProducts());
+			for (const auto &term : highlight_terms) {
+				auto nterm = normalizer.normalize(term);
+				if (nterm) this->highlights_products->import(nterm);
+			}
+		}
+
+		const auto &background_terms = csgrenderer.getBackgroundNodes();
+		if (background_terms.size() > 0) {
+			PRINTB("Compiling background (%d CSG Trees)...", background_terms.size());
+			this->background_products.reset(new CSGProducts());
+			for (const auto &term : background_terms) {
+				auto nterm = normalizer.normalize(term);
+				if (nterm) this->background_products->import(nterm);
+			}
+		}
+	}
+	catch (const ProgressCancelException &e) {
+		PRINT("CSG generation cancelled.");
+		clear();
+	}
+	catch (const HardWarningException &e) {
+		PRINT("CSG generation cancelled due to hardwarning being enabled.");
+		clear();
+	}
+
+	emit done();
+	thread->quit();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QObject>
+#include "memory.h"
+
+/*!
+	Builds and normalizes the CSG tree for a preview in a separate thread,
+	like CGALWorker does for renders, so the GUI stays responsive.
+	Cancelling through the progress widget stops it.
+
+	The results are only valid once done() has been emitted, and until the
+	next start().
+*/
+class CSGWorker : public QObject
+{
+	Q_OBJECT;
+public:
+	CSGWorker();
+	~CSGWorker();
+
+	shared_ptr<class CSGNode> csgRoot;
+	shared_ptr<CSGNode> normalizedRoot;
+	shared_ptr<class CSGProducts> root_products;
+	shared_ptr<CSGProducts> highlights_products;
+	shared_ptr<CSGProducts> background_products;
+
+public slots:
+	void start(const class Tree &tree, size_t normalizelimit);
+
+protected slots:
+	void work();
+
+signals:
+	void done();
+
+protected:
+	void clear();
+
+	class QThread *thread;
+	const class Tree *tree;
+	size_t normalizelimit;
+};
@@ -19,6 +19,12 @@ const std::string &EvalContext::getArgName(size_t i) const
 	return this->eval_arguments[i]->name;
 }
 
+const VariableSlot &EvalContext::getArgSlot(size_t i) const
+{
+	assert(i < this->eval_arguments.size());
+	return this->eval_arguments[i]->slot;
+}
+
 ValuePtr EvalContext::getArgValue(size_t i, const std::shared_ptr<Context> ctx) const
 {
 	assert(i < this->eval_arguments.size());
@@ -90,10 +96,10 @@ void EvalContext::assignTo(std::shared_ptr<Context> target) const
 		
 		if(assignment->name.empty()){
 			PRINTB("WARNING: Assignment without variable name %s, %s", v->toEchoString() % this->loc.toRelativeString(target->documentPath()));
-		}else if (target->has_local_variable(assignment->name)) {
+		}else if (target->has_local_variable(assignment->slot)) {
 			PRINTB("WARNING: Ignoring duplicate variable assignment %s = %s, %s", assignment->name % v->toEchoString() % this->loc.toRelativeString(target->documentPath()));
 		} else {
-			target->set_variable(assignment->name, v);
+			target->set_variable(assignment->slot, v);
 		}
 	}
 }
@@ -134,7 +140,8 @@ std::string EvalContext::dump(const AbstractModule *mod, const ModuleInstantiati
 		if (m) {
 			s << boost::format("  module args:");
 			for(const auto &arg : m->definition_arguments) {
-				s << boost::format("    %s = %s") % arg->name % *(variables[arg->name]);
+				const auto value = variables.find(arg->slot);
+				s << boost::format("    %s = %s") % arg->name % *(value ? *value : ValuePtr::undefined);
 			}
 		}
 	}
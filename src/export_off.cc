@@ -48,9 +48,13 @@ struct IndexedMesh {
 
 static void append_geometry(const PolySet &ps, IndexedMesh &mesh)
 {
-	for(const auto &p : ps.polygons) {
-		for(const auto &v : p) {
-			mesh.indices.push_back(mesh.vertices.lookup(v));
+	// Look up each shared vertex only once
+	std::vector<int> indices(ps.getVertices().size(), -1);
+	for(const auto &p : ps.polygons()) {
+		for (size_t i = 0; i < p.size(); i++) {
+			int &index = indices[p.index(i)];
+			if (index < 0) index = mesh.vertices.lookup(p[i]);
+			mesh.indices.push_back(index);
 		}
 		mesh.numfaces++;
 		mesh.indices.push_back(-1);
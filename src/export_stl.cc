@@ -54,7 +54,7 @@ void append_stl(const PolySet &ps, std::ostream &output)
 	PolySet triangulated(3);
 	PolysetUtils::tessellate_faces(ps, triangulated);
 
-	for(const auto &p : triangulated.polygons) {
+	for(const auto &p : triangulated.polygons()) {
 		assert(p.size() == 3); // STL only allows triangles
 		std::array<std::string, 3> vertexStrings;
 		std::transform(p.cbegin(), p.cend(), vertexStrings.begin(), toString);
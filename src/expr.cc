@@ -153,41 +153,50 @@ ValuePtr BinaryOp::evaluate(const std::shared_ptr<Context>& context) const
 	case Op::LogicalOr:
 		return this->left->evaluate(context) || this->right->evaluate(context);
 		break;
+	default:
+		break;
+	}
+
+	// Evaluate the operands left to right. The order of the arguments of the
+	// ValuePtr operators is up to the compiler, and the bytecode must agree.
+	const ValuePtr left = this->left->evaluate(context);
+	const ValuePtr right = this->right->evaluate(context);
+	switch (this->op) {
 	case Op::Exponent:
-        return ValuePtr(pow(this->left->evaluate(context)->toDouble(), this->right->evaluate(context)->toDouble()));
+        return ValuePtr(pow(left->toDouble(), right->toDouble()));
 		break;
 	case Op::Multiply:
-		return this->left->evaluate(context) * this->right->evaluate(context);
+		return left * right;
 		break;
 	case Op::Divide:
-		return this->left->evaluate(context) / this->right->evaluate(context);
+		return left / right;
 		break;
 	case Op::Modulo:
-		return this->left->evaluate(context) % this->right->evaluate(context);
+		return left % right;
 		break;
 	case Op::Plus:
-		return this->left->evaluate(context) + this->right->evaluate(context);
+		return left + right;
 		break;
 	case Op::Minus:
-		return this->left->evaluate(context) - this->right->evaluate(context);
+		return left - right;
 		break;
 	case Op::Less:
-		return this->left->evaluate(context) < this->right->evaluate(context);
+		return left < right;
 		break;
 	case Op::LessEqual:
-		return this->left->evaluate(context) <= this->right->evaluate(context);
+		return left <= right;
 		break;
 	case Op::Greater:
-		return this->left->evaluate(context) > this->right->evaluate(context);
+		return left > right;
 		break;
 	case Op::GreaterEqual:
-		return this->left->evaluate(context) >= this->right->evaluate(context);
+		return left >= right;
 		break;
 	case Op::Equal:
-		return this->left->evaluate(context) == this->right->evaluate(context);
+		return left == right;
 		break;
 	case Op::NotEqual:
-		return this->left->evaluate(context) != this->right->evaluate(context);
+		return left != right;
 		break;
 	default:
 		return ValuePtr::undefined;
@@ -278,7 +287,8 @@ ArrayLookup::ArrayLookup(Expression *array, Expression *index, const Location &l
 }
 
 ValuePtr ArrayLookup::evaluate(const std::shared_ptr<Context>& context) const {
-	return this->array->evaluate(context)[this->index->evaluate(context)];
+	const ValuePtr array = this->array->evaluate(context);
+	return array[this->index->evaluate(context)];
 }
 
 void ArrayLookup::print(std::ostream &stream, const std::string &) const
@@ -290,6 +300,11 @@ Literal::Literal(const ValuePtr &val, const Location &loc) : Expression(loc), va
 {
 }
 
+Literal::Literal(const ValuePtr &val, const shared_ptr<Expression> &folded)
+	: Expression(folded->location()), value(val), folded(folded)
+{
+}
+
 ValuePtr Literal::evaluate(const std::shared_ptr<Context>&) const
 {
 	return this->value;
@@ -297,7 +312,8 @@ ValuePtr Literal::evaluate(const std::shared_ptr<Context>&) const
 
 void Literal::print(std::ostream &stream, const std::string &) const
 {
-    stream << *this->value;
+	if (this->folded) stream << *this->folded;
+	else stream << *this->value;
 }
 
 Range::Range(Expression *begin, Expression *end, const Location &loc)
@@ -428,18 +444,18 @@ void Vector::print(std::ostream &stream, const std::string &) const
 	stream << "]";
 }
 
-Lookup::Lookup(const std::string &name, const Location &loc) : Expression(loc), name(name)
+Lookup::Lookup(const std::string &name, const Location &loc) : Expression(loc), name(name), slot(name)
 {
 }
 
 ValuePtr Lookup::evaluate(const std::shared_ptr<Context>& context) const
 {
-	return context->lookup_variable(this->name,false,loc);
+	return context->lookup_variable(this->slot,false,loc);
 }
 
 ValuePtr Lookup::evaluateSilently(const std::shared_ptr<Context>& context) const
 {
-	return context->lookup_variable(this->name,true);
+	return context->lookup_variable(this->slot,true);
 }
 
 void Lookup::print(std::ostream &stream, const std::string &) const
@@ -544,12 +560,15 @@ FunctionCall::FunctionCall(Expression *expr, const AssignmentList &args, const L
  * Evaluates call parameters using context, and assigns the resulting values to tailCallContext.
  * As the name suggests, it's meant for basic tail recursion, where the function calls itself.
 */
-void FunctionCall::prepareTailCallContext(const std::shared_ptr<Context> context, std::shared_ptr<Context> tailCallContext, const AssignmentList &definition_arguments)
+void FunctionCall::prepareTailCallContext(const std::shared_ptr<Context> context, std::shared_ptr<Context> tailCallContext, const AssignmentList &definition_arguments) const
 {
 	if (this->resolvedArguments.empty() && !this->arguments.empty()) {
 		// Figure out parameter names
 		ContextHandle<EvalContext> ec{Context::create<EvalContext>(context, this->arguments, this->loc)};
 		this->resolvedArguments = ec->resolveArguments(definition_arguments, {}, false);
+		for (const auto &ass : this->resolvedArguments) {
+			this->resolvedSlots.emplace_back(VariableSlot(ass.first), ass.second);
+		}
 	}
 
 	// FIXME: evaluate defaultArguments in FunctionDefinition / UserFunction and pass to FunctionCall instead of definition_arguments ?
@@ -557,18 +576,18 @@ void FunctionCall::prepareTailCallContext(const std::shared_ptr<Context> context
 		// Assign default values for unspecified parameters
 		for (const auto &arg : definition_arguments) {
 			if (this->resolvedArguments.find(arg->name) == this->resolvedArguments.end()) {
-				this->defaultArguments.emplace_back(arg->name, arg->expr ? arg->expr->evaluate(context) : ValuePtr::undefined);
+				this->defaultArguments.emplace_back(arg->slot, arg->expr ? arg->expr->evaluate(context) : ValuePtr::undefined);
 			}
 		}
 	}
 
-	std::vector<std::pair<std::string, ValuePtr>> variables;
-	variables.reserve(this->defaultArguments.size() + this->resolvedArguments.size());
+	std::vector<std::pair<VariableSlot, ValuePtr>> variables;
+	variables.reserve(this->defaultArguments.size() + this->resolvedSlots.size());
 	// Set default values for unspecified parameters
 	variables.insert(variables.begin(), this->defaultArguments.begin(), this->defaultArguments.end());
 	// Set the given parameters
-	for (const auto &ass : this->resolvedArguments) {
-		variables.emplace_back(ass.first, ass.second->evaluate(context));
+	for (const auto &arg : this->resolvedSlots) {
+		variables.emplace_back(arg.first, arg.second->evaluate(context));
 	}
 	// Apply to tailCallContext
 	for (const auto &var : variables) {
@@ -731,7 +750,7 @@ ValuePtr LcIf::evaluate(const std::shared_ptr<Context>& context) const
         }
     }
 
-    return ValuePtr(vec);
+    return ValuePtr(Value::unpacked(vec));
 }
 
 void LcIf::print(std::ostream &stream, const std::string &) const
@@ -776,9 +795,9 @@ ValuePtr LcEach::evaluate(const std::shared_ptr<Context>& context) const
     }
 
     if (isListComprehension(this->expr)) {
-        return ValuePtr(flatten(vec));
+        return ValuePtr(Value::unpacked(flatten(vec)));
     } else {
-        return ValuePtr(vec);
+        return ValuePtr(Value::unpacked(vec));
     }
 }
 
@@ -801,7 +820,7 @@ ValuePtr LcFor::evaluate(const std::shared_ptr<Context>& context) const
     ContextHandle<Context> assign_context{Context::create<Context>(context)};
 
     // comprehension for statements are by the parser reduced to only contain one single element
-    const std::string &it_name = for_context->getArgName(0);
+    const VariableSlot &it_slot = for_context->getArgSlot(0);
     ValuePtr it_values = for_context->getArgValue(0, assign_context.ctx);
 
     ContextHandle<Context> c{Context::create<Context>(context)};
@@ -813,29 +832,29 @@ ValuePtr LcFor::evaluate(const std::shared_ptr<Context>& context) const
             PRINTB("WARNING: Bad range parameter in for statement: too many elements (%lu), %s", steps % loc.toRelativeString(context->documentPath()));
         } else {
             for (RangeType::iterator it = range.begin();it != range.end();it++) {
-                c->set_variable(it_name, ValuePtr(*it));
+                c->set_variable(it_slot, ValuePtr(*it));
                 vec.push_back(this->expr->evaluate(c.ctx));
             }
         }
     } else if (it_values->type() == Value::ValueType::VECTOR) {
         for (size_t i = 0; i < it_values->toVector().size(); i++) {
-            c->set_variable(it_name, it_values->toVector()[i]);
+            c->set_variable(it_slot, it_values->toVector()[i]);
             vec.push_back(this->expr->evaluate(c.ctx));
         }
     } else if (it_values->type() == Value::ValueType::STRING) {
         utf8_split(it_values->toString(), [&](ValuePtr v) {
-            c->set_variable(it_name, v);
+            c->set_variable(it_slot, v);
             vec.push_back(this->expr->evaluate(c.ctx));
         });
     } else if (it_values->type() != Value::ValueType::UNDEFINED) {
-        c->set_variable(it_name, it_values);
+        c->set_variable(it_slot, it_values);
         vec.push_back(this->expr->evaluate(c.ctx));
     }
 
     if (isListComprehension(this->expr)) {
-        return ValuePtr(flatten(vec));
+        return ValuePtr(Value::unpacked(flatten(vec)));
     } else {
-        return ValuePtr(vec);
+        return ValuePtr(Value::unpacked(vec));
     }
 }
 
@@ -872,9 +891,9 @@ ValuePtr LcForC::evaluate(const std::shared_ptr<Context>& context) const
     }    
 
     if (isListComprehension(this->expr)) {
-        return ValuePtr(flatten(vec));
+        return ValuePtr(Value::unpacked(flatten(vec)));
     } else {
-        return ValuePtr(vec);
+        return ValuePtr(Value::unpacked(vec));
     }
 }
 
@@ -915,7 +934,7 @@ void evaluate_assert(const std::shared_ptr<Context>& context, const std::shared_
 	for (const auto &arg : args) {
 		auto it = assignments.find(arg->name);
 		if (it != assignments.end()) {
-			c->set_variable(arg->name, assignments[arg->name]->evaluate(evalctx));
+			c->set_variable(arg->slot, it->second->evaluate(evalctx));
 		}
 	}
 	
@@ -942,7 +961,12 @@ ValuePtr evaluate_function(const std::string& name, const std::shared_ptr<Expres
 	if (!expr) return ValuePtr::undefined;
 	ContextHandle<Context> c_next{Context::create<Context>(ctx)}; // Context for next tail call
 	c_next->setVariables(evalctx, definition_arguments);
+	return evaluate_function_body(name, expr, definition_arguments, c_next.ctx, loc);
+}
 
+ValuePtr evaluate_function_body(const std::string& name, const std::shared_ptr<Expression>& expr, const AssignmentList &definition_arguments,
+		const std::shared_ptr<Context>& c_next, const Location& loc)
+{
 	// Outer loop: to allow tail calls
 	unsigned int counter = 0;
 	ValuePtr result;
@@ -951,7 +975,7 @@ ValuePtr evaluate_function(const std::string& name, const std::shared_ptr<Expres
 		// I.e. "let(x=33) let(x=42) x" should evaluate to 42.
 		// Cannot use std::vector, as it invalidates raw pointers.
 		std::forward_list<ContextHandle<Context>> c_local_stack;
-		c_local_stack.emplace_front(std::shared_ptr<Context>(new Context(c_next.ctx)));
+		c_local_stack.emplace_front(std::shared_ptr<Context>(new Context(c_next)));
 		std::shared_ptr<Context> c_local = c_local_stack.front().ctx;
 
 		// Inner loop: to follow a single execution path
@@ -986,7 +1010,7 @@ ValuePtr evaluate_function(const std::string& name, const std::shared_ptr<Expres
 				const shared_ptr<FunctionCall> &call = static_pointer_cast<FunctionCall>(subExpr);
 				if (name == call->get_name()) {
 					// Update c_next with new parameters for tail call
-					call->prepareTailCallContext(c_local, c_next.ctx, definition_arguments);
+					call->prepareTailCallContext(c_local, c_next, definition_arguments);
 					tailCall = true;
 				}
 				else {
@@ -1004,7 +1028,7 @@ ValuePtr evaluate_function(const std::string& name, const std::shared_ptr<Expres
 		}
 
 		if (counter++ == 1000000){
-			const std::string locs = loc.toRelativeString(ctx->documentPath());
+			const std::string locs = loc.toRelativeString(c_next->documentPath());
 			PRINTB("ERROR: Recursion detected calling function '%s' %s", name % locs);
 			throw RecursionException::create("function", name,loc);
 		}
@@ -13,6 +13,12 @@ public:
 	~Expression() {}
 	virtual bool isLiteral() const;
 	virtual ValuePtr evaluate(const std::shared_ptr<Context>& context) const = 0;
+	// Lowers the expression into bytecode, see bytecode.h. Unless
+	// overridden, the bytecode evaluates the expression with evaluate().
+	virtual void compile(class BytecodeCompiler &compiler, bool tail) const;
+	// Replaces constant subexpressions by Literals, see constantfolding.h.
+	// Returns true if the expression itself is constant.
+	virtual bool foldConstants();
 };
 
 class UnaryOp : public Expression
@@ -26,6 +32,8 @@ public:
 	UnaryOp(Op op, Expression *expr, const Location &loc);
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	void compile(class BytecodeCompiler &compiler, bool tail) const override;
+	bool foldConstants() override;
 
 private:
 	const char *opString() const;
@@ -57,6 +65,8 @@ public:
 	BinaryOp(Expression *left, Op op, Expression *right, const Location &loc);
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	void compile(class BytecodeCompiler &compiler, bool tail) const override;
+	bool foldConstants() override;
 
 private:
 	const char *opString() const;
@@ -73,6 +83,8 @@ public:
 	const shared_ptr<Expression>& evaluateStep(const std::shared_ptr<Context>& context) const;
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	void compile(class BytecodeCompiler &compiler, bool tail) const override;
+	bool foldConstants() override;
 private:
 	shared_ptr<Expression> cond;
 	shared_ptr<Expression> ifexpr;
@@ -85,6 +97,8 @@ public:
 	ArrayLookup(Expression *array, Expression *index, const Location &loc);
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	void compile(class BytecodeCompiler &compiler, bool tail) const override;
+	bool foldConstants() override;
 private:
 	shared_ptr<Expression> array;
 	shared_ptr<Expression> index;
@@ -94,11 +108,16 @@ class Literal : public Expression
 {
 public:
 	Literal(const ValuePtr &val, const Location &loc = Location::NONE);
+	// The precomputed value of a constant expression, printed as written
+	Literal(const ValuePtr &val, const shared_ptr<Expression> &folded);
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
-	bool isLiteral() const override { return true;}
+	void compile(class BytecodeCompiler &compiler, bool tail) const override;
+	bool isLiteral() const override { return !this->folded || this->folded->isLiteral(); }
+	bool foldConstants() override { return true; }
 private:
 	ValuePtr value;
+	shared_ptr<Expression> folded;
 };
 
 class Range : public Expression
@@ -108,6 +127,7 @@ public:
 	Range(Expression *begin, Expression *step, Expression *end, const Location &loc);
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	bool foldConstants() override;
 	bool isLiteral() const override;
 private:
 	shared_ptr<Expression> begin;
@@ -121,6 +141,8 @@ public:
 	Vector(const Location &loc);
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	void compile(class BytecodeCompiler &compiler, bool tail) const override;
+	bool foldConstants() override;
 	void emplace_back(Expression *expr);
 	bool isLiteral() const override;
 private:
@@ -134,9 +156,12 @@ public:
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	ValuePtr evaluateSilently(const std::shared_ptr<Context>& context) const;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	void compile(class BytecodeCompiler &compiler, bool tail) const override;
 	const std::string& get_name() const { return name; }
+	const VariableSlot &get_slot() const { return slot; }
 private:
 	std::string name;
+	VariableSlot slot;
 };
 
 class MemberLookup : public Expression
@@ -145,6 +170,8 @@ public:
 	MemberLookup(Expression *expr, const std::string &member, const Location &loc);
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	void compile(class BytecodeCompiler &compiler, bool tail) const override;
+	bool foldConstants() override;
 private:
 	shared_ptr<Expression> expr;
 	std::string member;
@@ -154,9 +181,11 @@ class FunctionCall : public Expression
 {
 public:
 	FunctionCall(Expression *expr, const AssignmentList &arglist, const Location &loc);
-	void prepareTailCallContext(const std::shared_ptr<Context> context, std::shared_ptr<Context> tailCallContext, const AssignmentList &definition_arguments);
+	void prepareTailCallContext(const std::shared_ptr<Context> context, std::shared_ptr<Context> tailCallContext, const AssignmentList &definition_arguments) const;
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	void compile(class BytecodeCompiler &compiler, bool tail) const override;
+	bool foldConstants() override;
 	const std::string& get_name() const { return name; }
 	static Expression * create(const std::string &funcname, const AssignmentList &arglist, Expression *expr, const Location &loc);
 	shared_ptr<class FunctionDefinition> getFunctionDefinition(const ValuePtr& v) const;
@@ -165,8 +194,9 @@ public:
 	std::string name;
 	shared_ptr<Expression> expr;
 	AssignmentList arguments;
-	AssignmentMap resolvedArguments;
-	std::vector<std::pair<std::string, ValuePtr>> defaultArguments; // Only the ones not mentioned in 'resolvedArguments'
+	mutable AssignmentMap resolvedArguments;
+	mutable std::vector<std::pair<VariableSlot, const Expression *>> resolvedSlots; // 'resolvedArguments' with their slots resolved
+	mutable std::vector<std::pair<VariableSlot, ValuePtr>> defaultArguments; // Only the ones not mentioned in 'resolvedArguments'
 };
 
 class FunctionDefinition : public Expression
@@ -175,6 +205,7 @@ public:
 	FunctionDefinition(Expression *expr, const AssignmentList &definition_arguments, const Location &loc);
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	bool foldConstants() override;
 public:
 	shared_ptr<Context> ctx;
 	AssignmentList definition_arguments;
@@ -188,6 +219,8 @@ public:
 	const shared_ptr<Expression>& evaluateStep(const std::shared_ptr<Context>& context) const;
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	void compile(class BytecodeCompiler &compiler, bool tail) const override;
+	bool foldConstants() override;
 private:
 	AssignmentList arguments;
 	shared_ptr<Expression> expr;
@@ -200,6 +233,8 @@ public:
 	const shared_ptr<Expression>& evaluateStep(const std::shared_ptr<Context>& context) const;
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	void compile(class BytecodeCompiler &compiler, bool tail) const override;
+	bool foldConstants() override;
 private:
 	AssignmentList arguments;
 	shared_ptr<Expression> expr;
@@ -212,6 +247,8 @@ public:
 	const shared_ptr<Expression>& evaluateStep(const std::shared_ptr<Context>& context) const;
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	void compile(class BytecodeCompiler &compiler, bool tail) const override;
+	bool foldConstants() override;
 private:
 	AssignmentList arguments;
 	shared_ptr<Expression> expr;
@@ -222,6 +259,9 @@ class ListComprehension : public Expression
 public:
 	ListComprehension(const Location &loc);
 	~ListComprehension() = default;
+	void compile(class BytecodeCompiler &compiler, bool tail) const override;
+	// Lowers into bytecode which appends the elements to the current list
+	virtual void compileElements(BytecodeCompiler &compiler) const;
 };
 
 class LcIf : public ListComprehension
@@ -230,6 +270,8 @@ public:
 	LcIf(Expression *cond, Expression *ifexpr, Expression *elseexpr, const Location &loc);
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	void compileElements(class BytecodeCompiler &compiler) const override;
+	bool foldConstants() override;
 private:
 	shared_ptr<Expression> cond;
 	shared_ptr<Expression> ifexpr;
@@ -242,6 +284,8 @@ public:
 	LcFor(const AssignmentList &args, Expression *expr, const Location &loc);
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	void compileElements(class BytecodeCompiler &compiler) const override;
+	bool foldConstants() override;
 private:
 	AssignmentList arguments;
 	shared_ptr<Expression> expr;
@@ -253,6 +297,7 @@ public:
 	LcForC(const AssignmentList &args, const AssignmentList &incrargs, Expression *cond, Expression *expr, const Location &loc);
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	bool foldConstants() override;
 private:
 	AssignmentList arguments;
 	AssignmentList incr_arguments;
@@ -266,6 +311,8 @@ public:
 	LcEach(Expression *expr, const Location &loc);
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	void compileElements(class BytecodeCompiler &compiler) const override;
+	bool foldConstants() override;
 private:
 	shared_ptr<Expression> expr;
 };
@@ -276,6 +323,8 @@ public:
 	LcLet(const AssignmentList &args, Expression *expr, const Location &loc);
 	ValuePtr evaluate(const std::shared_ptr<Context>& context) const override;
 	void print(std::ostream &stream, const std::string &indent) const override;
+	void compileElements(class BytecodeCompiler &compiler) const override;
+	bool foldConstants() override;
 private:
 	AssignmentList arguments;
 	shared_ptr<Expression> expr;
@@ -287,3 +336,8 @@ ValuePtr evaluate_function(const std::string& name,
 		const std::shared_ptr<Expression>& expr, const AssignmentList &definition_arguments,
 		const std::shared_ptr<Context>& ctx, const std::shared_ptr<EvalContext>& evalctx,
 		const Location& loc);
+
+// Evaluates the body of a function, with the arguments of the call set in c_next
+ValuePtr evaluate_function_body(const std::string& name,
+		const std::shared_ptr<Expression>& expr, const AssignmentList &definition_arguments,
+		const std::shared_ptr<Context>& c_next, const Location& loc);
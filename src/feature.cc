@@ -24,6 +24,12 @@ Feature::list_t Feature::feature_list;
 const Feature Feature::ExperimentalInputDriverDBus("input-driver-dbus", "Enable DBus input drivers (requires restart)");
 const Feature Feature::ExperimentalFunctionLiterals("function-literals", "Enable support for function literals");
 const Feature Feature::ExperimentalLazyUnion("lazy-union", "Enable lazy unions.");
+const Feature Feature::ExperimentalDisjointUnion("disjoint-union", "Enable union of non-overlapping objects without CGAL.");
+const Feature Feature::ExperimentalCorefinement("corefinement", "Use mesh corefinement instead of Nef polyhedra for 3D booleans.");
+const Feature Feature::ExperimentalParallelEvaluation("parallel-evaluation", "Evaluate independent subtrees in parallel, using the configured number of worker threads.");
+const Feature Feature::ExperimentalSimplifyTree("simplify-tree", "Simplify the node tree before evaluating it, e.g. by folding transformations and flattening nested unions.");
+const Feature Feature::ExperimentalBytecode("bytecode", "Compile user functions into bytecode instead of evaluating their expression trees.");
+const Feature Feature::ExperimentalFunctionCache("function-cache", "Cache results of user functions which don't depend on special variables, rands() or printed messages.");
 const Feature Feature::ExperimentalMouseSelection("mouse-selection", "Enable mouse selector");
 
 Feature::Feature(const std::string &name, const std::string &description)
@@ -17,6 +17,12 @@ public:
 	static const Feature ExperimentalInputDriverDBus;
 	static const Feature ExperimentalFunctionLiterals;
 	static const Feature ExperimentalLazyUnion;
+	static const Feature ExperimentalDisjointUnion;
+	static const Feature ExperimentalCorefinement;
+	static const Feature ExperimentalParallelEvaluation;
+	static const Feature ExperimentalSimplifyTree;
+	static const Feature ExperimentalBytecode;
+	static const Feature ExperimentalFunctionCache;
 	static const Feature ExperimentalMouseSelection;
 
 	const std::string& get_name() const;
@@ -33,6 +33,7 @@
 #include "exceptions.h"
 #include "memory.h"
 #include "UserModule.h"
+#include "FunctionCache.h"
 #include "degree_trig.h"
 
 #include <cmath>
@@ -101,6 +102,8 @@ ValuePtr builtin_sign(const std::shared_ptr<Context> ctx, const std::shared_ptr<
 
 ValuePtr builtin_rands(const std::shared_ptr<Context> ctx, const std::shared_ptr<EvalContext> evalctx)
 {
+	// Random numbers differ between calls of the calling function
+	FunctionCache::markImpure();
 	size_t n = evalctx->numArgs();
 	if (n == 3 || n == 4) {
 		ValuePtr v0 = evalctx->getArgValue(0);
@@ -430,6 +433,7 @@ ValuePtr builtin_length(const std::shared_ptr<Context> ctx, const std::shared_pt
 {
 	if (evalctx->numArgs() == 1) {
 		ValuePtr v = evalctx->getArgValue(0);
+		if (const DenseVectorType *dense = v->toDense()) return ValuePtr(int(dense->size()));
 		if (v->type() == Value::ValueType::VECTOR) return ValuePtr(int(v->toVector().size()));
 		if (v->type() == Value::ValueType::STRING) {
 			//Unicode glyph count for the length -- rather than the string (num. of bytes) length.
@@ -824,6 +828,8 @@ ValuePtr builtin_parent_module(const std::shared_ptr<Context> ctx, const std::sh
 	int n;
 	double d;
 	int s = UserModule::stack_size();
+	// The module stack isn't part of the arguments of the calling function
+	FunctionCache::markImpure();
 	if (evalctx->numArgs() == 0)
 		d=1; // parent module
 	else if (evalctx->numArgs() == 1) {
@@ -850,6 +856,15 @@ ValuePtr builtin_norm(const std::shared_ptr<Context> ctx, const std::shared_ptr<
 {
 	if (evalctx->numArgs() == 1) {
 		 ValuePtr val = evalctx->getArgValue(0);
+		const DenseVectorType *dense = val->toDense();
+		if (dense && dense->columns() == 0) {
+			double sum = 0;
+			for (size_t i = 0; i < dense->size(); i++) {
+				double x = dense->data()[i];
+				sum += x*x;
+			}
+			return ValuePtr(sqrt(sum));
+		}
 		if (val->type() == Value::ValueType::VECTOR) {
 			double sum = 0;
 			const Value::VectorType &v = val->toVector();
@@ -886,6 +901,24 @@ ValuePtr builtin_cross(const std::shared_ptr<Context> ctx, const std::shared_ptr
 		return ValuePtr::undefined;
 	}
 	
+	// Vectors of finite numbers are read without boxing them, the others
+	// are checked below
+	const DenseVectorType *dense0 = arg0->toDense();
+	const DenseVectorType *dense1 = arg1->toDense();
+	if (dense0 && dense1 && dense0->columns() == 0 && dense1->columns() == 0 &&
+			dense0->size() == 3 && dense1->size() == 3) {
+		const double *d0 = dense0->data();
+		const double *d1 = dense1->data();
+		if (std::all_of(d0, d0 + 3, [](double d) { return std::isfinite(d); }) &&
+				std::all_of(d1, d1 + 3, [](double d) { return std::isfinite(d); })) {
+			return ValuePtr(DenseVectorType({
+				d0[1] * d1[2] - d0[2] * d1[1],
+				d0[2] * d1[0] - d0[0] * d1[2],
+				d0[0] * d1[1] - d0[1] * d1[0]
+			}));
+		}
+	}
+
 	const Value::VectorType &v0 = arg0->toVector();
 	const Value::VectorType &v1 = arg1->toVector();
 	if ((v0.size() == 2) && (v1.size() == 2)) {
@@ -28,6 +28,8 @@
 #include "evalcontext.h"
 #include "expression.h"
 #include "printutils.h"
+#include "bytecode.h"
+#include "FunctionCache.h"
 
 AbstractFunction::~AbstractFunction()
 {
@@ -44,7 +46,22 @@ UserFunction::~UserFunction()
 
 ValuePtr UserFunction::evaluate(const std::shared_ptr<Context>& ctx, const std::shared_ptr<EvalContext>& evalctx) const
 {
-	return evaluate_function(name, expr, definition_arguments, ctx, evalctx, loc);
+	if (!expr) return ValuePtr::undefined;
+	ContextHandle<Context> c_next{Context::create<Context>(ctx)}; // Context for next tail call
+	c_next->setVariables(evalctx, definition_arguments);
+	if (Feature::ExperimentalFunctionCache.is_enabled()) {
+		return FunctionCache::instance()->evaluate(*this, c_next.ctx);
+	}
+	return evaluateBody(c_next.ctx);
+}
+
+ValuePtr UserFunction::evaluateBody(const std::shared_ptr<Context> &c_next) const
+{
+	if (Feature::ExperimentalBytecode.is_enabled()) {
+		if (!bytecode) bytecode = Bytecode::compile(*this);
+		return bytecode->call(c_next);
+	}
+	return evaluate_function_body(name, expr, definition_arguments, c_next, loc);
 }
 
 void UserFunction::print(std::ostream &stream, const std::string &indent) const
@@ -42,10 +42,14 @@ public:
 	AssignmentList definition_arguments;
 
 	shared_ptr<Expression> expr;
+	// Compiled on the first call, if the bytecode feature is enabled
+	mutable shared_ptr<const class Bytecode> bytecode;
 
 	UserFunction(const char *name, AssignmentList &definition_arguments, shared_ptr<Expression> expr, const Location &loc);
 	~UserFunction();
 
 	ValuePtr evaluate(const std::shared_ptr<Context>& ctx, const std::shared_ptr<EvalContext>& evalctx) const override;
+	// Evaluates the body with the arguments of the call set in c_next
+	ValuePtr evaluateBody(const std::shared_ptr<Context> &c_next) const;
 	void print(std::ostream &stream, const std::string &indent) const override;
 };
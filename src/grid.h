@@ -108,6 +108,11 @@ public:
 	T align(Vector3d &v) {
 		Vector3l key;
 		createGridVertex(v, key);
+		return align(v, key);
+	}
+
+	// As above, with the key already computed by createGridVertex() or VertexKernels::gridKeys()
+	T align(Vector3d &v, Vector3l key) {
 		typename GridContainer::iterator iter = db.find(key);
 		if (iter == db.end()) {
 			float dist = 10.0f; // > max possible distance
@@ -173,6 +173,8 @@ Geometry * import_3mf(const std::string &filename, const Location &loc)
 			p->append_vertex(vertex2.m_fPosition[0], vertex2.m_fPosition[1], vertex2.m_fPosition[2]);
 			p->append_vertex(vertex3.m_fPosition[0], vertex3.m_fPosition[1], vertex3.m_fPosition[2]);
 		}
+		// Triangles were added with their own copies of the shared vertices
+		p->mergeVertices();
 
 		if (first_mesh) {
 			meshes.push_back(std::shared_ptr<PolySet>(p));
@@ -141,6 +141,8 @@ void AmfImporter::start_object(AmfImporter *importer, const xmlChar *)
 void AmfImporter::end_object(AmfImporter *importer, const xmlChar *)
 {
 	PRINTDB("AMF: add object %d", importer->polySets.size());
+	// Triangles were added with their own copies of the shared vertices
+	importer->polySet->mergeVertices();
 	importer->polySets.push_back(importer->polySet);
 	importer->vertex_list.clear();
 	importer->polySet = nullptr;
@@ -140,5 +140,7 @@ PolySet *import_stl(const std::string &filename, const Location &loc)
 			p->append_vertex(facet.data.x3, facet.data.y3, facet.data.z3);
 		}
 	}
+	// STL stores the vertices of each facet separately
+	p->mergeVertices();
 	return p;
 }
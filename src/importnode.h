@@ -23,6 +23,7 @@ public:
 	ImportNode(const ModuleInstantiation *mi, const std::shared_ptr<EvalContext> &ctx, ImportType type) : LeafNode(mi, ctx), type(type) { }
 	std::string toString() const override;
 	std::string name() const override;
+	AbstractNode *clone() const override { return cloneAs(*this); }
 
 	ImportType type;
 	Filename filename;
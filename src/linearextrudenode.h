@@ -16,6 +16,7 @@ public:
 	}
 	std::string toString() const override;
 	std::string name() const override { return "linear_extrude"; }
+	AbstractNode *clone() const override { return cloneAs(*this); }
 
 	int convexity, slices;
 	double fn, fs, fa, height, twist;
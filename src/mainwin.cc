@@ -28,6 +28,7 @@
 #include "comment.h"
 #include "openscad.h"
 #include "GeometryCache.h"
+#include "FunctionCache.h"
 #include "ModuleCache.h"
 #include "MainWindow.h"
 #include "OpenSCADApp.h"
@@ -36,6 +37,7 @@
 #include "Preferences.h"
 #include "printutils.h"
 #include "node.h"
+#include "NodeSimplifier.h"
 #include "csgnode.h"
 #include "builtin.h"
 #include "memory.h"
@@ -55,7 +57,6 @@
 #endif
 #include "ProgressWidget.h"
 #include "ThrownTogetherRenderer.h"
-#include "CSGTreeNormalizer.h"
 #include "QGLView.h"
 #include "mouseselector.h"
 #ifdef Q_OS_MAC
@@ -110,11 +111,13 @@
 #ifdef ENABLE_CGAL
 
 #include "CGALCache.h"
+#include "DecompositionCache.h"
 #include "GeometryEvaluator.h"
 #include "CGALRenderer.h"
 #include "CGAL_Nef_polyhedron.h"
 #include "cgal.h"
 #include "cgalworker.h"
+#include "csgworker.h"
 #include "cgalutils.h"
 
 #endif // ENABLE_CGAL
@@ -198,6 +201,7 @@ MainWindow::MainWindow(const QStringList &filenames)
 	root_module = nullptr;
 	parsed_module = nullptr;
 	absolute_root_node = nullptr;
+	simplified_root_node = nullptr;
 
 	// Open Recent
 	for (int i = 0;i<UIUtils::maxRecentFiles; i++) {
@@ -232,6 +236,8 @@ MainWindow::MainWindow(const QStringList &filenames)
 	this->cgalworker = new CGALWorker();
 	connect(this->cgalworker, SIGNAL(done(shared_ptr<const Geometry>)),
 					this, SLOT(actionRenderDone(shared_ptr<const Geometry>)));
+	this->csgworker = new CSGWorker();
+	connect(this->csgworker, SIGNAL(done()), this, SLOT(compileCSGDone()));
 #endif
 
 #ifdef ENABLE_CGAL
@@ -721,10 +727,16 @@ void MainWindow::loadDesignSettings()
 	}
 	auto polySetCacheSizeMB = Preferences::inst()->getValue("advanced/polysetCacheSizeMB").toUInt();
 	GeometryCache::instance()->setMaxSizeMB(polySetCacheSizeMB);
+	auto evictionPolicy = Preferences::inst()->getValue("advanced/costAwareCacheEviction").toBool() ?
+		CacheEvictionPolicy::CostAware : CacheEvictionPolicy::LeastRecentlyUsed;
+	GeometryCache::instance()->setEvictionPolicy(evictionPolicy);
 #ifdef ENABLE_CGAL
 	auto cgalCacheSizeMB = Preferences::inst()->getValue("advanced/cgalCacheSizeMB").toUInt();
 	CGALCache::instance()->setMaxSizeMB(cgalCacheSizeMB);
+	CGALCache::instance()->setEvictionPolicy(evictionPolicy);
+	DecompositionCache::instance()->setMaxSizeMB(cgalCacheSizeMB);
 #endif
+	RenderSettings::inst()->threads = Preferences::inst()->getValue("advanced/threads").toUInt();
 }
 
 void MainWindow::updateUndockMode(bool undockMode)
@@ -764,6 +776,9 @@ MainWindow::~MainWindow()
 	// so no need to delete it.
 	delete parsed_module;
 	delete root_node;
+	delete simplified_root_node;
+	// Renderers release their vertex buffers in the GL context
+	this->qglview->makeCurrent();
 #ifdef ENABLE_CGAL
 	this->root_geom.reset();
 	delete this->cgalRenderer;
@@ -1092,6 +1107,7 @@ void MainWindow::instantiateRoot()
 
   // Invalidate renderers before we kill the CSG tree
 	this->qglview->setRenderer(nullptr);
+	this->qglview->makeCurrent();
 #ifdef ENABLE_OPENCSG
 	delete this->opencsgRenderer;
 	this->opencsgRenderer = nullptr;
@@ -1109,9 +1125,13 @@ void MainWindow::instantiateRoot()
 
 	this->root_node = nullptr;
 	this->tree.setRoot(nullptr);
+	delete this->simplified_root_node;
+	this->simplified_root_node = nullptr;
+	this->simplified_tree.setRoot(nullptr);
 
 	boost::filesystem::path doc(activeEditor->filepath.toStdString());
 	this->tree.setDocumentPath(doc.remove_filename().string());
+	this->simplified_tree.setDocumentPath(doc.remove_filename().string());
 
 	if (this->root_module) {
 		// Evaluate CSG tree
@@ -1119,6 +1139,7 @@ void MainWindow::instantiateRoot()
 		this->processEvents();
 
 		AbstractNode::resetIndexCounter();
+		FunctionCache::instance()->clear();
 
 		// split these two lines - gcc 4.7 bug
 		auto mi = ModuleInstantiation( "group" );
@@ -1137,9 +1158,18 @@ void MainWindow::instantiateRoot()
 			if (nextLocation) {
 				PRINTB("WARNING: More than one Root Modifier (!) %s", nextLocation->toRelativeString(top_ctx->documentPath()));
 			}
-
 			// FIXME: Consider giving away ownership of root_node to the Tree, or use reference counted pointers
 			this->tree.setRoot(this->root_node);
+
+			// The tree view and CSG export show the design as written, so only a copy is simplified
+			if (Feature::ExperimentalSimplifyTree.is_enabled()) {
+				this->simplified_root_node = this->root_node->clone();
+				// The same tree is used for previews, so keep the colors
+				NodeSimplifier simplifier(true);
+				simplifier.simplify(*this->simplified_root_node);
+				PRINTDB("Node tree simplification removed %d nodes", simplifier.removedNodes());
+				this->simplified_tree.setRoot(this->simplified_root_node);
+			}
 		}
 	}
 
@@ -1155,99 +1185,42 @@ void MainWindow::instantiateRoot()
 }
 
 /*!
-	Generates CSG tree for OpenCSG evaluation.
-	Assumes that the design has been parsed and evaluated (this->root_node is set)
+	Generates CSG tree for OpenCSG evaluation in the background and calls
+	afterCSGSlot once done, see compileCSGDone(). Calls it right away if the
+	design didn't evaluate to anything (this->root_node isn't set).
 */
 void MainWindow::compileCSG()
 {
-	OpenSCAD::hardwarnings = Preferences::inst()->getValue("advanced/enableHardwarnings").toBool();
-	try{
-		assert(this->root_node);
-		PRINT("Compiling design (CSG Products generation)...");
-		this->processEvents();
+	if (!this->root_node) {
+		QMetaObject::invokeMethod(this, this->afterCSGSlot);
+		return;
+	}
 
-		// Main CSG evaluation
-		this->progresswidget = new ProgressWidget(this);
-		connect(this->progresswidget, SIGNAL(requestShow()), this, SLOT(showProgress()));
+	OpenSCAD::hardwarnings = Preferences::inst()->getValue("advanced/enableHardwarnings").toBool();
+	PRINT("Compiling design (CSG Products generation)...");
+	this->processEvents();
 
-#ifdef ENABLE_CGAL
-			GeometryEvaluator geomevaluator(this->tree);
-#else
-			// FIXME: Will we support this?
-#endif
-#ifdef ENABLE_OPENCSG
-			CSGTreeEvaluator csgrenderer(this->tree, &geomevaluator);
-#endif
+	// Main CSG evaluation
+	this->progresswidget = new ProgressWidget(this);
+	connect(this->progresswidget, SIGNAL(requestShow()), this, SLOT(showProgress()));
 
-		progress_report_prep(this->root_node, report_func, this);
-		try {
-#ifdef ENABLE_OPENCSG
-			this->processEvents();
-			this->csgRoot = csgrenderer.buildCSGTree(*root_node);
-#endif
-			RenderStatistic::printCacheStatistic();
-			this->processEvents();
-		}
-		catch (const ProgressCancelException &) {
-			PRINT("CSG generation cancelled.");
-		}catch(const HardWarningException &){
-			PRINT("CSG generation cancelled due to hardwarning being enabled.");
-		}
-		progress_report_fin();
-		updateStatusBar(nullptr);
+	progress_report_prep(evaluatedRoot(), report_func, this);
 
-		PRINT("Compiling design (CSG Products normalization)...");
-		this->processEvents();
+	size_t normalizelimit = 2 * Preferences::inst()->getValue("advanced/openCSGLimit").toUInt();
+	this->csgworker->start(evaluatedTree(), normalizelimit);
+}
 
-		size_t normalizelimit = 2 * Preferences::inst()->getValue("advanced/openCSGLimit").toUInt();
-		CSGTreeNormalizer normalizer(normalizelimit);
-	
-		if (this->csgRoot) {
-			this->normalizedRoot = normalizer.normalize(this->csgRoot);
-			if (this->normalizedRoot) {
-				this->root_products.reset(new CSGProducts());
-				this->root_products->import(this->normalizedRoot);
-			}
-			else {
-				this->root_products.reset();
-				PRINT("WARNING: CSG normalization resulted in an empty tree");
-				this->processEvents();
-			}
-		}
+void MainWindow::compileCSGDone()
+{
+	progress_report_fin();
+	updateStatusBar(nullptr);
 
-		const std::vector<shared_ptr<CSGNode> > &highlight_terms = csgrenderer.getHighlightNodes();
-		if (highlight_terms.size() > 0) {
-			PRINTB("Compiling highlights (%d CSG Trees)...", highlight_terms.size());
-			this->processEvents();
-		
-			this->highlights_products.reset(new CSGProducts());
-			for (unsigned int i = 0; i < highlight_terms.size(); i++) {
-				auto nterm = normalizer.normalize(highlight_terms[i]);
-				if (nterm) {
-					this->highlights_products->import(nterm);
-				}
-			}
-		}
-		else {
-			this->highlights_products.reset();
-		}
-	
-		const auto &background_terms = csgrenderer.getBackgroundNodes();
-		if (background_terms.size() > 0) {
-			PRINTB("Compiling background (%d CSG Trees)...", background_terms.size());
-			this->processEvents();
-		
-			this->background_products.reset(new CSGProducts());
-			for (unsigned int i = 0; i < background_terms.size(); i++) {
-				auto nterm = normalizer.normalize(background_terms[i]);
-				if (nterm) {
-					this->background_products->import(nterm);
-				}
-			}
-		}
-		else {
-			this->background_products.reset();
-		}
+	try{
+		this->csgRoot = std::move(this->csgworker->csgRoot);
+		this->normalizedRoot = std::move(this->csgworker->normalizedRoot);
+		this->root_products = std::move(this->csgworker->root_products);
+		this->highlights_products = std::move(this->csgworker->highlights_products);
+		this->background_products = std::move(this->csgworker->background_products);
 
 		if (this->root_products &&
 				(this->root_products->size() >
@@ -1274,7 +1247,9 @@ void MainWindow::compileCSG()
 		this->processEvents();
 	}catch(const HardWarningException&){
 		exceptionCleanup();
+		return;
 	}
+	QMetaObject::invokeMethod(this, this->afterCSGSlot);
 }
 
 void MainWindow::actionOpen()
@@ -1791,8 +1766,12 @@ void MainWindow::actionReloadRenderPreview()
 
 void MainWindow::csgReloadRender()
 {
-	if (this->root_node) compileCSG();
+	this->afterCSGSlot = "csgReloadRenderDone";
+	compileCSG();
+}
 
+void MainWindow::csgReloadRenderDone()
+{
 	// Go to non-CGAL view mode
 	if (viewActionThrownTogether->isChecked()) {
 		viewModeThrownTogether();
@@ -1834,8 +1813,12 @@ void MainWindow::actionRenderPreview(bool rebuildParameterWidget)
 
 void MainWindow::csgRender()
 {
-	if (this->root_node) compileCSG();
+	this->afterCSGSlot = "csgRenderDone";
+	compileCSG();
+}
 
+void MainWindow::csgRenderDone()
+{
 	// Go to non-CGAL view mode
 	if (viewActionThrownTogether->isChecked()) {
 		viewModeThrownTogether();
@@ -2048,6 +2031,7 @@ void MainWindow::cgalRender()
 	}
 
 	this->qglview->setRenderer(nullptr);
+	this->qglview->makeCurrent();
 	delete this->cgalRenderer;
 	this->cgalRenderer = nullptr;
 	this->root_geom.reset();
@@ -2057,9 +2041,9 @@ void MainWindow::cgalRender()
 	this->progresswidget = new ProgressWidget(this);
 	connect(this->progresswidget, SIGNAL(requestShow()), this, SLOT(showProgress()));
 
-	progress_report_prep(this->root_node, report_func, this);
+	progress_report_prep(evaluatedRoot(), report_func, this);
 
-	this->cgalworker->start(this->tree);
+	this->cgalworker->start(evaluatedTree());
 }
 
 void MainWindow::actionRenderDone(shared_ptr<const Geometry> root_geom)
@@ -2506,6 +2490,7 @@ void MainWindow::actionFlushCaches()
 	GeometryCache::instance()->clear();
 #ifdef ENABLE_CGAL
 	CGALCache::instance()->clear();
+	DecompositionCache::instance()->clear();
 #endif
 	dxf_dim_cache.clear();
 	dxf_cross_cache.clear();
@@ -73,11 +73,11 @@ void ModuleContext::initializeModule(const UserModule &module)
 	this->functions_p = &module.scope.functions;
 	this->modules_p = &module.scope.modules;
 	for (const auto &assignment : module.scope.assignments) {
-		if (assignment->expr->isLiteral() && this->variables.find(assignment->name) != this->variables.end()) {
+		if (assignment->expr->isLiteral() && this->variables.contains(assignment->slot)) {
 			std::string loc = assignment->location().toRelativeString(this->documentPath());
 			PRINTB("WARNING: Module %s: Parameter %s is overwritten with a literal, %s", module.name % assignment->name % loc);
 		}
-		this->set_variable(assignment->name, assignment->expr->evaluate(get_shared_ptr()));
+		this->set_variable(assignment->slot, assignment->expr->evaluate(get_shared_ptr()));
 	}
 
 // Experimental code. See issue #399
@@ -148,20 +148,21 @@ std::string ModuleContext::dump(const AbstractModule *mod, const ModuleInstantia
 		if (m) {
 			s << "  module args:";
 			for(const auto &arg : m->definition_arguments) {
-				s << boost::format("    %s = %s") % arg->name % variables[arg->name];
+				const auto value = variables.find(arg->slot);
+				s << boost::format("    %s = %s") % arg->name % (value ? *value : ValuePtr::undefined);
 			}
 		}
 	}
 	typedef std::pair<std::string, ValuePtr> ValueMapType;
 	s << "  vars:";
 	for(const auto &v : constants) {
-		s << boost::format("    %s = %s") % v.first % v.second;
+		s << boost::format("    %s = %s") % v.first.name() % v.second;
 	}
 	for(const auto &v : variables) {
-		s << boost::format("    %s = %s") % v.first % v.second;
+		s << boost::format("    %s = %s") % v.first.name() % v.second;
 	}
 	for(const auto &v : config_variables) {
-		s << boost::format("    %s = %s") % v.first % v.second;
+		s << boost::format("    %s = %s") % v.first.name() % v.second;
 	}
 	return s.str();
 }
@@ -227,6 +228,6 @@ void FileContext::initializeModule(const class FileModule &module)
 	this->functions_p = &module.scope.functions;
 	this->modules_p = &module.scope.modules;
 	for (const auto &assignment : module.scope.assignments) {
-		this->set_variable(assignment->name, assignment->expr->evaluate(get_shared_ptr()));
+		this->set_variable(assignment->slot, assignment->expr->evaluate(get_shared_ptr()));
 	}
 }
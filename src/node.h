@@ -3,6 +3,7 @@
 #include <vector>
 #include <string>
 #include <deque>
+#include <memory>
 #include "BaseVisitable.h"
 #include "AST.h"
 
@@ -38,6 +39,12 @@ public:
 	    overloaded to provide specialization for e.g. CSG nodes, primitive nodes etc.
 	    Used for human-readable output. */
 	virtual std::string name() const = 0;
+	/*!
+		Returns a copy of the subtree rooted at this node. Copies keep the
+		indices of their originals, so evaluating a copy reports progress and
+		hashes like evaluating the original would.
+	*/
+	virtual AbstractNode *clone() const = 0;
   /*! Should return a Geometry instance describing the node. Returns nullptr if smth.
 		goes wrong. This is only called by PolySetEvaluator, to make sure polysets
 		are inserted into the cache*/
@@ -65,6 +72,16 @@ public:
 	const Location location;
 
 	const AbstractNode *getNodeByID(int idx, std::deque<const AbstractNode *> &path) const;
+
+protected:
+	// Implements clone() for NodeType, the type of node
+	template <class NodeType> static AbstractNode *cloneAs(const NodeType &node)
+	{
+		std::unique_ptr<NodeType> copy(new NodeType(node));
+		copy->children.clear();
+		for (const auto child : node.children) copy->children.push_back(child->clone());
+		return copy.release();
+	}
 };
 
 class AbstractIntersectionNode : public AbstractNode
@@ -75,6 +92,7 @@ public:
 	~AbstractIntersectionNode() { };
 	std::string toString() const override;
 	std::string name() const override;
+	AbstractNode *clone() const override { return cloneAs(*this); }
 };
 
 class AbstractPolyNode : public AbstractNode
@@ -101,6 +119,7 @@ public:
 	ListNode(const class ModuleInstantiation *mi, const std::shared_ptr<EvalContext> &ctx) : AbstractNode(mi, ctx) { }
 	~ListNode() { }
 	std::string name() const override;
+	AbstractNode *clone() const override { return cloneAs(*this); }
 };
 
 /*!
@@ -114,6 +133,7 @@ public:
 	GroupNode(const class ModuleInstantiation *mi, const std::shared_ptr<EvalContext> &ctx) : AbstractNode(mi, ctx) { }
 	~GroupNode() { }
 	std::string name() const override;
+	AbstractNode *clone() const override { return cloneAs(*this); }
 };
 
 /*!
@@ -127,6 +147,7 @@ public:
 	RootNode(const class ModuleInstantiation *mi, const std::shared_ptr<EvalContext> &ctx) : GroupNode(mi, ctx) { }
 	~RootNode() { }
 	std::string name() const override;
+	AbstractNode *clone() const override { return cloneAs(*this); }
 };
 
 class LeafNode : public AbstractPolyNode
@@ -4,12 +4,15 @@
 #include <unordered_map>
 #include <assert.h>
 #include "node.h"
+#include "nodehash.h"
 #include "printutils.h"
 
 /*!
 	Caches string values per node based on the node.index().
 	The node index guaranteed to be unique per node tree since the index is reset
 	every time a new tree is generated.
+
+	For id strings, the NodeHash of each node is cached as well.
 */
 
 class NodeCache
@@ -46,16 +49,27 @@ public:
 #endif
     }
 
+    NodeHash hash(const AbstractNode &node) const {
+        // throws std::out_of_range on miss
+        return this->hashes.at(node.index());
+    }
+
+    void insertHash(const size_t nodeidx, const NodeHash &hash) {
+        this->hashes[nodeidx] = hash;
+    }
+
     void setRootString(const std::string &rootString) {
         this->rootString = rootString;
     }
 
     void clear() {
         this->cache.clear();
+        this->hashes.clear();
         this->rootString = "";
     }
 
 private:
     std::unordered_map<size_t, std::pair<long,long>> cache;
+    std::unordered_map<size_t, NodeHash> hashes;
     std::string rootString;
 };
@@ -59,6 +59,7 @@ void NodeDumper::initCache()
 	this->dumpstream.str("");
 	this->dumpstream.clear();
 	this->cache.clear();
+	this->hashFrames.clear();
 }
 
 void NodeDumper::finalizeCache()
@@ -71,6 +72,61 @@ bool NodeDumper::isCached(const AbstractNode &node) const
 	return this->cache.contains(node);
 }
 
+void NodeDumper::write(const std::string &str)
+{
+	this->dumpstream << str;
+	if (this->idString && !this->hashFrames.empty() && !str.empty()) {
+		this->hashFrames.back().text += str;
+		this->hashFrames.back().hasText = true;
+	}
+}
+
+static void flushText(std::string &data, std::string &text)
+{
+	if (text.empty()) return;
+	const uint64_t len = text.size();
+	data += 'T';
+	data.append(reinterpret_cast<const char *>(&len), sizeof(len));
+	data += text;
+	text.clear();
+}
+
+void NodeDumper::beginNode(const AbstractNode &node)
+{
+	this->cache.insertStart(node.index(), this->dumpstream.tellp());
+	if (this->idString) this->hashFrames.emplace_back();
+}
+
+/*!
+	Computes the hash of a node from its own text and its children's hashes,
+	which is equal for equal id strings without hashing the same text once per
+	ancestor. A node contributing no text of its own with a single non-empty
+	child (e.g. a group with one child) gets the hash of that child, in the
+	same way as it gets the same id string.
+*/
+void NodeDumper::endNode(const AbstractNode &node)
+{
+	this->cache.insertEnd(node.index(), this->dumpstream.tellp());
+	if (!this->idString) return;
+
+	HashFrame frame = std::move(this->hashFrames.back());
+	this->hashFrames.pop_back();
+	flushText(frame.data, frame.text);
+	NodeHash hash = (!frame.hasText && frame.numChildren == 1) ? frame.lastChild :
+		NodeHash::compute(frame.data.data(), frame.data.size());
+	this->cache.insertHash(node.index(), hash);
+
+	if (!this->hashFrames.empty() && (frame.hasText || frame.numChildren > 0)) {
+		auto &parent = this->hashFrames.back();
+		flushText(parent.data, parent.text);
+		parent.data += 'H';
+		parent.data.append(reinterpret_cast<const char *>(&hash.h1), sizeof(hash.h1));
+		parent.data.append(reinterpret_cast<const char *>(&hash.h2), sizeof(hash.h2));
+		parent.numChildren++;
+		parent.lastChild = hash;
+	}
+}
+
 Response NodeDumper::visit(State &state, const GroupNode &node)
 {
 	if (!this->idString) {
@@ -84,30 +140,30 @@ Response NodeDumper::visit(State &state, const GroupNode &node)
 		}
 
 		// ListNodes can pass down modifiers to children via state, so check both modinst and state
-		if (node.modinst->isBackground() || state.isBackground()) this->dumpstream << "%";
-		if (node.modinst->isHighlight() || state.isHighlight()) this->dumpstream << "#";
+		if (node.modinst->isBackground() || state.isBackground()) this->write("%");
+		if (node.modinst->isHighlight() || state.isHighlight()) this->write("#");
 
 // If IDPREFIX is set, we will output "/*id*/" in front of each node
 // which is useful for debugging.
 #ifdef IDPREFIX
-		if (this->idString) this->dumpstream << "\n";	
-		this->dumpstream << "/*" << node.index() << "*/";
+		if (this->idString) this->write("\n");
+		this->write(STR("/*" << node.index() << "*/"));
 #endif
 
 		// insert start index
-		this->cache.insertStart(node.index(), this->dumpstream.tellp());
+		this->beginNode(node);
 		
 		if(this->groupChecker.getChildCount(node.index()) > 1) {
-			this->dumpstream << node << "{";
+			this->write(STR(node << "{"));
 		}
 		this->currindent++;
 	} else if (state.isPostfix()) {
 		this->currindent--;
 		if (this->groupChecker.getChildCount(node.index()) > 1) {
-			this->dumpstream << "}";
+			this->write("}");
 		}
 		// insert end index
-		this->cache.insertEnd(node.index(), this->dumpstream.tellp());
+		this->endNode(node);
 
 		// For handling root modifier '!'
 		// Check if we are processing the root of the current Tree and finalize cache
@@ -134,28 +190,30 @@ Response NodeDumper::visit(State &state, const AbstractNode &node)
 		}
 
 		// ListNodes can pass down modifiers to children via state, so check both modinst and state
-		if (node.modinst->isBackground() || state.isBackground()) this->dumpstream << "%";
-		if (node.modinst->isHighlight() || state.isHighlight()) this->dumpstream << "#";
+		if (node.modinst->isBackground() || state.isBackground()) this->write("%");
+		if (node.modinst->isHighlight() || state.isHighlight()) this->write("#");
 
 // If IDPREFIX is set, we will output "/*id*/" in front of each node
 // which is useful for debugging.
 #ifdef IDPREFIX
-		if (this->idString) this->dumpstream << "\n";	
-		this->dumpstream << "/*" << node.index() << "*/";
+		if (this->idString) this->write("\n");
+		this->write(STR("/*" << node.index() << "*/"));
 #endif
 
 		// insert start index
-		this->cache.insertStart(node.index(), this->dumpstream.tellp());
+		this->beginNode(node);
 		
 		if (this->idString) {
 			
 			static const boost::regex re("[^\\s\\\"]+|\\\"(?:[^\\\"\\\\]|\\\\.)*\\\"");
 			const auto name = STR(node);
 			boost::sregex_token_iterator it(name.begin(), name.end(), re, 0);
-			std::copy(it, boost::sregex_token_iterator(), std::ostream_iterator<std::string>(this->dumpstream));
+			std::string tokens;
+			for (; it != boost::sregex_token_iterator(); ++it) tokens += *it;
+			this->write(tokens);
 		
 			if (node.getChildren().size() > 0) {
-				this->dumpstream << "{";
+				this->write("{");
 			}
 
 		} else {
@@ -177,9 +235,9 @@ Response NodeDumper::visit(State &state, const AbstractNode &node)
 		
 		if (this->idString) {
 			if (node.getChildren().size() > 0) {
-				this->dumpstream << "}";
+				this->write("}");
 			} else {
-				this->dumpstream << ";";
+				this->write(";");
 			}
 		} else {
 			if (node.getChildren().size() > 0) {
@@ -193,7 +251,7 @@ Response NodeDumper::visit(State &state, const AbstractNode &node)
 		}
 	
 		// insert end index
-		this->cache.insertEnd(node.index(), this->dumpstream.tellp());
+		this->endNode(node);
 
 		// For handling root modifier '!'
 		// Check if we are processing the root of the current Tree and finalize cache
@@ -218,9 +276,9 @@ Response NodeDumper::visit(State &state, const ListNode &node)
 		// pass modifiers down to children via state
 		if (node.modinst->isHighlight()) state.setHighlight(true);
 		if (node.modinst->isBackground()) state.setBackground(true);
-		this->cache.insertStart(node.index(), this->dumpstream.tellp());
+		this->beginNode(node);
 	} else if (state.isPostfix()) {
-		this->cache.insertEnd(node.index(), this->dumpstream.tellp());
+		this->endNode(node);
 		// For handling root modifier '!'
 		if (this->root == &node) {
 			this->finalizeCache();
@@ -239,9 +297,9 @@ Response NodeDumper::visit(State &state, const RootNode &node)
 
 	if (state.isPrefix()) {
 		this->initCache();
-		this->cache.insertStart(node.index(), this->dumpstream.tellp());
+		this->beginNode(node);
 	} else if (state.isPostfix()) {
-		this->cache.insertEnd(node.index(), this->dumpstream.tellp());
+		this->endNode(node);
 		this->finalizeCache();
 	}
 
@@ -3,6 +3,7 @@
 #include <string>
 #include <unordered_map>
 #include <list>
+#include <vector>
 #include "NodeVisitor.h"
 #include "node.h"
 #include "nodecache.h"
@@ -48,6 +49,9 @@ private:
     void initCache();
     void finalizeCache();
     bool isCached(const AbstractNode &node) const;
+    void write(const std::string &str);
+    void beginNode(const AbstractNode &node);
+    void endNode(const AbstractNode &node);
 
     NodeCache &cache;
     // Output Formatting options
@@ -59,6 +63,17 @@ private:
     GroupNodeChecker groupChecker;
     std::ostringstream dumpstream;
 
+    // Per open node when dumping id strings: the node's own text and the
+    // hashes of its non-empty children, in order, to compute its NodeHash from
+    struct HashFrame {
+        std::string data;
+        std::string text;
+        bool hasText = false;
+        int numChildren = 0;
+        NodeHash lastChild;
+    };
+    std::vector<HashFrame> hashFrames;
+
 };
 
 
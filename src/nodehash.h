@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+
+/*!
+	A 128-bit hash identifying the contents of a node subtree.
+
+	It is computed bottom-up by NodeDumper (see Tree::getHash()) from the
+	node's own id string text and the hashes of its children, so it stays the
+	same across recompilations as long as the subtree's id string does.
+*/
+struct NodeHash
+{
+	uint64_t h1, h2;
+
+	NodeHash() : h1(0), h2(0) { }
+	NodeHash(uint64_t h1, uint64_t h2) : h1(h1), h2(h2) { }
+
+	static NodeHash compute(const void *data, size_t len);
+
+	bool operator==(const NodeHash &other) const { return this->h1 == other.h1 && this->h2 == other.h2; }
+	bool operator!=(const NodeHash &other) const { return !(*this == other); }
+
+	std::string toString() const;
+};
+
+inline std::ostream &operator<<(std::ostream &stream, const NodeHash &hash)
+{
+	return stream << hash.toString();
+}
+
+namespace std {
+	template<> struct hash<NodeHash> {
+		size_t operator()(const NodeHash &h) const { return static_cast<size_t>(h.h1); }
+	};
+}
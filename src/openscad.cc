@@ -41,9 +41,11 @@
 #include "PlatformUtils.h"
 #include "LibraryInfo.h"
 #include "nodedumper.h"
+#include "NodeSimplifier.h"
 #include "stackcheck.h"
 #include "CocoaUtils.h"
 #include "FontCache.h"
+#include "FunctionCache.h"
 #include "OffscreenView.h"
 #include "GeometryEvaluator.h"
 #include "RenderStatistic.h"
@@ -56,6 +58,7 @@
 #ifdef ENABLE_CGAL
 #include "CGAL_Nef_polyhedron.h"
 #include "cgalutils.h"
+#include "DiskCache.h"
 #endif
 
 #include "csgnode.h"
@@ -93,6 +96,7 @@ using boost::is_any_of;
 std::string commandline_commands;
 static bool arg_info = false;
 static std::string arg_colorscheme;
+static std::string arg_summary_file;
 
 
 class Echostream : public std::ofstream
@@ -335,7 +339,7 @@ int cmdline(const char *deps_output_file, const std::string &filename, const std
 
 	FileModule *root_module;
 	ModuleInstantiation root_inst("group");
-	const AbstractNode *root_node;
+	AbstractNode *root_node;
 	AbstractNode *absolute_root_node;
 	shared_ptr<const Geometry> root_geom;
 	unique_ptr<OffscreenView> glview;
@@ -374,6 +378,7 @@ int cmdline(const char *deps_output_file, const std::string &filename, const std
 	top_ctx->setDocumentPath(fparent.string());
 
 	AbstractNode::resetIndexCounter();
+	FunctionCache::instance()->clear();
 	absolute_root_node = root_module->instantiate(top_ctx.ctx, &root_inst, nullptr);
 
 	// Do we have an explicit root node (! modifier)?
@@ -381,6 +386,14 @@ int cmdline(const char *deps_output_file, const std::string &filename, const std
 	if (!(root_node = find_root_tag(absolute_root_node, &nextLocation))) {
 		root_node = absolute_root_node;
 	}
+	// Exported trees show the design as written, so only simplify for evaluation
+	if (Feature::ExperimentalSimplifyTree.is_enabled() && curFormat != FileFormat::CSG && curFormat != FileFormat::AST &&
+			curFormat != FileFormat::TERM && curFormat != FileFormat::ECHO) {
+		// Colors are only used by previews
+		NodeSimplifier simplifier(preview);
+		simplifier.simplify(*root_node);
+		PRINTDB("Node tree simplification removed %d nodes", simplifier.removedNodes());
+	}
 	tree.setRoot(root_node);
 	if (nextLocation) {
 		PRINTB("WARNING: More than one Root Modifier (!) %s", nextLocation->toRelativeString(top_ctx->documentPath()));
@@ -472,11 +485,15 @@ int cmdline(const char *deps_output_file, const std::string &filename, const std
 		}
 
 		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(end-begin);
 		RenderStatistic::printCacheStatistic();
-		RenderStatistic::printRenderingTime( std::chrono::duration_cast<std::chrono::milliseconds>(end-begin) );
+		RenderStatistic::printRenderingTime(ms);
 		if (root_geom && !root_geom->isEmpty()) {
 			RenderStatistic().print(*root_geom);
 		}
+		if (!arg_summary_file.empty()) {
+			RenderStatistic::writeSummary(arg_summary_file, ms, root_geom, geomevaluator.getOperatorTimings());
+		}
 
 		if(curFormat == FileFormat::STL ||
 			curFormat == FileFormat::OFF ||
@@ -879,6 +896,10 @@ int main(int argc, char **argv)
 		("view", po::value<CommaSeparatedVector>(), ("=view options: " + boost::join(viewOptions.names(), " | ")).c_str())
 		("projection", po::value<string>(), "=(o)rtho or (p)erspective when exporting png")
 		("csglimit", po::value<unsigned int>(), "=n -stop rendering at n CSG elements when exporting png")
+		("threads", po::value<unsigned int>(), "=n -use n worker threads for CGAL operations, 0 uses all hardware threads")
+		("cache-dir", po::value<string>(), "=path -keep rendered geometry in path, shared between runs and processes")
+		("cache-dir-limit", po::value<unsigned int>(), "=n -limit the size of the cache directory to n MB (default 1024)")
+		("summary-file", po::value<string>(), "=file -write cache statistics, timings and result geometry statistics as JSON to file")
 		("colorscheme", po::value<string>(), ("=colorscheme: " +
 		                                      join(ColorMap::inst()->colorSchemeNames(), " | ",
 		                                           [](const std::string& colorScheme) {
@@ -976,6 +997,19 @@ int main(int argc, char **argv)
 		RenderSettings::inst()->openCSGTermLimit = vm["csglimit"].as<unsigned int>();
 	}
 
+	if (vm.count("threads")) {
+		RenderSettings::inst()->threads = vm["threads"].as<unsigned int>();
+	}
+
+#ifdef ENABLE_CGAL
+	if (vm.count("cache-dir-limit")) {
+		DiskCache::instance()->setMaxSizeMB(vm["cache-dir-limit"].as<unsigned int>());
+	}
+	if (vm.count("cache-dir")) {
+		DiskCache::instance()->setDirectory(vm["cache-dir"].as<string>());
+	}
+#endif
+
 	if (vm.count("o")) {
 		output_files = vm["o"].as<vector<string>>();
 	}
@@ -1033,6 +1067,10 @@ int main(int argc, char **argv)
 		arg_colorscheme = vm["colorscheme"].as<string>();
 	}
 
+	if (vm.count("summary-file")) {
+		arg_summary_file = vm["summary-file"].as<string>();
+	}
+
 	ExportFileFormatOptions exportFileFormatOptions;
 	if(vm.count("export-format")) {
 		auto tmp_format = vm["export-format"].as<string>();
@@ -41,6 +41,7 @@
 #include "ModuleInstantiation.h"
 #include "Assignment.h"
 #include "expression.h"
+#include "constantfolding.h"
 #include "value.h"
 #include "function.h"
 #include "printutils.h"
@@ -789,5 +790,6 @@ bool parse(FileModule *&module, const std::string& text, const std::string &file
   parser_input_buffer = nullptr;
   scope_stack.pop();
 
+  fold_constants(module->scope);
   return true;
 }
@@ -17,7 +17,7 @@ namespace PolysetUtils {
 	Polygon2d *project(const PolySet &ps) {
 		auto poly = new Polygon2d;
 
-		for (const auto &p : ps.polygons) {
+		for (const auto &p : ps.polygons()) {
 			Outline2d outline;
 			for (const auto &v : p) {
 				outline.vertices.emplace_back(v[0], v[1]);
@@ -55,7 +55,7 @@ namespace PolysetUtils {
 		Reindexer<Vector3f> allVertices;
 		std::vector<std::vector<IndexedFace>> polygons;
 
-		for (const auto &pgon : inps.polygons) {
+		for (const auto &pgon : inps.polygons()) {
 			if (pgon.size() < 3) {
 				degeneratePolygons++;
 				continue;
@@ -79,6 +79,8 @@ namespace PolysetUtils {
 
 		// Tessellate indexed mesh
 		const auto& verts = allVertices.getArray();
+		// Index of each vertex in outps, once used
+		std::vector<int> outIndices(verts.size(), -1);
 		std::vector<IndexedTriangle> allTriangles;
 		for (const auto &faces : polygons) {
 			std::vector<IndexedTriangle> triangles;
@@ -92,9 +94,11 @@ namespace PolysetUtils {
 			if (!err) {
 				for (const auto &t : triangles) {
 					outps.append_poly();
-					outps.append_vertex(verts[t[0]]);
-					outps.append_vertex(verts[t[1]]);
-					outps.append_vertex(verts[t[2]]);
+					for (int i = 0; i < 3; i++) {
+						int &index = outIndices[t[i]];
+						if (index < 0) index = outps.add_vertex(verts[t[i]].cast<double>());
+						outps.append_index(index);
+					}
 				}
 			}
 		}
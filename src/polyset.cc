@@ -29,6 +29,8 @@
 #include "linalg.h"
 #include "printutils.h"
 #include "grid.h"
+#include "Reindexer.h"
+#include "vertex-kernels.h"
 #include <Eigen/LU>
 
 /*! /class PolySet
@@ -45,11 +47,11 @@
 
  */
 
-PolySet::PolySet(unsigned int dim, boost::tribool convex) : dim(dim), convex(convex), dirty(false)
+PolySet::PolySet(unsigned int dim, boost::tribool convex) : offsets(1, 0), dim(dim), convex(convex), dirty(false)
 {
 }
 
-PolySet::PolySet(const Polygon2d &origin) : polygon(origin), dim(2), convex(unknown), dirty(false)
+PolySet::PolySet(const Polygon2d &origin) : offsets(1, 0), polygon(origin), dim(2), convex(unknown), dirty(false)
 {
 }
 
@@ -63,14 +65,12 @@ std::string PolySet::dump() const
 	out << "PolySet:"
 	  << "\n dimensions:" << this->dim
 	  << "\n convexity:" << this->convexity
-	  << "\n num polygons: " << polygons.size()
+	  << "\n num polygons: " << numFacets()
 			<< "\n num outlines: " << polygon.outlines().size()
 	  << "\n polygons data:";
-	for (size_t i = 0; i < polygons.size(); i++) {
+	for (const auto &poly : polygons()) {
 		out << "\n  polygon begin:";
-		const Polygon *poly = &polygons[i];
-		for (size_t j = 0; j < poly->size(); j++) {
-			Vector3d v = poly->at(j);
+		for (const auto &v : poly) {
 			out << "\n   vertex:" << v.transpose();
 		}
 	}
@@ -80,15 +80,22 @@ std::string PolySet::dump() const
 	return out.str();
 }
 
+void PolySet::reserve(size_t numVertices, size_t numIndices, size_t numPolygons)
+{
+	this->vertices.reserve(numVertices);
+	this->indices.reserve(numIndices);
+	this->offsets.reserve(numPolygons + 1);
+}
+
 void PolySet::append_poly()
 {
-	polygons.push_back(Polygon());
+	this->offsets.push_back(this->indices.size());
 }
 
 void PolySet::append_poly(const Polygon &poly)
 {
-	polygons.push_back(poly);
-	this->dirty = true;
+	append_poly();
+	for (const auto &v : poly) append_vertex(v);
 }
 
 void PolySet::append_vertex(double x, double y, double z)
@@ -98,8 +105,7 @@ void PolySet::append_vertex(double x, double y, double z)
 
 void PolySet::append_vertex(const Vector3d &v)
 {
-	polygons.back().push_back(v);
-	this->dirty = true;
+	append_index(add_vertex(v));
 }
 
 void PolySet::append_vertex(const Vector3f &v)
@@ -114,8 +120,9 @@ void PolySet::insert_vertex(double x, double y, double z)
 
 void PolySet::insert_vertex(const Vector3d &v)
 {
-	polygons.back().insert(polygons.back().begin(), v);
-	this->dirty = true;
+	const int index = add_vertex(v);
+	this->indices.insert(this->indices.begin() + this->offsets[numFacets() - 1], index);
+	this->offsets.back()++;
 }
 
 void PolySet::insert_vertex(const Vector3f &v)
@@ -123,14 +130,25 @@ void PolySet::insert_vertex(const Vector3f &v)
 	insert_vertex((const Vector3d &)v.cast<double>());
 }
 
+int PolySet::add_vertex(const Vector3d &v)
+{
+	this->vertices.push_back(v);
+	this->dirty = true;
+	return this->vertices.size() - 1;
+}
+
+void PolySet::append_index(int index)
+{
+	this->indices.push_back(index);
+	this->offsets.back()++;
+}
+
 BoundingBox PolySet::getBoundingBox() const
 {
 	if (this->dirty) {
 		this->bbox.setNull();
-		for(const auto &poly : polygons) {
-			for(const auto &p : poly) {
-				this->bbox.extend(p);
-			}
+		for (const auto &v : this->vertices) {
+			this->bbox.extend(v);
 		}
 		this->dirty = false;
 	}
@@ -140,7 +158,8 @@ BoundingBox PolySet::getBoundingBox() const
 size_t PolySet::memsize() const
 {
 	size_t mem = 0;
-	for(const auto &p : this->polygons) mem += p.size() * sizeof(Vector3d);
+	mem += this->vertices.size() * sizeof(Vector3d);
+	mem += (this->indices.size() + this->offsets.size()) * sizeof(int);
 	mem += this->polygon.memsize() - sizeof(this->polygon);
 	mem += sizeof(PolySet);
 	return mem;
@@ -148,7 +167,13 @@ size_t PolySet::memsize() const
 
 void PolySet::append(const PolySet &ps)
 {
-	this->polygons.insert(this->polygons.end(), ps.polygons.begin(), ps.polygons.end());
+	const int firstVertex = this->vertices.size();
+	const int firstIndex = this->indices.size();
+	this->vertices.insert(this->vertices.end(), ps.vertices.begin(), ps.vertices.end());
+	this->indices.reserve(this->indices.size() + ps.indices.size());
+	for (const auto index : ps.indices) this->indices.push_back(firstVertex + index);
+	this->offsets.reserve(this->offsets.size() + ps.numFacets());
+	for (size_t i = 1; i < ps.offsets.size(); i++) this->offsets.push_back(firstIndex + ps.offsets[i]);
 	if (!dirty && !this->bbox.isNull()) {
 		this->bbox.extend(ps.getBoundingBox());
 	}
@@ -156,16 +181,18 @@ void PolySet::append(const PolySet &ps)
 
 void PolySet::transform(const Transform3d &mat)
 {
+	// Shared vertices are only transformed once
+	VertexKernels::transform(this->vertices.data(), this->vertices.size(), mat);
 	// If mirroring transform, flip faces to avoid the object to end up being inside-out
-	bool mirrored = mat.matrix().determinant() < 0;
+	if (mat.matrix().determinant() < 0) flipPolygons();
+	this->dirty = true;
+}
 
-	for(auto &p : this->polygons){
-		for(auto &v : p) {
-			v = mat * v;
-		}
-		if (mirrored) std::reverse(p.begin(), p.end());
+void PolySet::flipPolygons()
+{
+	for (size_t i = 0; i < numFacets(); i++) {
+		std::reverse(this->indices.begin() + this->offsets[i], this->indices.begin() + this->offsets[i + 1]);
 	}
-	this->dirty = true;
 }
 
 bool PolySet::is_convex() const {
@@ -208,28 +235,59 @@ void PolySet::resize(const Vector3d &newsize, const Eigen::Matrix<bool,3,1> &aut
 */
 void PolySet::quantizeVertices()
 {
+	// Merged vertices share an index, so each vertex only needs to be aligned once
 	Grid3d<int> grid(GRID_FINE);
-	std::vector<int> indices; // Vertex indices in one polygon
-	for (std::vector<Polygon>::iterator iter = this->polygons.begin(); iter != this->polygons.end();) {
-		Polygon &p = *iter;
-		indices.resize(p.size());
-		// Quantize all vertices. Build index list
-		for (unsigned int i=0;i<p.size();i++) indices[i] = grid.align(p[i]);
-		// Remove consecutive duplicate vertices
-		Polygon::iterator currp = p.begin();
-		for (unsigned int i=0;i<indices.size();i++) {
-			if (indices[i] != indices[(i+1)%indices.size()]) {
-				(*currp++) = p[i];
-			}
+	std::vector<int> remap(this->vertices.size());
+	std::vector<Vector3l> keys(this->vertices.size());
+	VertexKernels::gridKeys(this->vertices.data(), this->vertices.size(), grid.res, keys.data());
+	for (size_t i = 0; i < this->vertices.size(); i++) {
+		Vector3d v = this->vertices[i];
+		const size_t known = grid.db.size();
+		remap[i] = grid.align(v, keys[i]);
+		// New grid vertices are numbered consecutively, so this never overwrites unread vertices
+		if (grid.db.size() > known) this->vertices[remap[i]] = v;
+	}
+	this->vertices.resize(grid.db.size());
+	this->dirty = true;
+
+	// Remove consecutive duplicate vertices and collapsed polygons
+	size_t curr = 0, first = 0;
+	size_t numPolygons = 0;
+	for (size_t i = 0; i < numFacets(); i++) {
+		const size_t begin = first, end = this->offsets[i + 1];
+		first = end;
+		const size_t start = curr;
+		// Compaction may overwrite indices[begin] before the last vertex wraps around to it
+		const int firstIndex = remap[this->indices[begin]];
+		for (size_t j = begin; j < end; j++) {
+			const int index = remap[this->indices[j]];
+			const int next = j + 1 < end ? remap[this->indices[j + 1]] : firstIndex;
+			if (index != next) this->indices[curr++] = index;
 		}
-		p.erase(currp, p.end());
-		if (p.size() < 3) {
+		if (curr - start < 3) {
 			PRINTD("Removing collapsed polygon due to quantizing");
-			this->polygons.erase(iter);
+			curr = start;
 		}
 		else {
-			iter++;
+			this->offsets[++numPolygons] = curr;
 		}
 	}
+	this->indices.resize(curr);
+	this->offsets.resize(numPolygons + 1);
 }
 
+/*!
+	Merges identical vertices, so every vertex is stored once. Used for
+	imported meshes where each polygon comes with its own copy of the
+	vertices.
+*/
+void PolySet::mergeVertices()
+{
+	Reindexer<Vector3d> merged;
+	std::vector<int> remap(this->vertices.size());
+	for (size_t i = 0; i < this->vertices.size(); i++) remap[i] = merged.lookup(this->vertices[i]);
+	for (auto &index : this->indices) index = remap[index];
+	std::vector<Vector3d>().swap(this->vertices);
+	this->vertices.reserve(merged.size());
+	merged.copy(std::back_inserter(this->vertices));
+}
@@ -8,6 +8,8 @@
 #include <vector>
 #include <string>
 
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/iterator/transform_iterator.hpp>
 #include <boost/logic/tribool.hpp>
 BOOST_TRIBOOL_THIRD_STATE(unknown)
 
@@ -15,7 +17,78 @@ class PolySet : public Geometry
 {
 public:
 	VISITABLE_GEOMETRY();
-	Polygons polygons;
+
+	/*!
+		One polygon of a PolySet: a read-only view of its vertices, which
+		behaves like a (const) Polygon. Only valid until the PolySet is
+		modified.
+	*/
+	class PolygonView
+	{
+		struct Lookup {
+			const Vector3d *vertices;
+			const Vector3d &operator()(int index) const { return vertices[index]; }
+		};
+	public:
+		typedef boost::transform_iterator<Lookup, std::vector<int>::const_iterator> const_iterator;
+		typedef const_iterator iterator;
+
+		PolygonView(const PolySet &ps, size_t first, size_t last) : vertices(ps.vertices.data()),
+			first(ps.indices.begin() + first), last(ps.indices.begin() + last) {}
+
+		size_t size() const { return this->last - this->first; }
+		bool empty() const { return this->first == this->last; }
+		const Vector3d &operator[](size_t i) const { return this->vertices[this->first[i]]; }
+		const Vector3d &at(size_t i) const { return (*this)[i]; }
+		const Vector3d &front() const { return (*this)[0]; }
+		const Vector3d &back() const { return (*this)[size() - 1]; }
+		const_iterator begin() const { return const_iterator(this->first, Lookup{this->vertices}); }
+		const_iterator end() const { return const_iterator(this->last, Lookup{this->vertices}); }
+		const_iterator cbegin() const { return begin(); }
+		const_iterator cend() const { return end(); }
+		// Index of the i'th vertex in the PolySet's vertex array
+		int index(size_t i) const { return this->first[i]; }
+
+		operator Polygon() const { return Polygon(begin(), end()); }
+
+	private:
+		const Vector3d *vertices;
+		std::vector<int>::const_iterator first, last;
+	};
+
+	/*!
+		All polygons of a PolySet, as a random access sequence of PolygonViews.
+	*/
+	class PolygonRange
+	{
+	public:
+		class const_iterator : public boost::iterator_facade<const_iterator, PolygonView, boost::random_access_traversal_tag, PolygonView>
+		{
+		public:
+			const_iterator(const PolySet &ps, size_t i) : ps(&ps), i(i) {}
+		private:
+			friend class boost::iterator_core_access;
+			PolygonView dereference() const { return PolygonView(*this->ps, this->ps->offsets[this->i], this->ps->offsets[this->i + 1]); }
+			bool equal(const const_iterator &other) const { return this->i == other.i; }
+			void increment() { this->i++; }
+			void decrement() { this->i--; }
+			void advance(ptrdiff_t n) { this->i += n; }
+			ptrdiff_t distance_to(const const_iterator &other) const { return other.i - this->i; }
+			const PolySet *ps;
+			size_t i;
+		};
+		typedef const_iterator iterator;
+
+		PolygonRange(const PolySet &ps) : ps(ps) {}
+		size_t size() const { return this->ps.numFacets(); }
+		bool empty() const { return size() == 0; }
+		PolygonView operator[](size_t i) const { return PolygonView(this->ps, this->ps.offsets[i], this->ps.offsets[i + 1]); }
+		const_iterator begin() const { return const_iterator(this->ps, 0); }
+		const_iterator end() const { return const_iterator(this->ps, size()); }
+
+	private:
+		const PolySet &ps;
+	};
 
 	PolySet(unsigned int dim, boost::tribool convex = unknown);
 	PolySet(const Polygon2d &origin);
@@ -27,11 +100,25 @@ public:
 	BoundingBox getBoundingBox() const override;
 	std::string dump() const override;
 	unsigned int getDimension() const override { return this->dim; }
-	bool isEmpty() const override { return polygons.size() == 0; }
+	bool isEmpty() const override { return numFacets() == 0; }
 	Geometry *copy() const override { return new PolySet(*this); }
 
 	void quantizeVertices();
-	size_t numFacets() const override { return polygons.size(); }
+	void mergeVertices();
+	size_t numFacets() const override { return this->offsets.size() - 1; }
+
+	PolygonRange polygons() const { return PolygonRange(*this); }
+	/*!
+		The indexed storage: all vertices, and the vertex indices of all
+		polygons, one after another. Polygon i uses the indices in the range
+		[getOffsets()[i], getOffsets()[i+1]). Vertices may be shared by
+		polygons, but identical vertices aren't necessarily merged.
+	*/
+	const std::vector<Vector3d> &getVertices() const { return this->vertices; }
+	const std::vector<int> &getIndices() const { return this->indices; }
+	const std::vector<int> &getOffsets() const { return this->offsets; }
+
+	void reserve(size_t numVertices, size_t numIndices, size_t numPolygons);
 	void append_poly();
 	void append_poly(const Polygon &poly);
 	void append_vertex(double x, double y, double z = 0.0);
@@ -40,15 +127,26 @@ public:
 	void insert_vertex(double x, double y, double z = 0.0);
 	void insert_vertex(const Vector3d &v);
 	void insert_vertex(const Vector3f &v);
+	// Adds a vertex without using it, returning its index for append_index()
+	int add_vertex(const Vector3d &v);
+	// Appends an existing vertex to the last polygon
+	void append_index(int index);
 	void append(const PolySet &ps);
 
 	void transform(const Transform3d &mat);
 	void resize(const Vector3d &newsize, const Eigen::Matrix<bool,3,1> &autosize);
+	// Reverses the vertex order of all polygons
+	void flipPolygons();
 
 	bool is_convex() const;
 	boost::tribool convexValue() const { return this->convex; }
 
 private:
+	std::vector<Vector3d> vertices;
+	std::vector<int> indices;
+	// Start of each polygon in indices, followed by the end of the last one
+	std::vector<int> offsets;
+
 	Polygon2d polygon;
 	unsigned int dim;
 	mutable boost::tribool convex;
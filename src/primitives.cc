@@ -35,6 +35,7 @@
 #include "calc.h"
 #include "degree_trig.h"
 #include <sstream>
+#include <algorithm>
 #include <assert.h>
 #include <cmath>
 #include <boost/assign/std/vector.hpp>
@@ -69,6 +70,7 @@ public:
 	VISITABLE();
 	PrimitiveNode(const ModuleInstantiation *mi, const std::shared_ptr<EvalContext> &ctx, primitive_type_e type, const std::string &docPath) : LeafNode(mi, ctx), document_path(docPath), type(type) { }
 	std::string toString() const override;
+	AbstractNode *clone() const override { return cloneAs(*this); }
 	std::string name() const override {
 		switch (this->type) {
 		case primitive_type_e::CUBE:
@@ -344,6 +346,21 @@ struct point2d {
 	double x, y;
 };
 
+/*!
+	Calls f with each element of a vector as a double, reading dense
+	vectors without boxing their elements.
+*/
+template <typename F>
+static void for_each_double(const Value &vec, F f)
+{
+	const DenseVectorType *dense = vec.toDense();
+	if (dense && dense->columns() == 0) {
+		std::for_each(dense->data(), dense->data() + dense->size(), f);
+		return;
+	}
+	for (const auto &v : vec.toVector()) f(v->toDouble());
+}
+
 static void generate_circle(point2d *circle, double r, int fragments)
 {
 	for (int i=0; i<fragments; i++) {
@@ -551,21 +568,43 @@ const Geometry *PrimitiveNode::createGeometry() const
 		auto p = new PolySet(3);
 		g = p;
 		p->setConvexity(this->convexity);
-		for (size_t i=0; i<this->faces->toVector().size(); i++)	{
+		// Points are converted once and shared by all faces using them.
+		// Dense points and faces are read without boxing them.
+		const DenseVectorType *densePoints = this->points->toDense();
+		const DenseVectorType *denseFaces = this->faces->toDense();
+		const size_t numPoints = densePoints ? densePoints->size() : this->points->toVector().size();
+		const size_t numFaces = denseFaces ? denseFaces->size() : this->faces->toVector().size();
+		auto getPoint = [&](size_t pt, double &px, double &py, double &pz) {
+			if (densePoints) return (*densePoints)[pt].getVec3(px, py, pz, 0.0);
+			return this->points->toVector()[pt]->getVec3(px, py, pz, 0.0);
+		};
+		std::vector<int> vertexIndices(numPoints, -1);
+		std::vector<int> face;
+		std::vector<size_t> vec;
+		for (size_t i=0; i<numFaces; i++)	{
 			p->append_poly();
-			const auto &vec = this->faces->toVector()[i]->toVector();
+			vec.clear();
+			auto addIndex = [&vec](double index) { vec.push_back((size_t)index); };
+			if (denseFaces) for_each_double((*denseFaces)[i], addIndex);
+			else for_each_double(*this->faces->toVector()[i], addIndex);
+			face.clear();
 			for (size_t j=0; j<vec.size(); j++) {
-				size_t pt = (size_t)vec[j]->toDouble();
-				if (pt < this->points->toVector().size()) {
-					double px, py, pz;
-					if (!this->points->toVector()[pt]->getVec3(px, py, pz, 0.0) ||
-					    !std::isfinite(px) || !std::isfinite(py) || !std::isfinite(pz)) {
-						PRINTB("ERROR: Unable to convert point at index %d to a vec3 of numbers, %s", j % this->modinst->location().toRelativeString(this->document_path));
-						return p;
+				size_t pt = vec[j];
+				if (pt < numPoints) {
+					if (vertexIndices[pt] < 0) {
+						double px, py, pz;
+						if (!getPoint(pt, px, py, pz) ||
+						    !std::isfinite(px) || !std::isfinite(py) || !std::isfinite(pz)) {
+							PRINTB("ERROR: Unable to convert point at index %d to a vec3 of numbers, %s", j % this->modinst->location().toRelativeString(this->document_path));
+							return p;
+						}
+						vertexIndices[pt] = p->add_vertex(Vector3d(px, py, pz));
 					}
-					p->insert_vertex(px, py, pz);
+					face.push_back(vertexIndices[pt]);
 				}
 			}
+			// The vertex order of faces is reversed in the PolySet
+			for (auto index = face.rbegin(); index != face.rend(); ++index) p->append_index(*index);
 		}
 	}
 		break;
@@ -611,15 +650,25 @@ const Geometry *PrimitiveNode::createGeometry() const
 
 			Outline2d outline;
 			double x,y;
-			const auto &vec = this->points->toVector();
-			for (unsigned int i=0;i<vec.size();i++) {
-				const auto &val = *vec[i];
-				if (!val.getVec2(x, y) || std::isinf(x) || std::isinf(y)) {
-					PRINTB("ERROR: Unable to convert point %s at index %d to a vec2 of numbers, %s",
-								 val.toEchoString() % i % this->modinst->location().toRelativeString(this->document_path));
-					return p;
+			const DenseVectorType *dense = this->points->toDense();
+			if (dense && dense->columns() == 2 &&
+					std::none_of(dense->data(), dense->data() + dense->dataSize(), [](double d) { return std::isinf(d); })) {
+				// Dense points are read without boxing them
+				for (size_t i=0;i<dense->size();i++) {
+					outline.vertices.emplace_back(dense->data()[2*i], dense->data()[2*i + 1]);
+				}
+			}
+			else {
+				const auto &vec = this->points->toVector();
+				for (unsigned int i=0;i<vec.size();i++) {
+					const auto &val = *vec[i];
+					if (!val.getVec2(x, y) || std::isinf(x) || std::isinf(y)) {
+						PRINTB("ERROR: Unable to convert point %s at index %d to a vec2 of numbers, %s",
+									 val.toEchoString() % i % this->modinst->location().toRelativeString(this->document_path));
+						return p;
+					}
+					outline.vertices.emplace_back(x, y);
 				}
-				outline.vertices.emplace_back(x, y);
 			}
 
 			if (this->paths->toVector().size() == 0 && outline.vertices.size() > 2) {
@@ -628,13 +677,13 @@ const Geometry *PrimitiveNode::createGeometry() const
 			else {
 				for (const auto &polygon : this->paths->toVector()) {
 					Outline2d curroutline;
-					for (const auto &index : polygon->toVector()) {
-						unsigned int idx = (unsigned int)index->toDouble();
+					for_each_double(*polygon, [&](double index) {
+						unsigned int idx = (unsigned int)index;
 						if (idx < outline.vertices.size()) {
 							curroutline.vertices.push_back(outline.vertices[idx]);
 						}
 						// FIXME: Warning on out of bounds?
-					}
+					});
 					p->addOutline(curroutline);
 				}
 			}
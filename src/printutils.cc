@@ -23,6 +23,18 @@ boost::circular_buffer<std::string> lastmessages(5);
 namespace {
 	bool no_throw;
 	bool deferred;
+	thread_local std::vector<std::string> *print_capture = nullptr;
+	thread_local size_t message_count = 0;
+}
+
+void set_print_capture(std::vector<std::string> *capture)
+{
+	print_capture = capture;
+}
+
+size_t print_message_count()
+{
+	return message_count;
 }
 
 void set_output_handler(OutputHandlerFunc *newhandler, void *userdata)
@@ -63,9 +75,24 @@ void print_messages_pop()
 	}
 }
 
+/*!
+	The message stack belongs to the main thread. Threads capturing their
+	messages never touch it, so they get their captured messages instead.
+*/
+std::string print_messages_current()
+{
+	if (print_capture) return boost::algorithm::join(*print_capture, "\n");
+	return print_messages_stack.empty() ? std::string() : print_messages_stack.back();
+}
+
 void PRINT(const std::string &msg)
 {
 	if (msg.empty()) return;
+	if (print_capture) {
+		message_count++;
+		print_capture->push_back(msg);
+		return;
+	}
 	if (print_messages_stack.size() > 0) {
 		if (!print_messages_stack.back().empty()) {
 			print_messages_stack.back() += "\n";
@@ -78,6 +105,11 @@ void PRINT(const std::string &msg)
 void PRINT_NOCACHE(const std::string &msg)
 {
 	if (msg.empty()) return;
+	message_count++;
+	if (print_capture) {
+		print_capture->push_back(msg);
+		return;
+	}
 
 	if (boost::starts_with(msg, "WARNING") || boost::starts_with(msg, "ERROR") || boost::starts_with(msg, "TRACE")) {
 		size_t i;
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <list>
+#include <vector>
 #include <iostream>
 #include <boost/format.hpp>
 #include <boost/algorithm/string.hpp>
@@ -43,8 +44,14 @@ bool would_have_thrown();
 extern std::list<std::string> print_messages_stack;
 void print_messages_push();
 void print_messages_pop();
+// Messages on top of print_messages_stack, or those captured by the calling thread while capturing
+std::string print_messages_current();
 void printDeprecation(const std::string &str);
 void resetSuppressedMessages();
+// While set, messages printed by the calling thread are appended to capture instead of being output
+void set_print_capture(std::vector<std::string> *capture);
+// Number of messages printed by the calling thread, including captured ones
+size_t print_message_count();
 
 #define PRINT_DEPRECATION(_fmt, _arg) do { printDeprecation(str(boost::format(_fmt) % _arg)); } while (0)
 
@@ -5,6 +5,7 @@ int progress_report_count;
 int _progress_mark;
 void (*progress_report_f)(const class AbstractNode*, void*, int);
 void *progress_report_userdata;
+static thread_local bool progress_report_disabled = false;
 
 void progress_report_prep(AbstractNode *root, void (*f)(const class AbstractNode *node, void *userdata, int mark), void *userdata)
 {
@@ -21,9 +22,14 @@ void progress_report_fin()
 	progress_report_userdata = nullptr;
 }
 
+void progress_report_disable(bool disable)
+{
+	progress_report_disabled = disable;
+}
+
 void progress_update(const AbstractNode *node, int mark)
 {
-	if (progress_report_f) {
+	if (progress_report_f && !progress_report_disabled) {
 		_progress_mark = mark;
 		progress_report_f(node, progress_report_userdata, _progress_mark);
 	}
@@ -31,6 +37,12 @@ void progress_update(const AbstractNode *node, int mark)
 
 void progress_tick()
 {
-	if (progress_report_f)
+	if (progress_report_f && !progress_report_disabled)
 		progress_report_f(nullptr, progress_report_userdata, ++_progress_mark);
 }
+
+void progress_check()
+{
+	if (progress_report_f && !progress_report_disabled)
+		progress_report_f(nullptr, progress_report_userdata, _progress_mark);
+}
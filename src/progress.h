@@ -11,5 +11,9 @@ void progress_report_fin();
 void progress_update(const AbstractNode *node, int mark);
 // CGALUtils::applyUnion may process nodes out of order, so allow for an increment instead of tracking exact node
 void progress_tick();
+// Lets the progress callback cancel long running work which doesn't advance the progress, e.g. CSG normalization
+void progress_check();
+// Disables progress reporting from the calling thread, e.g. for worker threads of parallel evaluation
+void progress_report_disable(bool disable);
 
 class ProgressCancelException { };
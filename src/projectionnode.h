@@ -10,6 +10,7 @@ public:
 	ProjectionNode(const ModuleInstantiation *mi, const std::shared_ptr<EvalContext> &ctx) : AbstractPolyNode(mi, ctx), convexity(1), cut_mode(false) { }
 	std::string toString() const override;
 	std::string name() const override { return "projection"; }
+	AbstractNode *clone() const override { return cloneAs(*this); }
 
 	int convexity;
 	bool cut_mode;
@@ -9,6 +9,8 @@
 #include "polyset-utils.h"
 #include "grid.h"
 #include <Eigen/LU>
+#include <map>
+#include <tuple>
 
 bool Renderer::getColor(Renderer::ColorMode colormode, Color4f &col) const
 {
@@ -26,6 +28,10 @@ Renderer::csgmode_e Renderer::get_csgmode(const bool highlight_mode, const bool
     return csgmode_e(csgmode);
 }
 
+Renderer::~Renderer()
+{
+}
+
 Renderer::Renderer() : colorscheme(nullptr)
 {
 	PRINTD("Renderer() start");
@@ -197,60 +203,49 @@ static void gl_draw_triangle(const GLView::shaderinfo_t *shaderinfo, const Vecto
 	}
 }
 
-void Renderer::render_surface(shared_ptr<const class Geometry> geom, csgmode_e csgmode, const Transform3d &m, const GLView::shaderinfo_t *shaderinfo) const
+/*
+	Calls emit(p0, p1, p2, e0, e1, e2, z) for each triangle render_surface()
+	draws for ps, where e0..e2 tell which triangle edges are polygon edges.
+*/
+template <typename F>
+static void for_each_surface_triangle(const PolySet &ps, Renderer::csgmode_e csgmode, F emit)
 {
-	PRINTD("Renderer render");
-	bool mirrored = m.matrix().determinant() < 0;
-	shared_ptr<const PolySet> ps = dynamic_pointer_cast<const PolySet>(geom);
-
-	if (!ps) return;
-
-#ifdef ENABLE_OPENCSG
-	if (shaderinfo && shaderinfo->type == GLView::shaderinfo_t::CSG_RENDERING) {
-		glUniform1f(shaderinfo->data.csg_rendering.xscale, shaderinfo->vp_size_x);
-		glUniform1f(shaderinfo->data.csg_rendering.yscale, shaderinfo->vp_size_y);
-	}
-#endif /* ENABLE_OPENCSG */
-	if (ps->getDimension() == 2) {
+	if (ps.getDimension() == 2) {
 		// Render 2D objects 1mm thick, but differences slightly larger
 		double zbase = 1 + ((csgmode & CSGMODE_DIFFERENCE_FLAG) ? 0.1 : 0);
-		glBegin(GL_TRIANGLES);
 
 		// Render top+bottom
 		for (double z = -zbase/2; z < zbase; z += zbase) {
-			for (size_t i = 0; i < ps->polygons.size(); i++) {
-				const Polygon *poly = &ps->polygons[i];
-				if (poly->size() == 3) {
+			for (const auto &poly : ps.polygons()) {
+				if (poly.size() == 3) {
 					if (z < 0) {
-						gl_draw_triangle(shaderinfo, poly->at(0), poly->at(2), poly->at(1), true, true, true, z, mirrored);
+						emit(poly.at(0), poly.at(2), poly.at(1), true, true, true, z);
 					} else {
-						gl_draw_triangle(shaderinfo, poly->at(0), poly->at(1), poly->at(2), true, true, true, z, mirrored);
+						emit(poly.at(0), poly.at(1), poly.at(2), true, true, true, z);
 					}
 				}
-				else if (poly->size() == 4) {
+				else if (poly.size() == 4) {
 					if (z < 0) {
-						gl_draw_triangle(shaderinfo, poly->at(0), poly->at(3), poly->at(1), true, false, true, z, mirrored);
-						gl_draw_triangle(shaderinfo, poly->at(2), poly->at(1), poly->at(3), true, false, true, z, mirrored);
+						emit(poly.at(0), poly.at(3), poly.at(1), true, false, true, z);
+						emit(poly.at(2), poly.at(1), poly.at(3), true, false, true, z);
 					} else {
-						gl_draw_triangle(shaderinfo, poly->at(0), poly->at(1), poly->at(3), true, false, true, z, mirrored);
-						gl_draw_triangle(shaderinfo, poly->at(2), poly->at(3), poly->at(1), true, false, true, z, mirrored);
+						emit(poly.at(0), poly.at(1), poly.at(3), true, false, true, z);
+						emit(poly.at(2), poly.at(3), poly.at(1), true, false, true, z);
 					}
 				}
 				else {
 					Vector3d center = Vector3d::Zero();
-					for (size_t j = 0; j < poly->size(); j++) {
-						center[0] += poly->at(j)[0];
-						center[1] += poly->at(j)[1];
+					for (size_t j = 0; j < poly.size(); j++) {
+						center[0] += poly.at(j)[0];
+						center[1] += poly.at(j)[1];
 					}
-					center[0] /= poly->size();
-					center[1] /= poly->size();
-					for (size_t j = 1; j <= poly->size(); j++) {
+					center[0] /= poly.size();
+					center[1] /= poly.size();
+					for (size_t j = 1; j <= poly.size(); j++) {
 						if (z < 0) {
-							gl_draw_triangle(shaderinfo, center, poly->at(j % poly->size()), poly->at(j - 1),
-									false, true, false, z, mirrored);
+							emit(center, poly.at(j % poly.size()), poly.at(j - 1), false, true, false, z);
 						} else {
-							gl_draw_triangle(shaderinfo, center, poly->at(j - 1), poly->at(j % poly->size()),
-									false, true, false, z, mirrored);
+							emit(center, poly.at(j - 1), poly.at(j % poly.size()), false, true, false, z);
 						}
 					}
 				}
@@ -258,61 +253,55 @@ void Renderer::render_surface(shared_ptr<const class Geometry> geom, csgmode_e c
 		}
 
 		// Render sides
-		if (ps->getPolygon().outlines().size() > 0) {
-			for (const Outline2d &o : ps->getPolygon().outlines()) {
+		if (ps.getPolygon().outlines().size() > 0) {
+			for (const Outline2d &o : ps.getPolygon().outlines()) {
 				for (size_t j = 1; j <= o.vertices.size(); j++) {
 					Vector3d p1(o.vertices[j-1][0], o.vertices[j-1][1], -zbase/2);
 					Vector3d p2(o.vertices[j-1][0], o.vertices[j-1][1], zbase/2);
 					Vector3d p3(o.vertices[j % o.vertices.size()][0], o.vertices[j % o.vertices.size()][1], -zbase/2);
 					Vector3d p4(o.vertices[j % o.vertices.size()][0], o.vertices[j % o.vertices.size()][1], zbase/2);
-					gl_draw_triangle(shaderinfo, p2, p1, p3, true, true, false, 0, mirrored);
-					gl_draw_triangle(shaderinfo, p2, p3, p4, false, true, true, 0, mirrored);
+					emit(p2, p1, p3, true, true, false, 0);
+					emit(p2, p3, p4, false, true, true, 0);
 				}
-}
+			}
 		}
 		else {
 			// If we don't have borders, use the polygons as borders.
 			// FIXME: When is this used?
-			const Polygons *borders_p = &ps->polygons;
-			for (size_t i = 0; i < borders_p->size(); i++) {
-				const Polygon *poly = &borders_p->at(i);
-				for (size_t j = 1; j <= poly->size(); j++) {
-					Vector3d p1 = poly->at(j - 1), p2 = poly->at(j - 1);
-					Vector3d p3 = poly->at(j % poly->size()), p4 = poly->at(j % poly->size());
+			for (const auto &poly : ps.polygons()) {
+				for (size_t j = 1; j <= poly.size(); j++) {
+					Vector3d p1 = poly.at(j - 1), p2 = poly.at(j - 1);
+					Vector3d p3 = poly.at(j % poly.size()), p4 = poly.at(j % poly.size());
 					p1[2] -= zbase/2, p2[2] += zbase/2;
 					p3[2] -= zbase/2, p4[2] += zbase/2;
-					gl_draw_triangle(shaderinfo, p2, p1, p3, true, true, false, 0, mirrored);
-					gl_draw_triangle(shaderinfo, p2, p3, p4, false, true, true, 0, mirrored);
+					emit(p2, p1, p3, true, true, false, 0);
+					emit(p2, p3, p4, false, true, true, 0);
 				}
 			}
 		}
-		glEnd();
-	} else if (ps->getDimension() == 3) {
-		for (size_t i = 0; i < ps->polygons.size(); i++) {
-			const Polygon *poly = &ps->polygons[i];
-			glBegin(GL_TRIANGLES);
-			if (poly->size() == 3) {
-				gl_draw_triangle(shaderinfo, poly->at(0), poly->at(1), poly->at(2), true, true, true, 0, mirrored);
+	} else if (ps.getDimension() == 3) {
+		for (const auto &poly : ps.polygons()) {
+			if (poly.size() == 3) {
+				emit(poly.at(0), poly.at(1), poly.at(2), true, true, true, 0);
 			}
-			else if (poly->size() == 4) {
-				gl_draw_triangle(shaderinfo, poly->at(0), poly->at(1), poly->at(3), true, false, true, 0, mirrored);
-				gl_draw_triangle(shaderinfo, poly->at(2), poly->at(3), poly->at(1), true, false, true, 0, mirrored);
+			else if (poly.size() == 4) {
+				emit(poly.at(0), poly.at(1), poly.at(3), true, false, true, 0);
+				emit(poly.at(2), poly.at(3), poly.at(1), true, false, true, 0);
 			}
 			else {
 				Vector3d center = Vector3d::Zero();
-				for (size_t j = 0; j < poly->size(); j++) {
-					center[0] += poly->at(j)[0];
-					center[1] += poly->at(j)[1];
-					center[2] += poly->at(j)[2];
+				for (size_t j = 0; j < poly.size(); j++) {
+					center[0] += poly.at(j)[0];
+					center[1] += poly.at(j)[1];
+					center[2] += poly.at(j)[2];
 				}
-				center[0] /= poly->size();
-				center[1] /= poly->size();
-				center[2] /= poly->size();
-				for (size_t j = 1; j <= poly->size(); j++) {
-					gl_draw_triangle(shaderinfo, center, poly->at(j - 1), poly->at(j % poly->size()), false, true, false, 0, mirrored);
+				center[0] /= poly.size();
+				center[1] /= poly.size();
+				center[2] /= poly.size();
+				for (size_t j = 1; j <= poly.size(); j++) {
+					emit(center, poly.at(j - 1), poly.at(j % poly.size()), false, true, false, 0);
 				}
 			}
-			glEnd();
 		}
 	}
 	else {
@@ -320,6 +309,164 @@ void Renderer::render_surface(shared_ptr<const class Geometry> geom, csgmode_e c
 	}
 }
 
+/*!
+	The triangles render_surface() draws for each PolySet, uploaded once to
+	vertex buffer objects and drawn from there on every frame.
+
+	Every vertex has the normal of its triangle, and for the edge shader also
+	the other two corners of its triangle, so vertices aren't shared between
+	triangles and are drawn as arrays rather than indexed. The shader
+	attributes are only uploaded once the shader is used.
+
+	Buffers are kept until the PolySet is gone, or the renderer is deleted;
+	the OpenGL context must be current at that point.
+*/
+class SurfaceBuffers
+{
+public:
+	~SurfaceBuffers() {
+		for (auto &entry : this->entries) release(entry.second);
+	}
+
+	void draw(const shared_ptr<const PolySet> &ps, Renderer::csgmode_e csgmode, bool mirrored, const GLView::shaderinfo_t *shaderinfo) {
+		const bool edges = shaderinfo && shaderinfo->type == GLView::shaderinfo_t::CSG_RENDERING;
+		// Only 2D objects depend on the mode; they're drawn thicker as differences
+		const bool difference = ps->getDimension() == 2 && (csgmode & CSGMODE_DIFFERENCE_FLAG);
+		auto &entry = this->entries[Key(ps.get(), mirrored, difference)];
+		// The PolySet may have been replaced by another one at the same address
+		if (entry.ps.lock() != ps) {
+			release(entry);
+			entry.ps = ps;
+			removeExpired();
+		}
+		if (!entry.vertices || (edges && !entry.edges)) upload(entry, *ps, csgmode, mirrored, edges);
+
+		glBindBuffer(GL_ARRAY_BUFFER, entry.vertices);
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_NORMAL_ARRAY);
+		glVertexPointer(3, GL_FLOAT, 6*sizeof(GLfloat), nullptr);
+		glNormalPointer(GL_FLOAT, 6*sizeof(GLfloat), reinterpret_cast<const GLvoid *>(3*sizeof(GLfloat)));
+		if (edges) {
+			glBindBuffer(GL_ARRAY_BUFFER, entry.edges);
+			const GLint attributes[] = {
+				shaderinfo->data.csg_rendering.trig,
+				shaderinfo->data.csg_rendering.point_b,
+				shaderinfo->data.csg_rendering.point_c,
+				shaderinfo->data.csg_rendering.mask
+			};
+			for (int i = 0; i < 4; i++) {
+				glEnableVertexAttribArray(attributes[i]);
+				glVertexAttribPointer(attributes[i], 3, GL_FLOAT, GL_FALSE, 12*sizeof(GLfloat),
+					reinterpret_cast<const GLvoid *>(3*i*sizeof(GLfloat)));
+			}
+			glDrawArrays(GL_TRIANGLES, 0, entry.count);
+			for (int i = 0; i < 4; i++) glDisableVertexAttribArray(attributes[i]);
+		}
+		else {
+			glDrawArrays(GL_TRIANGLES, 0, entry.count);
+		}
+		glDisableClientState(GL_NORMAL_ARRAY);
+		glDisableClientState(GL_VERTEX_ARRAY);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+private:
+	typedef std::tuple<const PolySet *, bool, bool> Key;
+	struct Entry {
+		Entry() : vertices(0), edges(0), count(0) {}
+		std::weak_ptr<const PolySet> ps;
+		GLuint vertices; // Positions and normals
+		GLuint edges;    // Attributes of the edge shader
+		GLsizei count;
+	};
+
+	static void release(Entry &entry) {
+		if (entry.vertices) glDeleteBuffers(1, &entry.vertices);
+		if (entry.edges) glDeleteBuffers(1, &entry.edges);
+		entry.vertices = entry.edges = 0;
+		entry.count = 0;
+	}
+
+	void removeExpired() {
+		for (auto it = this->entries.begin(); it != this->entries.end();) {
+			if (it->second.ps.expired()) {
+				release(it->second);
+				it = this->entries.erase(it);
+			}
+			else ++it;
+		}
+	}
+
+	// Generates the same vertices and attributes as gl_draw_triangle()
+	static void upload(Entry &entry, const PolySet &ps, Renderer::csgmode_e csgmode, bool mirrored, bool edges) {
+		std::vector<GLfloat> vertices, attributes;
+		auto add = [](std::vector<GLfloat> &v, double x, double y, double z) {
+			v.push_back(GLfloat(x));
+			v.push_back(GLfloat(y));
+			v.push_back(GLfloat(z));
+		};
+		for_each_surface_triangle(ps, csgmode, [&](const Vector3d &p0, const Vector3d &p1, const Vector3d &p2, bool e0, bool e1, bool e2, double z) {
+			const Vector3d n = (p1 - p0).cross(p1 - p2).normalized();
+			const Vector3d q[3] = { p0 + Vector3d(0, 0, z), p1 + Vector3d(0, 0, z), p2 + Vector3d(0, 0, z) };
+			const int order[2][3] = { { 0, 1, 2 }, { 0, 2, 1 } };
+			for (int i : order[mirrored]) {
+				add(vertices, q[i][0], q[i][1], q[i][2]);
+				add(vertices, n[0], n[1], n[2]);
+				if (edges) {
+					add(attributes, e0 ? 2.0 : -1.0, e1 ? 2.0 : -1.0, e2 ? 2.0 : -1.0);
+					const Vector3d &b = q[i == 0 ? 1 : 0], &c = q[i == 2 ? 1 : 2];
+					add(attributes, b[0], b[1], b[2]);
+					add(attributes, c[0], c[1], c[2]);
+					add(attributes, i == 2, i == 0, i == 1);
+				}
+			}
+		});
+
+		entry.count = GLsizei(vertices.size() / 6);
+		if (!entry.vertices) {
+			glGenBuffers(1, &entry.vertices);
+			glBindBuffer(GL_ARRAY_BUFFER, entry.vertices);
+			glBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
+		}
+		if (edges) {
+			glGenBuffers(1, &entry.edges);
+			glBindBuffer(GL_ARRAY_BUFFER, entry.edges);
+			glBufferData(GL_ARRAY_BUFFER, attributes.size()*sizeof(GLfloat), attributes.data(), GL_STATIC_DRAW);
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	std::map<Key, Entry> entries;
+};
+
+void Renderer::render_surface(shared_ptr<const class Geometry> geom, csgmode_e csgmode, const Transform3d &m, const GLView::shaderinfo_t *shaderinfo) const
+{
+	PRINTD("Renderer render");
+	bool mirrored = m.matrix().determinant() < 0;
+	shared_ptr<const PolySet> ps = dynamic_pointer_cast<const PolySet>(geom);
+
+	if (!ps) return;
+
+#ifdef ENABLE_OPENCSG
+	if (shaderinfo && shaderinfo->type == GLView::shaderinfo_t::CSG_RENDERING) {
+		glUniform1f(shaderinfo->data.csg_rendering.xscale, shaderinfo->vp_size_x);
+		glUniform1f(shaderinfo->data.csg_rendering.yscale, shaderinfo->vp_size_y);
+	}
+#endif /* ENABLE_OPENCSG */
+	// Vertex buffer objects are core since OpenGL 1.5
+	if (GLEW_VERSION_1_5) {
+		if (!this->surfaceBuffers) this->surfaceBuffers.reset(new SurfaceBuffers());
+		this->surfaceBuffers->draw(ps, csgmode, mirrored, shaderinfo);
+	}
+	else {
+		glBegin(GL_TRIANGLES);
+		for_each_surface_triangle(*ps, csgmode, [&](const Vector3d &p0, const Vector3d &p1, const Vector3d &p2, bool e0, bool e1, bool e2, double z) {
+			gl_draw_triangle(shaderinfo, p0, p1, p2, e0, e1, e2, z, mirrored);
+		});
+		glEnd();
+	}
+}
+
 /*! This is used in throwntogether and CGAL mode
 
 	csgmode is set to CSGMODE_NONE in CGAL mode. In this mode a pure 2D rendering is performed.
@@ -367,11 +514,10 @@ void Renderer::render_edges(shared_ptr<const Geometry> geom, csgmode_e csgmode)
 			}
 		}
 	} else if (ps->getDimension() == 3) {
-		for (size_t i = 0; i < ps->polygons.size(); i++) {
-			const Polygon *poly = &ps->polygons[i];
+		for (const auto &poly : ps->polygons()) {
 			glBegin(GL_LINE_LOOP);
-			for (size_t j = 0; j < poly->size(); j++) {
-				const Vector3d &p = poly->at(j);
+			for (size_t j = 0; j < poly.size(); j++) {
+				const Vector3d &p = poly.at(j);
 				glVertex3d(p[0], p[1], p[2]);
 			}
 			glEnd();
@@ -385,6 +531,7 @@ void Renderer::render_edges(shared_ptr<const Geometry> geom, csgmode_e csgmode)
 
 
 #else //NULLGL
+class SurfaceBuffers {};
 static void gl_draw_triangle(const GLView::shaderinfo_t *shaderinfo, const Vector3d &p0, const Vector3d &p1, const Vector3d &p2, bool e0, bool e1, bool e2, double z, bool mirrored) {}
 void Renderer::render_surface(shared_ptr<const class Geometry> geom, csgmode_e csgmode, const Transform3d &m, const GLView::shaderinfo_t *shaderinfo) const {}
 void Renderer::render_edges(shared_ptr<const Geometry> geom, csgmode_e csgmode) const {}
@@ -16,7 +16,7 @@ class Renderer
 {
 public:
 	Renderer();
-	virtual ~Renderer() {}
+	virtual ~Renderer();
 	virtual void draw(bool showfaces, bool showedges) const = 0;
 	virtual void draw_with_shader(const GLView::shaderinfo_t *) const  { this->draw(true, true); }
 	virtual BoundingBox getBoundingBox() const = 0;
@@ -60,4 +60,6 @@ public:
 protected:
 	std::map<ColorMode,Color4f> colormap;
 	const ColorScheme *colorscheme;
+	// Vertex buffers of the geometry drawn by render_surface()
+	mutable std::unique_ptr<class SurfaceBuffers> surfaceBuffers;
 };
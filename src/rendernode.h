@@ -10,6 +10,7 @@ public:
 	RenderNode(const ModuleInstantiation *mi, const std::shared_ptr<EvalContext> &ctx) : AbstractNode(mi, ctx), convexity(1) { }
 	std::string toString() const override;
 	std::string name() const override { return "render"; }
+	AbstractNode *clone() const override { return cloneAs(*this); }
 
 	int convexity;
 };
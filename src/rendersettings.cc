@@ -14,6 +14,7 @@ RenderSettings *RenderSettings::inst(bool erase)
 RenderSettings::RenderSettings()
 {
 	openCSGTermLimit = 100000;
+	threads = 1;
 	far_gl_clip_limit = 100000.0;
 	img_width = 512;
 	img_height = 512;
@@ -9,6 +9,8 @@ public:
 	static RenderSettings *inst(bool erase = false);
 
 	unsigned int openCSGTermLimit;
+	// Worker threads for parallel CGAL operations; 0 means one per hardware thread
+	unsigned int threads;
 	unsigned int img_width;
 	unsigned int img_height;
 	double far_gl_clip_limit;
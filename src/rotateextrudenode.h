@@ -15,6 +15,7 @@ public:
 	}
 	std::string toString() const override;
 	std::string name() const override { return "rotate_extrude"; }
+	AbstractNode *clone() const override { return cloneAs(*this); }
 
 	int convexity;
 	double fn, fs, fa;
@@ -66,6 +66,7 @@ public:
 	SurfaceNode(const ModuleInstantiation *mi, const std::shared_ptr<EvalContext> &ctx) : LeafNode(mi, ctx), center(false), invert(false), convexity(1) { }
 	std::string toString() const override;
 	std::string name() const override { return "surface"; }
+	AbstractNode *clone() const override { return cloneAs(*this); }
 
 	Filename filename;
 	bool center;
@@ -34,6 +34,7 @@
 #include "FreetypeRenderer.h"
 #include "Polygon2d.h"
 
+#include <mutex>
 #include <boost/assign/std/vector.hpp>
 using namespace boost::assign; // bring 'operator+=()' into scope
 
@@ -92,6 +93,9 @@ AbstractNode *TextModule::instantiate(const std::shared_ptr<Context>& ctx, const
 
 std::vector<const Geometry *> TextNode::createGeometryList() const
 {
+	// FreeType and the font cache aren't thread-safe, but text may be rendered by parallel evaluation tasks
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> lock(mutex);
 	FreetypeRenderer renderer;
 	return renderer.render(this->get_params());
 }
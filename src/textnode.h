@@ -15,6 +15,7 @@ public:
 
 	std::string toString() const override;
 	std::string name() const override { return "text"; }
+	AbstractNode *clone() const override { return cloneAs(*this); }
 
 	virtual std::vector<const class Geometry *> createGeometryList() const;
 
@@ -11,6 +11,7 @@ public:
 	TransformNode(const ModuleInstantiation *mi, const std::shared_ptr<EvalContext> &ctx);
 	std::string toString() const override;
 	std::string name() const override;
+	AbstractNode *clone() const override { return cloneAs(*this); }
 
 	Transform3d matrix;
 };
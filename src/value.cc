@@ -265,9 +265,54 @@ Value::Value(char v) : value(str_utf8_wrapper(1, v))
   //  std::cout << "creating string from char\n";
 }
 
-Value::Value(const VectorType &v) : value(v)
+Value::Value(const VectorType &v)
+{
+  // Vectors of numbers and matrices of numbers are stored dense
+  if (!v.empty() && v[0]->type() == ValueType::NUMBER) {
+    std::vector<double> numbers;
+    numbers.reserve(v.size());
+    for (const auto &element : v) {
+      double number;
+      if (!element->getDouble(number)) {
+        this->value = v;
+        return;
+      }
+      numbers.push_back(number);
+    }
+    this->value = DenseVectorType(std::move(numbers));
+    return;
+  }
+  const DenseVectorType *first = v.empty() ? nullptr : v[0]->toDense();
+  if (first && first->columns() == 0) {
+    const size_t columns = first->size();
+    for (const auto &element : v) {
+      const DenseVectorType *row = element->toDense();
+      if (!row || row->columns() != 0 || row->size() != columns) {
+        this->value = v;
+        return;
+      }
+    }
+    std::vector<double> numbers;
+    numbers.reserve(v.size() * columns);
+    for (const auto &element : v) {
+      const double *row = element->toDense()->data();
+      numbers.insert(numbers.end(), row, row + columns);
+    }
+    this->value = DenseVectorType(std::move(numbers), columns);
+    return;
+  }
+  this->value = v;
+}
+
+Value::Value(const DenseVectorType &v) : value(v)
 {
-  //  std::cout << "creating vector\n";
+}
+
+Value Value::unpacked(const VectorType &v)
+{
+  Value result;
+  result.value = v;
+  return result;
 }
 
 Value::Value(const RangeType &v) : value(v)
@@ -282,7 +327,10 @@ Value::Value(const FunctionType &v) : value(v)
 
 Value::ValueType Value::type() const
 {
-  return static_cast<ValueType>(this->value.which());
+  const int which = this->value.which();
+  // DenseVectorType is the only alternative after FUNCTION
+  if (which > int(ValueType::FUNCTION)) return ValueType::VECTOR;
+  return static_cast<ValueType>(which);
 }
 
 bool Value::isDefined() const
@@ -340,6 +388,7 @@ bool Value::toBool() const
     return !boost::get<str_utf8_wrapper>(this->value).empty();
     break;
   case ValueType::VECTOR:
+    if (const DenseVectorType *dense = toDense()) return dense->size() > 0;
     return !boost::get<VectorType >(this->value).empty();
     break;
   case ValueType::RANGE:
@@ -421,6 +470,8 @@ public:
     return (boost::format("[%1% : %2% : %3%]") % v.begin_val % v.step_val % v.end_val).str();
   }
 
+  std::string operator()(const DenseVectorType &v) const;
+
   std::string operator()(const FunctionType &v) const {
 	return STR(v);
   }
@@ -468,6 +519,26 @@ public:
     stream << ']';
   }
 
+  void operator()(const DenseVectorType &v) const {
+    const double *numbers = v.data();
+    const size_t columns = v.columns();
+    stream << '[';
+    for (size_t i = 0; i < v.size(); i++) {
+      if (i > 0) stream << ", ";
+      if (columns == 0) {
+        this->operator()(numbers[i]);
+        continue;
+      }
+      stream << '[';
+      for (size_t j = 0; j < columns; j++) {
+        if (j > 0) stream << ", ";
+        this->operator()(numbers[i * columns + j]);
+      }
+      stream << ']';
+    }
+    stream << ']';
+  }
+
   void operator()(const str_utf8_wrapper &v) const {
     stream << '"' << v << '"';
   }
@@ -487,6 +558,14 @@ public:
   }
 };
 
+std::string tostring_visitor::operator()(const DenseVectorType &v) const
+{
+  std::ostringstream stream;
+  const tostream_visitor visitor(stream);
+  visitor(v);
+  return stream.str();
+}
+
 std::string Value::toString() const
 {
   return boost::apply_visitor(tostring_visitor(), this->value);
@@ -558,6 +637,11 @@ public:
 			return stream.str();
 		}
 
+	std::string operator()(const DenseVectorType &v) const
+		{
+			return this->operator()(v.elements());
+		}
+
 	std::string operator()(const RangeType &v) const
 		{
 			const uint32_t steps = v.numValues();
@@ -587,13 +671,29 @@ const Value::VectorType &Value::toVector() const
   
   const VectorType *v = boost::get<VectorType>(&this->value);
   if (v) return *v;
+  const DenseVectorType *dense = toDense();
+  if (dense) return dense->elements();
   else return empty;
 }
 
+const DenseVectorType *Value::toDense() const
+{
+  return boost::get<DenseVectorType>(&this->value);
+}
+
 bool Value::getVec2(double &x, double &y, bool ignoreInfinite) const
 {
   if (this->type() != ValueType::VECTOR) return false;
 
+  if (const DenseVectorType *dense = toDense()) {
+    if (dense->columns() != 0 || dense->size() != 2) return false;
+    const double *numbers = dense->data();
+    if (ignoreInfinite && (!std::isfinite(numbers[0]) || !std::isfinite(numbers[1]))) return false;
+    x = numbers[0];
+    y = numbers[1];
+    return true;
+  }
+
   const VectorType &v = toVector();
   
   if (v.size() != 2) return false;
@@ -615,6 +715,15 @@ bool Value::getVec3(double &x, double &y, double &z) const
 {
   if (this->type() != ValueType::VECTOR) return false;
 
+  if (const DenseVectorType *dense = toDense()) {
+    if (dense->columns() != 0 || dense->size() != 3) return false;
+    const double *numbers = dense->data();
+    x = numbers[0];
+    y = numbers[1];
+    z = numbers[2];
+    return true;
+  }
+
   const VectorType &v = toVector();
 
   if (v.size() != 3) return false;
@@ -626,6 +735,16 @@ bool Value::getVec3(double &x, double &y, double &z, double defaultval) const
 {
   if (this->type() != ValueType::VECTOR) return false;
 
+  if (const DenseVectorType *dense = toDense()) {
+    if (dense->columns() != 0) return false;
+    if (dense->size() == 2) {
+      getVec2(x, y);
+      z = defaultval;
+      return true;
+    }
+    return getVec3(x, y, z);
+  }
+
   const VectorType &v = toVector();
 
   if (v.size() == 2) {
@@ -667,6 +786,14 @@ public:
   bool operator()(const double &op1, const bool &op2) const {
     return op1 == op2;
   }
+
+  bool operator()(const Value::VectorType &op1, const DenseVectorType &op2) const {
+    return op1 == op2.elements();
+  }
+
+  bool operator()(const DenseVectorType &op1, const Value::VectorType &op2) const {
+    return op1.elements() == op2;
+  }
 };
 
 bool Value::operator==(const Value &v) const
@@ -701,6 +828,18 @@ bool Value::operator!=(const Value &v) const
 																																				\
 		bool operator()(const double &op1, const bool &op2) const {					\
 			return op1 op op2;																								\
+		}																																		\
+																																				\
+		bool operator()(const DenseVectorType &op1, const DenseVectorType &op2) const {	\
+			return op1.elements() op op2.elements();													\
+		}																																		\
+																																				\
+		bool operator()(const Value::VectorType &op1, const DenseVectorType &op2) const {	\
+			return op1 op op2.elements();																			\
+		}																																		\
+																																				\
+		bool operator()(const DenseVectorType &op1, const Value::VectorType &op2) const {	\
+			return op1.elements() op op2;																			\
 		}																																		\
 	}
 
@@ -729,6 +868,36 @@ bool Value::operator<=(const Value &v) const
 	return boost::apply_visitor(lessequal_visitor(), this->value, v.value);
 }
 
+namespace {
+	// Applies op to the numbers of two dense vectors with the same number
+	// of columns, up to the length of the shorter one
+	template <typename Op>
+	Value elementwise(const DenseVectorType &op1, const DenseVectorType &op2, Op op)
+	{
+		const double *numbers1 = op1.data();
+		const double *numbers2 = op2.data();
+		std::vector<double> result(std::min(op1.dataSize(), op2.dataSize()));
+		for (size_t i = 0; i < result.size(); i++) {
+			result[i] = op(numbers1[i], numbers2[i]);
+		}
+		if (op1.columns()) return DenseVectorType(std::move(result), op1.columns());
+		return DenseVectorType(std::move(result));
+	}
+
+	// Applies op to each number of a dense vector
+	template <typename Op>
+	Value elementwise(const DenseVectorType &v, Op op)
+	{
+		const double *numbers = v.data();
+		std::vector<double> result(v.dataSize());
+		for (size_t i = 0; i < result.size(); i++) {
+			result[i] = op(numbers[i]);
+		}
+		if (v.columns()) return DenseVectorType(std::move(result), v.columns());
+		return DenseVectorType(std::move(result));
+	}
+}
+
 class plus_visitor : public boost::static_visitor<Value>
 {
 public:
@@ -747,6 +916,19 @@ public:
 		}
 		return {sum};
 	}
+
+	Value operator()(const DenseVectorType &op1, const DenseVectorType &op2) const {
+		if (op1.columns() == op2.columns()) return elementwise(op1, op2, std::plus<double>());
+		return this->operator()(op1.elements(), op2.elements());
+	}
+
+	Value operator()(const Value::VectorType &op1, const DenseVectorType &op2) const {
+		return this->operator()(op1, op2.elements());
+	}
+
+	Value operator()(const DenseVectorType &op1, const Value::VectorType &op2) const {
+		return this->operator()(op1.elements(), op2);
+	}
 };
 
 Value Value::operator+(const Value &v) const
@@ -772,6 +954,19 @@ public:
 		}
 		return {sum};
 	}
+
+	Value operator()(const DenseVectorType &op1, const DenseVectorType &op2) const {
+		if (op1.columns() == op2.columns()) return elementwise(op1, op2, std::minus<double>());
+		return this->operator()(op1.elements(), op2.elements());
+	}
+
+	Value operator()(const Value::VectorType &op1, const DenseVectorType &op2) const {
+		return this->operator()(op1, op2.elements());
+	}
+
+	Value operator()(const DenseVectorType &op1, const Value::VectorType &op2) const {
+		return this->operator()(op1.elements(), op2);
+	}
 };
 
 Value Value::operator-(const Value &v) const
@@ -782,6 +977,10 @@ Value Value::operator-(const Value &v) const
 Value Value::multvecnum(const Value &vecval, const Value &numval)
 {
 // Vector * Number
+	if (const DenseVectorType *dense = vecval.toDense()) {
+		const double number = numval.toDouble();
+		return elementwise(*dense, [number](double x) { return x * number; });
+	}
 	VectorType dstv;
 	for(const auto &val : vecval.toVector()) {
 		dstv.push_back(ValuePtr(*val * numval));
@@ -839,6 +1038,54 @@ Value Value::multvecmat(const VectorType &vectorvec, const VectorType &matrixvec
 	return {dstv};
 }
 
+Value Value::multdense(const DenseVectorType &op1, const DenseVectorType &op2)
+{
+// The products of vectors and matrices of numbers in operator*(), summed
+// in the same order, without checking the elements
+	const double *numbers1 = op1.data();
+	const double *numbers2 = op2.data();
+	if (!op1.columns() && !op2.columns()) {
+		// Vector dot product.
+		if (op1.size() != op2.size()) return Value::undefined;
+		auto r = 0.0;
+		for (size_t i = 0; i < op1.size(); i++) {
+			r += (numbers1[i] * numbers2[i]);
+		}
+		return Value(r);
+	}
+	if (!op2.columns()) {
+		// Matrix * Vector
+		const size_t columns = op1.columns();
+		if (columns != op2.size()) return Value::undefined;
+		std::vector<double> dstv(op1.size());
+		for (size_t i = 0; i < dstv.size(); i++) {
+			double r_e = 0.0;
+			for (size_t j = 0; j < columns; j++) {
+				r_e += numbers1[i * columns + j] * numbers2[j];
+			}
+			dstv[i] = r_e;
+		}
+		return DenseVectorType(std::move(dstv));
+	}
+	// Vector * Matrix, and Matrix * Matrix row by row
+	const size_t rows = op1.columns() ? op1.size() : 1;
+	const size_t length = op1.columns() ? op1.columns() : op1.size();
+	if (length != op2.size()) return Value::undefined;
+	const size_t columns = op2.columns();
+	std::vector<double> dstv(rows * columns);
+	for (size_t row = 0; row < rows; row++) {
+		for (size_t i = 0; i < columns; i++) {
+			double r_e = 0.0;
+			for (size_t j = 0; j < length; j++) {
+				r_e += numbers1[row * length + j] * numbers2[j * columns + i];
+			}
+			dstv[row * columns + i] = r_e;
+		}
+	}
+	if (op1.columns()) return DenseVectorType(std::move(dstv), columns);
+	return DenseVectorType(std::move(dstv));
+}
+
 Value Value::operator*(const Value &v) const
 {
 	if (this->type() == ValueType::NUMBER && v.type() == ValueType::NUMBER) {
@@ -851,6 +1098,10 @@ Value Value::operator*(const Value &v) const
 		return multvecnum(v, *this);
 	}
 	else if (this->type() == ValueType::VECTOR && v.type() == ValueType::VECTOR) {
+		const DenseVectorType *dense1 = this->toDense();
+		const DenseVectorType *dense2 = v.toDense();
+		if (dense1 && dense2) return multdense(*dense1, *dense2);
+
 		const auto &vec1 = this->toVector();
 		const auto &vec2 = v.toVector();
 		if (vec1.size() == 0 || vec2.size() == 0) return Value::undefined;
@@ -893,6 +1144,10 @@ Value Value::operator/(const Value &v) const
     return {this->toDouble() / v.toDouble()};
   }
   else if (this->type() == ValueType::VECTOR && v.type() == ValueType::NUMBER) {
+    if (const DenseVectorType *dense = this->toDense()) {
+      const double number = v.toDouble();
+      return elementwise(*dense, [number](double x) { return x / number; });
+    }
     const auto &vec = this->toVector();
     VectorType dstv;
     for (const auto &vecval : vec) {
@@ -901,6 +1156,10 @@ Value Value::operator/(const Value &v) const
     return {dstv};
   }
   else if (this->type() == ValueType::NUMBER && v.type() == ValueType::VECTOR) {
+    if (const DenseVectorType *dense = v.toDense()) {
+      const double number = this->toDouble();
+      return elementwise(*dense, [number](double x) { return number / x; });
+    }
     const auto &vec = v.toVector();
     VectorType dstv;
     for (const auto &vecval : vec) {
@@ -925,6 +1184,9 @@ Value Value::operator-() const
     return {-this->toDouble()};
   }
   else if (this->type() == ValueType::VECTOR) {
+    if (const DenseVectorType *dense = this->toDense()) {
+      return elementwise(*dense, [](double x) { return -x; });
+    }
     const auto &vec = this->toVector();
     VectorType dstv;
     for (const auto &vecval : vec) {
@@ -979,6 +1241,12 @@ public:
     return Value::undefined;
   }
 
+  Value operator()(const DenseVectorType &vec, const double &idx) const {
+    const auto i = convert_to_uint32(idx);
+    if (i < vec.size()) return vec[i];
+    return Value::undefined;
+  }
+
   Value operator()(const RangeType &range, const double &idx) const {
     const auto i = convert_to_uint32(idx);
     switch(i) {
@@ -1109,6 +1377,51 @@ std::ostream& operator<<(std::ostream& stream, const FunctionType& f) {
 	return stream;
 }
 
+DenseVectorType::DenseVectorType(std::vector<double> &&numbers)
+	: numbers(std::make_shared<const std::vector<double>>(std::move(numbers))), first(0), count(this->numbers->size()), cols(0)
+{
+}
+
+DenseVectorType::DenseVectorType(std::vector<double> &&numbers, size_t columns)
+	: numbers(std::make_shared<const std::vector<double>>(std::move(numbers))), first(0), count(this->numbers->size()), cols(columns)
+{
+	assert(columns > 0 && this->count % columns == 0);
+}
+
+Value DenseVectorType::operator[](size_t i) const
+{
+	if (this->cols) return Value(row(i));
+	return Value(data()[i]);
+}
+
+DenseVectorType DenseVectorType::row(size_t i) const
+{
+	return DenseVectorType(this->numbers, this->first + i * this->cols, this->cols, 0);
+}
+
+bool DenseVectorType::operator==(const DenseVectorType &other) const
+{
+	return this->cols == other.cols && this->count == other.count &&
+		std::equal(data(), data() + this->count, other.data());
+}
+
+const Value::VectorType &DenseVectorType::elements() const
+{
+	auto elements = std::atomic_load(&this->boxed);
+	if (!elements) {
+		auto boxed = std::make_shared<Value::VectorType>();
+		boxed->reserve(size());
+		for (size_t i = 0; i < size(); i++) {
+			boxed->emplace_back((*this)[i]);
+		}
+		// Values are shared between threads; keep the first boxing if two race
+		shared_ptr<const Value::VectorType> expected;
+		elements = boxed;
+		if (!std::atomic_compare_exchange_strong(&this->boxed, &expected, elements)) elements = expected;
+	}
+	return *elements;
+}
+
 ValuePtr::ValuePtr()
 {
 	this->reset(new Value());
@@ -1164,6 +1477,11 @@ ValuePtr::ValuePtr(const FunctionType &v)
 	this->reset(new Value(v));
 }
 
+ValuePtr::ValuePtr(Value &&v)
+{
+	this->reset(new Value(std::move(v)));
+}
+
 bool ValuePtr::operator==(const ValuePtr &v) const
 {
 	return **this == *v;
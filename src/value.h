@@ -165,6 +165,7 @@ public:
   ValuePtr(const class std::vector<ValuePtr> &v);
   ValuePtr(const class RangeType &v);
   ValuePtr(const class FunctionType &v);
+  explicit ValuePtr(class Value &&v);
 
 	operator bool() const;
 
@@ -188,6 +189,55 @@ public:
 private:
 };
 
+/*!
+	A vector of numbers, or a matrix of numbers, i.e. a vector of vectors
+	of numbers which all have the same length, stored unboxed in one
+	contiguous array. Value stores vectors of this shape as a
+	DenseVectorType, see Value(const VectorType &).
+
+	A vector of N points thus needs one array of doubles instead of 4N
+	separately allocated Values, and arithmetic on it runs directly on the
+	array. The elements are only boxed into a VectorType when toVector()
+	asks for them, and kept from then on. Rows of a matrix share its
+	array.
+*/
+class DenseVectorType
+{
+public:
+	// A vector of numbers
+	explicit DenseVectorType(std::vector<double> &&numbers);
+	// A matrix with rows of the given number of columns
+	DenseVectorType(std::vector<double> &&numbers, size_t columns);
+
+	// Number of elements, i.e. numbers or rows
+	size_t size() const { return this->cols ? this->count / this->cols : this->count; }
+	// Zero for a vector of numbers
+	size_t columns() const { return this->cols; }
+	// All numbers, row by row for a matrix
+	const double *data() const { return this->numbers->data() + this->first; }
+	size_t dataSize() const { return this->count; }
+
+	// Element i, a number or a row
+	class Value operator[](size_t i) const;
+	DenseVectorType row(size_t i) const;
+
+	bool operator==(const DenseVectorType &other) const;
+	bool operator!=(const DenseVectorType &other) const { return !(*this == other); }
+
+	// The elements boxed as a VectorType, created on first use
+	const std::vector<ValuePtr> &elements() const;
+
+private:
+	DenseVectorType(const shared_ptr<const std::vector<double>> &numbers, size_t first, size_t count, size_t cols)
+		: numbers(numbers), first(first), count(count), cols(cols) {}
+
+	shared_ptr<const std::vector<double>> numbers;
+	size_t first;
+	size_t count;
+	size_t cols;
+	mutable shared_ptr<const std::vector<ValuePtr>> boxed;
+};
+
 class FunctionType {
 public:
 	FunctionType(std::shared_ptr<Context> ctx, std::shared_ptr<Expression> expr, AssignmentList args)
@@ -249,8 +299,12 @@ public:
   Value(const char *v);
   Value(const char v);
   Value(const VectorType &v);
+  Value(const DenseVectorType &v);
   Value(const RangeType &v);
   Value(const FunctionType &v);
+  // Keeps v boxed even if it could be stored dense, for temporary lists
+  // whose elements are spliced into another vector right away
+  static Value unpacked(const VectorType &v);
 
   ValueType type() const;
   bool isDefined() const;
@@ -271,6 +325,8 @@ public:
   void toStream(const tostream_visitor *visitor) const;
   std::string chrString() const;
   const VectorType &toVector() const;
+  // Vectors and matrices of numbers, without boxing their elements
+  const DenseVectorType *toDense() const;
   bool getVec2(double &x, double &y, bool ignoreInfinite = false) const;
   bool getVec3(double &x, double &y, double &z) const;
   bool getVec3(double &x, double &y, double &z, double defaultval) const;
@@ -298,12 +354,14 @@ public:
     return stream;
   }
 
-  typedef boost::variant< boost::blank, bool, double, str_utf8_wrapper, VectorType, RangeType, FunctionType> Variant;
+  // DenseVectorType comes last, as type() maps the other alternatives to ValueType by index
+  typedef boost::variant< boost::blank, bool, double, str_utf8_wrapper, VectorType, RangeType, FunctionType, DenseVectorType> Variant;
 
 private:
   static Value multvecnum(const Value &vecval, const Value &numval);
   static Value multmatvec(const VectorType &matrixvec, const VectorType &vectorvec);
   static Value multvecmat(const VectorType &vectorvec, const VectorType &matrixvec);
+  static Value multdense(const DenseVectorType &op1, const DenseVectorType &op2);
 
   Variant value;
 };
@@ -0,0 +1,234 @@
+#include "vertex-kernels.h"
+#include <atomic>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VERTEX_KERNELS_AVX2
+#include <immintrin.h>
+#endif
+
+static_assert(sizeof(Vector3d) == 3*sizeof(double), "Vector3d arrays must be contiguous doubles");
+static_assert(sizeof(Vector2d) == 2*sizeof(double), "Vector2d arrays must be contiguous doubles");
+static_assert(sizeof(Vector3l) == 3*sizeof(int64_t), "Vector3l arrays must be contiguous int64_ts");
+
+namespace VertexKernels {
+	namespace {
+		void transformScalar(Vector3d *vertices, size_t n, const Transform3d &mat)
+		{
+			for (size_t i = 0; i < n; i++) vertices[i] = mat * vertices[i];
+		}
+
+		void transformScalar(Vector2d *vertices, size_t n, const Transform2d &mat)
+		{
+			for (size_t i = 0; i < n; i++) vertices[i] = mat * vertices[i];
+		}
+
+		void gridKeysScalar(const double *in, size_t n, double resolution, int64_t *out)
+		{
+			for (size_t i = 0; i < n; i++) out[i] = int64_t(in[i] / resolution);
+		}
+
+#ifdef VERTEX_KERNELS_AVX2
+		/*
+			To give the same results as Eigen, the products are summed in the
+			same order as Eigen does, which depends on whether it vectorizes
+			fixed-size objects, i.e. whether EIGEN_DONT_ALIGN is defined.
+			FMA isn't used, since it rounds differently.
+		*/
+		__attribute__((target("avx2")))
+		inline __m256d dot(__m256d x, __m256d y, __m256d z, const Matrix4d &m, int row)
+		{
+			const __m256d px = _mm256_mul_pd(_mm256_set1_pd(m(row,0)), x);
+			const __m256d py = _mm256_mul_pd(_mm256_set1_pd(m(row,1)), y);
+			const __m256d pz = _mm256_mul_pd(_mm256_set1_pd(m(row,2)), z);
+			const __m256d t = _mm256_set1_pd(m(row,3));
+#if EIGEN_MAX_STATIC_ALIGN_BYTES > 0
+			return _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(px, py), pz), t);
+#else
+			return _mm256_add_pd(_mm256_add_pd(px, py), _mm256_add_pd(pz, t));
+#endif
+		}
+
+		__attribute__((target("avx2")))
+		inline __m256d load2(const double *lo, const double *hi)
+		{
+			return _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_loadu_pd(lo)), _mm_loadu_pd(hi), 1);
+		}
+
+		__attribute__((target("avx2")))
+		inline void store2(double *lo, double *hi, __m256d v)
+		{
+			_mm_storeu_pd(lo, _mm256_castpd256_pd128(v));
+			_mm_storeu_pd(hi, _mm256_extractf128_pd(v, 1));
+		}
+
+		__attribute__((target("avx2")))
+		void transformAVX2(Vector3d *vertices, size_t n, const Transform3d &mat)
+		{
+			const Matrix4d &m = mat.matrix();
+			double *v = vertices->data();
+			size_t i = 0;
+			// Four vertices at a time, rearranged from x0 y0 z0 x1 .. z3 into x0 x1 x2 x3 etc.
+			for (; i + 4 <= n; i += 4, v += 12) {
+				const __m256d a = load2(v, v + 6);     // x0 y0 x2 y2
+				const __m256d b = load2(v + 2, v + 8); // z0 x1 z2 x3
+				const __m256d c = load2(v + 4, v + 10); // y1 z1 y3 z3
+				const __m256d x = _mm256_blend_pd(a, b, 0xa);
+				const __m256d y = _mm256_shuffle_pd(a, c, 0x5);
+				const __m256d z = _mm256_blend_pd(b, c, 0xa);
+				const __m256d rx = dot(x, y, z, m, 0);
+				const __m256d ry = dot(x, y, z, m, 1);
+				const __m256d rz = dot(x, y, z, m, 2);
+				store2(v, v + 6, _mm256_shuffle_pd(rx, ry, 0x0));
+				store2(v + 2, v + 8, _mm256_blend_pd(rz, rx, 0xa));
+				store2(v + 4, v + 10, _mm256_shuffle_pd(ry, rz, 0xf));
+			}
+			if (i < n) transformScalar(vertices + i, n - i, mat);
+		}
+
+		__attribute__((target("avx2")))
+		void transformAVX2(Vector2d *vertices, size_t n, const Transform2d &mat)
+		{
+			const auto &m = mat.matrix();
+			const __m256d c0 = _mm256_setr_pd(m(0,0), m(1,0), m(0,0), m(1,0));
+			const __m256d c1 = _mm256_setr_pd(m(0,1), m(1,1), m(0,1), m(1,1));
+			const __m256d t = _mm256_setr_pd(m(0,2), m(1,2), m(0,2), m(1,2));
+			double *v = vertices->data();
+			size_t i = 0;
+			// Two vertices at a time: [x0 y0 x1 y1]
+			for (; i + 2 <= n; i += 2, v += 4) {
+				const __m256d p = _mm256_loadu_pd(v);
+				const __m256d x = _mm256_mul_pd(c0, _mm256_unpacklo_pd(p, p));
+				const __m256d y = _mm256_mul_pd(c1, _mm256_unpackhi_pd(p, p));
+#if EIGEN_MAX_STATIC_ALIGN_BYTES > 0
+				_mm256_storeu_pd(v, _mm256_add_pd(_mm256_add_pd(x, y), t));
+#else
+				_mm256_storeu_pd(v, _mm256_add_pd(x, _mm256_add_pd(y, t)));
+#endif
+			}
+			if (i < n) transformScalar(vertices + i, n - i, mat);
+		}
+
+		__attribute__((target("avx2")))
+		void gridKeysAVX2(const double *in, size_t n, double resolution, int64_t *out)
+		{
+			const __m256d res = _mm256_set1_pd(resolution);
+			const __m256d sign = _mm256_set1_pd(-0.0);
+			/*
+				AVX2 can't convert doubles to 64 bit integers. Integral doubles with
+				magnitude below 2^51 are converted by adding 1.5*2^52, which makes
+				the integer the low bits of the mantissa. Others are left to the
+				scalar code.
+			*/
+			const __m256d limit = _mm256_set1_pd(2251799813685248.0); // 2^51
+			const __m256d magic = _mm256_set1_pd(6755399441055744.0); // 1.5*2^52
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				const __m256d q = _mm256_round_pd(_mm256_div_pd(_mm256_loadu_pd(in + i), res), _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+				const __m256d inrange = _mm256_cmp_pd(_mm256_andnot_pd(sign, q), limit, _CMP_LT_OQ);
+				if (_mm256_movemask_pd(inrange) == 0xf) {
+					const __m256i bits = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(q, magic)), _mm256_castpd_si256(magic));
+					_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), bits);
+				}
+				else {
+					gridKeysScalar(in + i, 4, resolution, out + i);
+				}
+			}
+			gridKeysScalar(in + i, n - i, resolution, out + i);
+		}
+
+		bool supportsAVX2()
+		{
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+		}
+
+		/*
+			Guards against Eigen summing in a different order than expected, in
+			which case the vectorized transformations would give slightly
+			different results.
+		*/
+		bool matchesScalar()
+		{
+			Transform3d m3;
+			Transform2d m2;
+			for (int i = 0; i < 12; i++) m3.matrix()(i % 3, i / 3) = std::sin(i + 1.0) * (i + 0.7);
+			for (int i = 0; i < 6; i++) m2.matrix()(i % 2, i / 2) = std::cos(i + 1.0) * (i + 0.3);
+			Vector3d a3[32], b3[32];
+			Vector2d a2[32], b2[32];
+			for (int i = 0; i < 32; i++) {
+				a3[i] = b3[i] = Vector3d(std::sin(i * 0.37) * 97.1, std::cos(i * 1.3) * 13.7, i / 3.0);
+				a2[i] = b2[i] = Vector2d(std::cos(i * 0.53) * 71.3, i / 7.0);
+			}
+			transformScalar(a3, 32, m3);
+			transformAVX2(b3, 32, m3);
+			transformScalar(a2, 32, m2);
+			transformAVX2(b2, 32, m2);
+			for (int i = 0; i < 32; i++) {
+				if (a3[i] != b3[i] || a2[i] != b2[i]) return false;
+			}
+			return true;
+		}
+#else
+		bool supportsAVX2() { return false; }
+#endif
+
+		Implementation detect()
+		{
+#ifdef VERTEX_KERNELS_AVX2
+			if (supportsAVX2() && matchesScalar()) return Implementation::AVX2;
+#endif
+			return Implementation::SCALAR;
+		}
+
+		std::atomic<Implementation> &current()
+		{
+			static std::atomic<Implementation> impl(detect());
+			return impl;
+		}
+	}
+
+	Implementation implementation()
+	{
+		return current();
+	}
+
+	const char *implementationName(Implementation impl)
+	{
+		return impl == Implementation::AVX2 ? "avx2" : "scalar";
+	}
+
+	bool setImplementation(Implementation impl)
+	{
+		if (impl == Implementation::AVX2 && !supportsAVX2()) return false;
+		current() = impl;
+		return true;
+	}
+
+	void transform(Vector3d *vertices, size_t n, const Transform3d &mat)
+	{
+		if (n == 0) return;
+#ifdef VERTEX_KERNELS_AVX2
+		if (current() == Implementation::AVX2) return transformAVX2(vertices, n, mat);
+#endif
+		transformScalar(vertices, n, mat);
+	}
+
+	void transform(Vector2d *vertices, size_t n, const Transform2d &mat)
+	{
+		if (n == 0) return;
+#ifdef VERTEX_KERNELS_AVX2
+		if (current() == Implementation::AVX2) return transformAVX2(vertices, n, mat);
+#endif
+		transformScalar(vertices, n, mat);
+	}
+
+	void gridKeys(const Vector3d *vertices, size_t n, double resolution, Vector3l *keys)
+	{
+		if (n == 0) return;
+#ifdef VERTEX_KERNELS_AVX2
+		if (current() == Implementation::AVX2) return gridKeysAVX2(vertices->data(), 3*n, resolution, keys->data());
+#endif
+		gridKeysScalar(vertices->data(), 3*n, resolution, keys->data());
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "linalg.h"
+#include "hash.h"
+#include <cstddef>
+
+/*!
+	Batched operations on contiguous vertex arrays, used by PolySet and
+	Polygon2d.
+
+	On x86 CPUs supporting AVX2, vectorized implementations are used. They
+	give bit-identical results to the scalar implementations, so output
+	doesn't depend on the machine it was created on. The implementation is
+	chosen once, at first use.
+*/
+namespace VertexKernels {
+	enum class Implementation { SCALAR, AVX2 };
+
+	Implementation implementation();
+	const char *implementationName(Implementation impl);
+	// Returns false if impl isn't supported by this CPU. Meant for benchmarks and tests.
+	bool setImplementation(Implementation impl);
+
+	// Applies mat to n vertices in place
+	void transform(Vector3d *vertices, size_t n, const Transform3d &mat);
+	void transform(Vector2d *vertices, size_t n, const Transform2d &mat);
+	// Computes the key of each vertex in a grid of the given resolution, see Grid3d
+	void gridKeys(const Vector3d *vertices, size_t n, double resolution, Vector3l *keys);
+}
@@ -0,0 +1,185 @@
+/*
+ *  OpenSCAD (www.openscad.org)
+ *  Copyright (C) 2009-2011 Clifford Wolf <clifford@clifford.at> and
+ *                          Marius Kintel <marius@kintel.net>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  As a special exception, you have permission to link this program
+ *  with the CGAL library and distribute executables, as long as you
+ *  follow the requirements of the GNU GPL in regard to all of the
+ *  software in the executable aside from CGAL.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+/*
+	Stress test for ShardedCache, which backs GeometryCache and CGALCache.
+	Several threads insert, look up and evict concurrently; afterwards the
+	cost accounting and statistics must be consistent, and every object
+	returned must belong to the key it was looked up with.
+*/
+
+#include "ShardedCache.h"
+#include "unittest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+	struct Entry {
+		Entry() : key(-1) {}
+		Entry(int key) : key(key), payload(std::to_string(key)) {}
+		int key;
+		std::string payload;
+	};
+
+	typedef ShardedCache<int, Entry> TestCache;
+
+	const size_t COST = 10;
+
+	void concurrentAccess(CacheEvictionPolicy policy)
+	{
+		const int numThreads = 8;
+		const int numKeys = 20000;
+		TestCache cache(500*COST);
+		cache.setEvictionPolicy(policy);
+
+		std::atomic<size_t> lookups(0), corrupt(0), overLimit(0);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < numThreads; ++t) {
+			threads.emplace_back([&, t]() {
+				for (int i = 0; i < numKeys; ++i) {
+					// Keys are unique per thread, so no insert replaces an entry
+					const int key = t*numKeys + i;
+					cache.insert(key, new Entry(key), COST, (key % 7)*0.1);
+					// Look up recent keys of this and other threads, some of which are evicted
+					for (int j = 0; j < 3; ++j) {
+						const int other = ((t + j) % numThreads)*numKeys + i/2;
+						Entry entry;
+						lookups++;
+						if (cache.get(other, entry) && (entry.key != other || entry.payload != std::to_string(other))) corrupt++;
+					}
+					if (cache.totalCost() > cache.maxCost() + numThreads*COST) overLimit++;
+				}
+			});
+		}
+		for (auto &thread : threads) thread.join();
+		// Existence checks aren't lookups
+		cache.contains(0);
+		cache.contains(-1);
+
+		const auto stats = cache.statistics();
+		check(corrupt == 0, "objects match their keys");
+		check(overLimit == 0, "cost stays near the limit while inserting");
+		check(cache.totalCost() <= cache.maxCost(), "cost within limit");
+		check(cache.totalCost() == cache.size()*COST, "cost matches entries");
+		check(stats.bytes == cache.totalCost() && stats.entries == cache.size(), "statistics match cache");
+		check(stats.inserts == size_t(numThreads)*numKeys, "all inserts counted");
+		check(stats.hits + stats.misses == lookups, "all lookups counted");
+		check(stats.inserts - stats.evictions == stats.entries, "evictions counted");
+
+		cache.clear();
+		check(cache.size() == 0 && cache.totalCost() == 0, "clear");
+	}
+
+	// Eviction must pick the globally least recently used entry, regardless of shards
+	void globalLeastRecentlyUsed()
+	{
+		TestCache cache(10*COST);
+		for (int key = 0; key < 20; ++key) cache.insert(key, new Entry(key), COST);
+		bool ok = true;
+		for (int key = 0; key < 20; ++key) ok &= cache.contains(key) == (key >= 10);
+		check(ok, "least recently used entries evicted across shards");
+
+		// Accessing an entry protects it from eviction
+		Entry entry;
+		cache.get(10, entry);
+		cache.insert(20, new Entry(20), COST);
+		check(cache.contains(10) && !cache.contains(11), "access updates recency across shards");
+	}
+
+	// Expensive entries must survive cheap ones, even when inserted earlier and into other shards
+	void globalCostAware()
+	{
+		TestCache cache(10*COST);
+		cache.setEvictionPolicy(CacheEvictionPolicy::CostAware);
+		for (int key = 0; key < 10; ++key) cache.insert(key, new Entry(key), COST, 100);
+		for (int key = 10; key < 40; ++key) cache.insert(key, new Entry(key), COST, 1);
+		bool ok = true;
+		for (int key = 0; key < 10; ++key) ok &= cache.contains(key);
+		check(ok, "expensive entries kept across shards");
+		check(cache.size() == 10, "cost-aware eviction keeps the limit");
+	}
+
+	// Returns the order in which the entries 0..4, weighted 5,1,4,2,3, are evicted by expensive new entries
+	std::vector<int> evictionOrder(CacheEvictionPolicy policy)
+	{
+		Cache<int, Entry> cache(5*COST);
+		cache.setEvictionPolicy(policy);
+		const double weights[] = {5, 1, 4, 2, 3};
+		for (int key = 0; key < 5; ++key) cache.insert(key, new Entry(key), COST, weights[key]);
+		std::vector<int> order;
+		for (int key = 5; key < 10; ++key) {
+			cache.insert(key, new Entry(key), COST, 1000);
+			for (int old = 0; old < 5; ++old) {
+				if (!cache.contains(old) && std::find(order.begin(), order.end(), old) == order.end()) order.push_back(old);
+			}
+		}
+		return order;
+	}
+
+	// Cost-aware eviction takes the cheapest entries first instead of the oldest ones
+	void costAwareEvictionOrder()
+	{
+		check(evictionOrder(CacheEvictionPolicy::LeastRecentlyUsed) == std::vector<int>({0, 1, 2, 3, 4}),
+					"least recently used entries evicted first");
+		check(evictionOrder(CacheEvictionPolicy::CostAware) == std::vector<int>({1, 3, 4, 2, 0}),
+					"cheapest entries evicted first");
+	}
+
+	void shrinkWhileInserting()
+	{
+		TestCache cache(1000*COST);
+		std::atomic<bool> done(false);
+		std::thread inserter([&]() {
+			for (int key = 0; key < 50000; ++key) cache.insert(key, new Entry(key), COST);
+			done = true;
+		});
+		size_t limit = 1000;
+		while (!done) {
+			limit = limit > 10 ? limit - 1 : 1000;
+			cache.setMaxCost(limit*COST);
+		}
+		inserter.join();
+		cache.setMaxCost(100*COST);
+		check(cache.totalCost() <= 100*COST, "cost within shrunk limit");
+		check(cache.totalCost() == cache.size()*COST, "cost matches entries after shrinking");
+	}
+}
+
+int main()
+{
+	concurrentAccess(CacheEvictionPolicy::LeastRecentlyUsed);
+	concurrentAccess(CacheEvictionPolicy::CostAware);
+	globalLeastRecentlyUsed();
+	globalCostAware();
+	costAwareEvictionOrder();
+	shrinkWhileInserting();
+
+	return unittestResult();
+}
@@ -0,0 +1,112 @@
+/*
+	Unit tests for CSGTreeNormalizer.
+*/
+
+#include "CSGTreeNormalizer.h"
+#include "csgnode.h"
+#include "polyset.h"
+#include "progress.h"
+#include "unittest.h"
+
+#include <string>
+
+// The normalizer lets the progress callback cancel it, which isn't used here
+void progress_check() {}
+
+namespace {
+	int leafIndex = 0;
+
+	// A leaf whose bounding box spans from min to max
+	shared_ptr<CSGNode> box(const std::string &label, const Vector3d &min, const Vector3d &max)
+	{
+		auto ps = std::make_shared<PolySet>(3);
+		ps->append_poly();
+		ps->append_vertex(0, 0, 0);
+		ps->append_vertex(1, 0, 0);
+		ps->append_vertex(1, 1, 1);
+		const Transform3d matrix(Eigen::Translation3d(min) * Eigen::Scaling(Vector3d(max - min)));
+		return shared_ptr<CSGNode>(new CSGLeaf(ps, matrix, Color4f(), label, leafIndex++));
+	}
+
+	shared_ptr<CSGNode> op(OpenSCADOperator type, const shared_ptr<CSGNode> &left, const shared_ptr<CSGNode> &right)
+	{
+		return CSGOperation::createCSGNode(type, left, right);
+	}
+
+	std::string products(const shared_ptr<CSGNode> &term)
+	{
+		if (!term) return "";
+		CSGProducts products;
+		products.import(term);
+		return products.dump();
+	}
+
+	/*
+		a * (b + c), where the bounding box of b + c spans both b and c, but c
+		doesn't touch a. Distributing it into a * b shrinks the bounding box,
+		so subtrahends and intersection operands overlapping the original term
+		may be disjoint from the normalized one. These can't be pruned when the
+		tree is built, only while normalizing.
+	*/
+	shared_ptr<CSGNode> distributedIntersection()
+	{
+		return op(OpenSCADOperator::INTERSECTION,
+							box("a", {0, 0, 0}, {10, 2, 1}),
+							op(OpenSCADOperator::UNION, box("b", {0, 0, 0}, {2, 2, 1}), box("c", {8, 8, 0}, {10, 10, 1})));
+	}
+
+	void testDisjointSubtrahend()
+	{
+		const auto tree = op(OpenSCADOperator::DIFFERENCE, distributedIntersection(), box("d", {5, 0, 0}, {6, 1, 1}));
+		check(dynamic_pointer_cast<CSGOperation>(tree) != nullptr, "subtrahend overlaps the term before normalization");
+		CSGTreeNormalizer normalizer(100);
+		check(products(normalizer.normalize(tree)) == "+a *b\n", "subtrahend disjoint after normalization is pruned");
+	}
+
+	void testOverlappingSubtrahend()
+	{
+		const auto tree = op(OpenSCADOperator::DIFFERENCE, distributedIntersection(), box("d", {1, 0, 0}, {3, 1, 1}));
+		CSGTreeNormalizer normalizer(100);
+		check(products(normalizer.normalize(tree)) == "+a *b -d\n", "overlapping subtrahend is kept");
+	}
+
+	void testDisjointIntersection()
+	{
+		const auto tree = op(OpenSCADOperator::INTERSECTION, distributedIntersection(), box("d", {5, 0, 0}, {6, 1, 1}));
+		check(dynamic_pointer_cast<CSGOperation>(tree) != nullptr, "operand overlaps the term before normalization");
+		CSGTreeNormalizer normalizer(100);
+		check(normalizer.normalize(tree) == nullptr, "intersection disjoint after normalization is pruned entirely");
+	}
+
+	/*
+		Pruned nodes no longer count towards the normalization limit. n pruned
+		intersections come first, so the limit is reached while normalizing the
+		n products after them, which need about 2 * n nodes. Each pruned
+		intersection also drops its normalized left operand a * b, which must
+		be subtracted as well.
+	*/
+	void testPrunedNodesDontCount()
+	{
+		const int n = 20;
+		shared_ptr<CSGNode> pruned, kept;
+		for (int i = 0; i < n; i++) {
+			const auto term = op(OpenSCADOperator::INTERSECTION, distributedIntersection(), box("d", {5, 0, 0}, {6, 1, 1}));
+			pruned = pruned ? op(OpenSCADOperator::UNION, pruned, term) : term;
+			kept = kept ? op(OpenSCADOperator::UNION, kept, distributedIntersection()) : distributedIntersection();
+		}
+		CSGTreeNormalizer normalizer(2 * n + n / 2);
+		std::string expected;
+		for (int i = 0; i < n; i++) expected += "+a *b\n";
+		check(products(normalizer.normalize(op(OpenSCADOperator::UNION, pruned, kept))) == expected,
+					"pruned nodes don't count towards the limit");
+	}
+}
+
+int main()
+{
+	testDisjointSubtrahend();
+	testOverlappingSubtrahend();
+	testDisjointIntersection();
+	testPrunedNodesDontCount();
+	return unittestResult();
+}
@@ -0,0 +1,62 @@
+#!/usr/bin/env python
+
+# Disk cache test
+#
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] file.png
+#
+#
+# step 1. Create a temporary, empty cache directory
+# step 2. Run OpenSCAD on the input file with that cache directory, which populates the cache
+# step 3. Run OpenSCAD again with the same cache directory, reading geometry back from it,
+#         and export to the given .png file
+# step 4. (done in CTest) - compare the generated .png file to expected output
+#         of the original .scad file. they should be the same!
+#
+# All the optional openscad args are passed on to OpenSCAD in step 2 and 3.
+# The cache directory is removed afterwards, so every test run starts with a cold cache.
+#
+# This script should return 0 on success, not-0 on error.
+
+from __future__ import print_function
+
+import sys, os, shutil, subprocess, tempfile, argparse
+
+def failquit(*args):
+    if len(args)!=0: print(args)
+    print('diskcache_pngtest args:',str(sys.argv))
+    print('exiting diskcache_pngtest.py with failure')
+    sys.exit(1)
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable')
+args,remaining_args = parser.parse_known_args()
+
+inputfile = remaining_args[0]
+pngfile = remaining_args[-1]
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit('cant find input file named: ' + inputfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+
+cachedir = tempfile.mkdtemp(prefix='openscad-diskcache-')
+try:
+    cacheargs = ['--cache-dir=' + cachedir] + remaining_args
+
+    populate_cmd = [args.openscad, inputfile, '-o', os.path.join(cachedir, 'populate.png')] + cacheargs
+    print('Running OpenSCAD #1:', file=sys.stderr)
+    print(' '.join(populate_cmd), file=sys.stderr)
+    result = subprocess.call(populate_cmd)
+    if result != 0:
+        failquit('OpenSCAD #1 failed with return code ' + str(result))
+
+    create_png_cmd = [args.openscad, inputfile, '-o', pngfile] + cacheargs
+    print('Running OpenSCAD #2:', file=sys.stderr)
+    print(' '.join(create_png_cmd), file=sys.stderr)
+    result = subprocess.call(create_png_cmd)
+    if result != 0:
+        failquit('OpenSCAD #2 failed with return code ' + str(result))
+finally:
+    shutil.rmtree(cachedir, ignore_errors=True)
@@ -0,0 +1,95 @@
+#!/usr/bin/env python
+
+# Peak memory regression test
+#
+# Renders the given file twice, with a small and a large number of objects set
+# through an OpenSCAD variable, and checks how peak memory usage reported in the
+# --summary-file output grows between them. The model's result grows linearly
+# with the number of objects, and so should its memory usage if consumed
+# children are released. Keeping them, or the intermediate results, alive
+# makes it grow faster.
+#
+# Both runs are compared to a trivial model on the same machine, which cancels
+# out the memory used by OpenSCAD itself, so no reference values are needed.
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> --parameter=<variable> --small=<n> --large=<n> [--margin=<percent>] [openscad args]
+#
+#
+# This script should return 0 on success, not-0 on error.
+#
+
+import sys, os, json, subprocess, argparse, tempfile, shutil
+
+def failquit(*args):
+    if len(args)!=0: print(args)
+    print('peakmemorytest args:',str(sys.argv))
+    print('exiting peakmemorytest.py with failure')
+    sys.exit(1)
+
+def peak_memory(scadfile, outputdir, extra_args):
+    summaryfile = os.path.join(outputdir, 'summary.json')
+    outputfile = os.path.join(outputdir, 'output.stl')
+    cmd = [args.openscad, scadfile, '-o', outputfile, '--summary-file=' + summaryfile] + extra_args
+    print('Running OpenSCAD:')
+    print(' '.join(cmd))
+    result = subprocess.call(cmd)
+    if result != 0:
+        failquit('OpenSCAD failed with return code ' + str(result))
+    try:
+        with open(summaryfile) as f:
+            return json.load(f)['peak_memory_bytes']
+    except:
+        failquit('failure while reading ' + summaryfile + ': ' + str(sys.exc_info()))
+
+#
+# Parse arguments
+#
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable')
+parser.add_argument('--parameter', required=True, help='OpenSCAD variable setting the number of objects')
+parser.add_argument('--small', required=True, type=int, help='Number of objects in the small run')
+parser.add_argument('--large', required=True, type=int, help='Number of objects in the large run')
+parser.add_argument('--margin', type=float, default=50, help='Allowed growth over linear in percent')
+args,remaining_args = parser.parse_known_args()
+
+inputfile = remaining_args[0]
+remaining_args = remaining_args[1:]    # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit('cant find input file named: ' + inputfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+if args.small <= 0 or args.large <= args.small:
+    failquit('expected 0 < small < large')
+
+def count_args(n):
+    return ['-D', '%s=%d' % (args.parameter, n)] + remaining_args
+
+outputdir = tempfile.mkdtemp()
+try:
+    baselinefile = os.path.join(outputdir, 'baseline.scad')
+    with open(baselinefile, 'w') as f:
+        f.write('cube(1);' + os.linesep)
+    baseline = peak_memory(baselinefile, outputdir, remaining_args)
+    small = peak_memory(inputfile, outputdir, count_args(args.small))
+    large = peak_memory(inputfile, outputdir, count_args(args.large))
+finally:
+    shutil.rmtree(outputdir, ignore_errors=True)
+
+if baseline == 0 or small == 0 or large == 0:
+    print('Peak memory usage not available on this platform, skipping')
+    sys.exit(0)
+
+def mb(bytes):
+    return bytes / (1024.0 * 1024.0)
+
+small_mb = max(mb(small - baseline), 1.0)
+large_mb = mb(large - baseline)
+print('Peak memory: trivial model %.1f MB, additional for %d objects: %.1f MB, for %d objects: %.1f MB' %
+      (mb(baseline), args.small, mb(small - baseline), args.large, large_mb))
+
+# Differences of less than 1 MB are noise, so the small run counts as at least 1 MB
+max_mb = small_mb * args.large / args.small * (1 + args.margin / 100.0)
+print('Limit for %d objects with %.0f%% margin over linear growth: %.1f MB' % (args.large, args.margin, max_mb))
+if large_mb > max_mb:
+    failquit('Peak memory usage grows faster than the number of objects')
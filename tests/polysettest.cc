@@ -0,0 +1,69 @@
+/*
+	Unit tests for PolySet's indexed mesh operations.
+*/
+
+#include "polyset.h"
+#include "unittest.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+	std::vector<std::vector<int>> polygonIndices(const PolySet &ps)
+	{
+		std::vector<std::vector<int>> polygons;
+		const auto &indices = ps.getIndices();
+		const auto &offsets = ps.getOffsets();
+		for (size_t i = 0; i < ps.numFacets(); i++) {
+			polygons.emplace_back(indices.begin() + offsets[i], indices.begin() + offsets[i + 1]);
+		}
+		return polygons;
+	}
+
+	// Vertices merged by quantizing must be remapped once, also across polygon boundaries
+	void testQuantizeMergedVertices()
+	{
+		PolySet ps(3);
+		const std::vector<Vector3d> vertices = {
+			{0, 0, 0}, {0, 0, 1e-9}, {1, 0, 0}, {1, 1, 0}, {2, 0, 0}, {3, 0, 0}, {3, 1, 0}
+		};
+		for (const auto &v : vertices) ps.add_vertex(v);
+		for (const auto &polygon : std::vector<std::vector<int>>{{0, 1, 2, 3}, {6, 5, 4}}) {
+			ps.append_poly();
+			for (int index : polygon) ps.append_index(index);
+		}
+		ps.quantizeVertices();
+
+		check(ps.getVertices().size() == 6, "quantizing merges the two close vertices");
+		const auto polygons = polygonIndices(ps);
+		check(polygons.size() == 2, "quantizing keeps both polygons");
+		if (polygons.size() == 2) {
+			check(polygons[0] == std::vector<int>({0, 1, 2}), "first polygon loses its duplicate vertex");
+			check(polygons[1] == std::vector<int>({5, 4, 3}), "second polygon is remapped once");
+		}
+	}
+
+	// Polygons collapsing to less than three vertices are removed
+	void testQuantizeCollapsedPolygon()
+	{
+		PolySet ps(3);
+		const std::vector<Vector3d> vertices = {{0, 0, 0}, {0, 0, 1e-9}, {1, 0, 0}, {2, 0, 0}, {2, 1, 0}};
+		for (const auto &v : vertices) ps.add_vertex(v);
+		for (const auto &polygon : std::vector<std::vector<int>>{{0, 1, 2}, {2, 3, 4}}) {
+			ps.append_poly();
+			for (int index : polygon) ps.append_index(index);
+		}
+		ps.quantizeVertices();
+
+		const auto polygons = polygonIndices(ps);
+		check(polygons.size() == 1, "collapsed polygon is removed");
+		if (polygons.size() == 1) check(polygons[0] == std::vector<int>({1, 2, 3}), "remaining polygon is remapped");
+	}
+}
+
+int main()
+{
+	testQuantizeMergedVertices();
+	testQuantizeCollapsedPolygon();
+	return unittestResult();
+}
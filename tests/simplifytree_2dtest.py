@@ -0,0 +1,65 @@
+#!/usr/bin/env python
+
+# Simplify-tree 2D test
+#
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>]
+#
+#
+# step 1. Run OpenSCAD on the input file and export it to SVG
+# step 2. Run OpenSCAD again with --enable=simplify-tree and export it to SVG
+# step 3. Compare the coordinates in both files, which must match up to rounding
+#
+# Simplifying the node tree folds nested transformations, which must not
+# change the result. 2D objects are the subtle case, since they only use the
+# xy part of each matrix. All the optional openscad args are passed on to OpenSCAD.
+#
+# This script should return 0 on success, not-0 on error.
+
+from __future__ import print_function
+
+import sys, os, re, shutil, subprocess, tempfile, argparse
+
+def failquit(*args):
+    if len(args)!=0: print(args)
+    print('simplifytree_2dtest args:',str(sys.argv))
+    print('exiting simplifytree_2dtest.py with failure')
+    sys.exit(1)
+
+def export_svg(svgfile, extra_args):
+    cmd = [args.openscad, inputfile, '-o', svgfile] + extra_args + remaining_args
+    print('Running OpenSCAD:')
+    print(' '.join(cmd))
+    result = subprocess.call(cmd)
+    if result != 0:
+        failquit('OpenSCAD failed with return code ' + str(result))
+    try:
+        with open(svgfile) as f:
+            return [float(n) for n in re.findall(r'-?\d+(?:\.\d+)?(?:[eE][-+]?\d+)?', f.read())]
+    except:
+        failquit('failure while reading ' + svgfile + ': ' + str(sys.exc_info()))
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable')
+args,remaining_args = parser.parse_known_args()
+
+inputfile = remaining_args[0]
+remaining_args = remaining_args[1:]    # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit('cant find input file named: ' + inputfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+
+outputdir = tempfile.mkdtemp()
+try:
+    expected = export_svg(os.path.join(outputdir, 'expected.svg'), [])
+    actual = export_svg(os.path.join(outputdir, 'simplified.svg'), ['--enable=simplify-tree'])
+finally:
+    shutil.rmtree(outputdir, ignore_errors=True)
+
+if len(expected) != len(actual):
+    failquit('simplified tree gives %d coordinates instead of %d' % (len(actual), len(expected)))
+for e, a in zip(expected, actual):
+    if abs(e - a) > 1e-6 * max(1.0, abs(e)):
+        failquit('simplified tree gives %g instead of %g' % (a, e))
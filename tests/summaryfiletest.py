@@ -0,0 +1,76 @@
+#!/usr/bin/env python
+
+# Summary file test
+#
+# Renders the given file with --summary-file and checks that the summary is
+# valid JSON with all documented keys, and that the geometry statistics
+# match the expected volume.
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> --volume=<expected volume> [openscad args]
+#
+#
+# This script should return 0 on success, not-0 on error.
+#
+
+import sys, os, json, subprocess, argparse, tempfile, shutil
+
+def failquit(*args):
+    if len(args)!=0: print(args)
+    print('summaryfiletest args:',str(sys.argv))
+    print('exiting summaryfiletest.py with failure')
+    sys.exit(1)
+
+def check_keys(obj, keys, where):
+    if not isinstance(obj, dict):
+        failquit(where + ' is not an object')
+    for key in keys:
+        if key not in obj:
+            failquit('missing key ' + where + '.' + key)
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable')
+parser.add_argument('--volume', required=True, type=float, help='Expected volume of the result')
+args,remaining_args = parser.parse_known_args()
+
+inputfile = remaining_args[0]
+remaining_args = remaining_args[1:]    # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit('cant find input file named: ' + inputfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+
+outputdir = tempfile.mkdtemp()
+try:
+    summaryfile = os.path.join(outputdir, 'summary.json')
+    outputfile = os.path.join(outputdir, 'output.stl')
+    cmd = [args.openscad, inputfile, '-o', outputfile, '--summary-file=' + summaryfile] + remaining_args
+    print('Running OpenSCAD:')
+    print(' '.join(cmd))
+    result = subprocess.call(cmd)
+    if result != 0:
+        failquit('OpenSCAD failed with return code ' + str(result))
+    try:
+        with open(summaryfile) as f:
+            summary = json.load(f)
+    except:
+        failquit('failure while reading ' + summaryfile + ': ' + str(sys.exc_info()))
+finally:
+    shutil.rmtree(outputdir, ignore_errors=True)
+
+check_keys(summary, ['time_ms', 'peak_memory_bytes', 'cache', 'operators', 'geometry'], 'summary')
+cache_keys = ['hits', 'misses', 'inserts', 'evictions', 'entries', 'bytes', 'limit']
+check_keys(summary['cache'], ['geometry', 'function', 'cgal', 'decomposition', 'disk'], 'cache')
+for name in ['geometry', 'function', 'cgal', 'decomposition']:
+    check_keys(summary['cache'][name], cache_keys, 'cache.' + name)
+check_keys(summary['cache']['disk'], ['enabled', 'hits', 'misses'], 'cache.disk')
+for name, timing in summary['operators'].items():
+    check_keys(timing, ['count', 'time_ms'], 'operators.' + name)
+check_keys(summary['geometry'], ['dimension', 'objects', 'facets', 'vertices', 'volume', 'area'], 'geometry')
+
+geometry = summary['geometry']
+if geometry['dimension'] != 3 or geometry['objects'] != 1:
+    failquit('expected a single 3D object, got: ' + str(geometry))
+if geometry['volume'] is None or abs(geometry['volume'] - args.volume) > 1e-6 * max(1.0, args.volume):
+    failquit('expected volume %g, got %s' % (args.volume, geometry['volume']))
+print('Summary file is complete')
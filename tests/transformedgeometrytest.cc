@@ -0,0 +1,142 @@
+/*
+	Unit tests for geometry with lazily applied transformations.
+*/
+
+#include "TransformedGeometry.h"
+#include "polyset.h"
+#include "Polygon2d.h"
+#include "printutils.h"
+#include "unittest.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+	bool near(const Vector2d &v1, const Vector2d &v2) { return (v1 - v2).norm() < 1e-9; }
+	bool near(const Vector3d &v1, const Vector3d &v2) { return (v1 - v2).norm() < 1e-9; }
+
+	Transform3d translation(const Vector3d &v) { return Transform3d(Eigen::Translation3d(v)); }
+	Transform3d scaling(const Vector3d &v) { return Transform3d(Eigen::Scaling(v)); }
+
+	double signedArea(const Outline2d &outline)
+	{
+		double area = 0;
+		const auto &v = outline.vertices;
+		for (size_t i = 0; i < v.size(); i++) {
+			const auto &next = v[(i + 1) % v.size()];
+			area += v[i][0] * next[1] - next[0] * v[i][1];
+		}
+		return area / 2;
+	}
+
+	shared_ptr<const Polygon2d> unitSquare()
+	{
+		auto poly = std::make_shared<Polygon2d>();
+		Outline2d outline;
+		outline.vertices = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+		poly->addOutline(outline);
+		poly->setSanitized(true);
+		return poly;
+	}
+
+	shared_ptr<const PolySet> triangle()
+	{
+		auto ps = std::make_shared<PolySet>(3);
+		ps->append_poly();
+		ps->append_vertex(0, 0, 0);
+		ps->append_vertex(1, 0, 0);
+		ps->append_vertex(0, 1, 0);
+		return ps;
+	}
+
+	// Nested transformations collapse into one, applied in the order of the tree
+	void testNested3D()
+	{
+		const auto ps = triangle();
+		const auto inner = std::make_shared<TransformedGeometry>(ps, translation({1, 2, 3}));
+		const TransformedGeometry outer(inner, scaling({2, 2, 2}));
+		check(outer.getGeometry() == ps, "nested 3D transformations share the untransformed geometry");
+
+		const auto flat = dynamic_pointer_cast<const PolySet>(outer.flatten());
+		check(flat && flat->getVertices().size() == 3, "flattened 3D geometry is a PolySet");
+		if (flat && flat->getVertices().size() == 3) {
+			check(near(flat->getVertices()[0], {2, 4, 6}), "3D transformations apply inner first");
+			check(near(flat->getVertices()[1], {4, 4, 6}), "3D transformations apply to all vertices");
+		}
+		check(ps->getVertices()[0] == Vector3d(0, 0, 0), "flattening leaves the shared geometry untouched");
+	}
+
+	// 2D geometry ignores the z parts of the matrices, also when nested
+	void testNested2D()
+	{
+		const auto poly = unitSquare();
+		const auto inner = std::make_shared<TransformedGeometry>(poly, translation({1, 2, 5}));
+		const TransformedGeometry outer(inner, scaling({3, 3, 7}));
+		check(outer.getGeometry() == poly, "nested 2D transformations share the untransformed geometry");
+
+		const auto flat = dynamic_pointer_cast<const Polygon2d>(outer.flatten());
+		check(flat && flat->outlines().size() == 1, "flattened 2D geometry is a Polygon2d");
+		if (flat && flat->outlines().size() == 1) {
+			check(near(flat->outlines()[0].vertices[0], {3, 6}), "2D transformations apply inner first");
+			check(near(flat->outlines()[0].vertices[2], {6, 9}), "2D transformations apply to all vertices");
+		}
+	}
+
+	// Mirroring sanitized 2D geometry must keep the winding of its outlines
+	void testMirrored2DWinding()
+	{
+		const auto poly = unitSquare();
+		const double area = signedArea(poly->outlines()[0]);
+		const TransformedGeometry mirrored(poly, scaling({-1, 1, 1}));
+
+		const auto flat = dynamic_pointer_cast<const Polygon2d>(mirrored.flatten());
+		check(flat && flat->outlines().size() == 1, "mirrored square stays one outline");
+		if (flat && flat->outlines().size() == 1) {
+			check(std::abs(signedArea(flat->outlines()[0]) - area) < 1e-9, "mirrored outline keeps its winding");
+		}
+	}
+
+	// Mirroring 3D geometry flips its polygons, so it doesn't end up inside out
+	void testMirrored3DWinding()
+	{
+		const TransformedGeometry mirrored(triangle(), scaling({1, 1, -1}));
+		const auto flat = dynamic_pointer_cast<const PolySet>(mirrored.flatten());
+		check(flat && flat->getIndices() == std::vector<int>({2, 1, 0}), "mirrored polygon is flipped");
+	}
+
+	// A singular matrix removes the object with a warning
+	void testSingular2D()
+	{
+		std::vector<std::string> messages;
+		set_print_capture(&messages);
+		const TransformedGeometry flattened(unitSquare(), scaling({0, 1, 1}));
+		const auto flat = flattened.flatten();
+		set_print_capture(nullptr);
+
+		check(flat && flat->isEmpty(), "singular 2D transformation removes the object");
+		check(messages.size() == 1 && messages[0].find("WARNING: Scaling a 2D object with 0") == 0,
+					"singular 2D transformation warns");
+	}
+
+	// Cache accounting includes the shared geometry
+	void testMemsize()
+	{
+		const auto ps = triangle();
+		const TransformedGeometry shared(ps, translation({1, 0, 0}));
+		check(shared.memsize() == sizeof(TransformedGeometry), "memsize excludes geometry owned elsewhere");
+		const TransformedGeometry owner(triangle(), translation({1, 0, 0}));
+		check(owner.memsize() == sizeof(TransformedGeometry) + ps->memsize(), "memsize includes geometry owned only by it");
+	}
+}
+
+int main()
+{
+	testNested3D();
+	testNested2D();
+	testMirrored2DWinding();
+	testMirrored3DWinding();
+	testSingular2D();
+	testMemsize();
+	return unittestResult();
+}
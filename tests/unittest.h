@@ -0,0 +1,32 @@
+#pragma once
+
+/*
+	Checks shared by the standalone unit tests, which don't use a test
+	framework: call check() for every condition, and return the result of
+	unittestResult() from main().
+*/
+
+#include <iostream>
+#include <string>
+
+namespace {
+	int unittestFailures = 0;
+
+	void check(bool ok, const std::string &what)
+	{
+		if (!ok) {
+			std::cerr << "FAILED: " << what << std::endl;
+			unittestFailures++;
+		}
+	}
+
+	int unittestResult()
+	{
+		if (unittestFailures) {
+			std::cerr << unittestFailures << " check(s) failed" << std::endl;
+			return 1;
+		}
+		std::cout << "All checks passed" << std::endl;
+		return 0;
+	}
+}
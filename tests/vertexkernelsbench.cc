@@ -0,0 +1,169 @@
+/*
+	Micro-benchmark for the vertex kernels used by PolySet and Polygon2d.
+	Reports the throughput of each implementation supported by this CPU in
+	vertices per second.
+
+	With --verify, checks that all implementations give bit-identical
+	results instead, on arrays of all sizes up to a few vectors.
+
+	Usage: vertexkernelsbench [--verify] [--vertices=<n>]
+*/
+
+#include "vertex-kernels.h"
+#include "grid.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using VertexKernels::Implementation;
+
+namespace {
+	const Implementation implementations[] = { Implementation::SCALAR, Implementation::AVX2 };
+
+	Transform3d randomTransform3d(std::mt19937 &rng)
+	{
+		std::uniform_real_distribution<double> angle(-M_PI, M_PI), offset(-100, 100);
+		return Transform3d(Eigen::Translation3d(offset(rng), offset(rng), offset(rng)) *
+			Eigen::AngleAxisd(angle(rng), Vector3d(1, 2, 3).normalized()) * Eigen::Scaling(1.5, 0.5, 2.0));
+	}
+
+	Transform2d randomTransform2d(std::mt19937 &rng)
+	{
+		std::uniform_real_distribution<double> angle(-M_PI, M_PI), offset(-100, 100);
+		return Transform2d(Eigen::Translation2d(offset(rng), offset(rng)) * Eigen::Rotation2Dd(angle(rng)) * Eigen::Scaling(1.5, 0.5));
+	}
+
+	std::vector<Vector3d> randomVertices3d(std::mt19937 &rng, size_t n)
+	{
+		std::uniform_real_distribution<double> coord(-1000, 1000);
+		std::vector<Vector3d> vertices(n);
+		for (auto &v : vertices) v = Vector3d(coord(rng), coord(rng), coord(rng));
+		return vertices;
+	}
+
+	std::vector<Vector2d> randomVertices2d(std::mt19937 &rng, size_t n)
+	{
+		std::uniform_real_distribution<double> coord(-1000, 1000);
+		std::vector<Vector2d> vertices(n);
+		for (auto &v : vertices) v = Vector2d(coord(rng), coord(rng));
+		return vertices;
+	}
+
+	// Runs f repeatedly for about half a second, returning the vertices processed per second
+	double throughput(size_t n, const std::function<void()> &f)
+	{
+		typedef std::chrono::steady_clock clock;
+		const auto start = clock::now();
+		size_t runs = 0;
+		std::chrono::duration<double> elapsed;
+		do {
+			f();
+			runs++;
+			elapsed = clock::now() - start;
+		} while (elapsed.count() < 0.5);
+		return runs * n / elapsed.count();
+	}
+
+	int verify()
+	{
+		int failures = 0;
+		std::mt19937 rng(42);
+		for (size_t n = 0; n <= 33; n++) {
+			const auto m3 = randomTransform3d(rng);
+			const auto m2 = randomTransform2d(rng);
+			const auto in3 = randomVertices3d(rng, n);
+			const auto in2 = randomVertices2d(rng, n);
+			// Include negative zero and coordinates whose keys need more than 51 bit
+			auto keyin = in3;
+			if (n > 2) keyin[n/2] *= 1e12;
+			if (n > 3) keyin[n/3][1] = -0.0;
+
+			std::vector<Vector3d> ref3;
+			std::vector<Vector2d> ref2;
+			std::vector<Vector3l> refkeys;
+			for (const auto impl : implementations) {
+				if (!VertexKernels::setImplementation(impl)) continue;
+				auto out3 = in3;
+				auto out2 = in2;
+				std::vector<Vector3l> keys(n);
+				VertexKernels::transform(out3.data(), n, m3);
+				VertexKernels::transform(out2.data(), n, m2);
+				VertexKernels::gridKeys(keyin.data(), n, GRID_FINE, keys.data());
+				if (impl == Implementation::SCALAR) {
+					ref3 = out3;
+					ref2 = out2;
+					refkeys = keys;
+					continue;
+				}
+				const char *name = VertexKernels::implementationName(impl);
+				if (out3 != ref3) {
+					std::cerr << "FAILED: " << name << " 3D transform differs for " << n << " vertices" << std::endl;
+					failures++;
+				}
+				if (out2 != ref2) {
+					std::cerr << "FAILED: " << name << " 2D transform differs for " << n << " vertices" << std::endl;
+					failures++;
+				}
+				if (keys != refkeys) {
+					std::cerr << "FAILED: " << name << " grid keys differ for " << n << " vertices" << std::endl;
+					failures++;
+				}
+			}
+		}
+		if (failures) return 1;
+		std::cout << "All vertex kernel implementations agree" << std::endl;
+		return 0;
+	}
+
+	void benchmark(size_t n)
+	{
+		std::mt19937 rng(42);
+		const auto m3 = randomTransform3d(rng);
+		const auto m2 = randomTransform2d(rng);
+		auto vertices3d = randomVertices3d(rng, n);
+		auto vertices2d = randomVertices2d(rng, n);
+		std::vector<Vector3l> keys(n);
+
+		std::cout << n << " vertices, Mvertices/s:" << std::endl;
+		for (const auto impl : implementations) {
+			if (!VertexKernels::setImplementation(impl)) continue;
+			// Alternate between a transformation and its inverse to keep the values bounded
+			const auto inv3 = m3.inverse();
+			const auto inv2 = m2.inverse();
+			bool inverse = false;
+			const double t3 = throughput(n, [&]() {
+				VertexKernels::transform(vertices3d.data(), n, (inverse = !inverse) ? m3 : inv3);
+			});
+			const double t2 = throughput(n, [&]() {
+				VertexKernels::transform(vertices2d.data(), n, (inverse = !inverse) ? m2 : inv2);
+			});
+			const double tk = throughput(n, [&]() {
+				VertexKernels::gridKeys(vertices3d.data(), n, GRID_FINE, keys.data());
+			});
+			std::cout << "  " << VertexKernels::implementationName(impl) << ":"
+								<< " transform3d " << t3 / 1e6
+								<< ", transform2d " << t2 / 1e6
+								<< ", gridkeys " << tk / 1e6 << std::endl;
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	size_t n = 1000000;
+	for (int i = 1; i < argc; i++) {
+		if (!std::strcmp(argv[i], "--verify")) return verify();
+		if (!std::strncmp(argv[i], "--vertices=", 11)) n = std::strtoul(argv[i] + 11, nullptr, 10);
+		else {
+			std::cerr << "Usage: " << argv[0] << " [--verify] [--vertices=<n>]" << std::endl;
+			return 1;
+		}
+	}
+	benchmark(n);
+	return 0;
+}